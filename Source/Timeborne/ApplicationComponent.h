@@ -55,6 +55,7 @@ struct ComponentRenderContext
 struct ComponentPostUpdateContext : EngineBuildingBlocks::PostUpdateContext
 {
 	MainApplication* Application;
+	Core::ThreadPool* ThreadPool;
 
 	const EngineBuildingBlocks::PathHandler* PathHandler;
 	HWND WindowHandle;
@@ -0,0 +1,170 @@
+// Timeborne/DataStructures/MappableVector.h
+
+#pragma once
+
+#include <Timeborne/Misc/MappedFile.h>
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+#include <Core/SimpleBinarySerialization.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// The elements of the mappable vectors are serialized to this alignment, relative to the start of the serialized data.
+constexpr size_t c_MappableVectorAlignment = 64;
+
+struct MappableDataSource
+{
+	// The start of the serialized data, which the alignment is relative to.
+	const unsigned char* Start;
+
+	// If set, the deserialized vectors are views into this file, otherwise the data is copied.
+	std::shared_ptr<const MappedFile> File;
+};
+
+// Simple type vector which is either owning its elements or a read-only view into a mapped file. A view keeps the
+// mapping alive and is copied into owned storage on the first modifying access, so the mapped data is never written.
+template <typename T>
+class MappableVector
+{
+	Core::SimpleTypeVectorU<T> m_Vector;
+
+	const T* m_MappedData = nullptr;
+	unsigned m_MappedSize = 0;
+	std::shared_ptr<const MappedFile> m_MappedFile;
+
+	void ResetMapping()
+	{
+		m_MappedData = nullptr;
+		m_MappedSize = 0;
+		m_MappedFile.reset();
+	}
+
+	static size_t GetAlignedOffset(size_t offset)
+	{
+		return (offset + c_MappableVectorAlignment - 1) / c_MappableVectorAlignment * c_MappableVectorAlignment;
+	}
+
+public:
+
+	bool IsMapped() const
+	{
+		return (m_MappedFile != nullptr);
+	}
+
+	void CopyMappedData()
+	{
+		if (!IsMapped()) return;
+		m_Vector.Clear();
+		m_Vector.Resize(m_MappedSize);
+		if (m_MappedSize > 0) std::memcpy(m_Vector.GetArray(), m_MappedData, m_MappedSize * sizeof(T));
+		ResetMapping();
+	}
+
+	unsigned GetSize() const
+	{
+		return IsMapped() ? m_MappedSize : m_Vector.GetSize();
+	}
+
+	bool IsEmpty() const
+	{
+		return (GetSize() == 0);
+	}
+
+	const T* GetArray() const
+	{
+		return IsMapped() ? m_MappedData : m_Vector.GetArray();
+	}
+
+	T* GetArray()
+	{
+		CopyMappedData();
+		return m_Vector.GetArray();
+	}
+
+	const T& operator[](unsigned index) const
+	{
+		return GetArray()[index];
+	}
+
+	T& operator[](unsigned index)
+	{
+		CopyMappedData();
+		return m_Vector[index];
+	}
+
+	void Clear()
+	{
+		ResetMapping();
+		m_Vector.Clear();
+	}
+
+	void Resize(unsigned size)
+	{
+		CopyMappedData();
+		m_Vector.Resize(size);
+	}
+
+	void SetByte(unsigned char value)
+	{
+		CopyMappedData();
+		m_Vector.SetByte(value);
+	}
+
+	void PushBack(const T& element)
+	{
+		CopyMappedData();
+		m_Vector.PushBack(element);
+	}
+
+	void PushBack(const T& element, unsigned count)
+	{
+		CopyMappedData();
+		m_Vector.PushBack(element, count);
+	}
+
+	// Format: element count, padding to the alignment, raw elements.
+	void SerializeSB(Core::ByteVector& bytes) const
+	{
+		auto size = GetSize();
+		Core::SerializeSB(bytes, (uint64_t)size);
+
+		size_t offset = bytes.GetSize();
+		size_t alignedOffset = GetAlignedOffset(offset);
+		size_t dataSize = size * sizeof(T);
+		bytes.Resize((unsigned)(alignedOffset + dataSize));
+		std::memset(bytes.GetArray() + offset, 0, alignedOffset - offset);
+		if (dataSize > 0) std::memcpy(bytes.GetArray() + alignedOffset, GetArray(), dataSize);
+	}
+
+	void DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source)
+	{
+		uint64_t size;
+		Core::DeserializeSB(bytes, size);
+
+		bytes = source.Start + GetAlignedOffset((size_t)(bytes - source.Start));
+		auto data = reinterpret_cast<const T*>(bytes);
+		bytes += (size_t)size * sizeof(T);
+
+		Clear();
+		if (source.File != nullptr)
+		{
+			m_MappedData = data;
+			m_MappedSize = (unsigned)size;
+			m_MappedFile = source.File;
+		}
+		else
+		{
+			m_Vector.Resize((unsigned)size);
+			if (size > 0) std::memcpy(m_Vector.GetArray(), data, (size_t)size * sizeof(T));
+		}
+	}
+
+	// Reads the element-wise simple type vector serialization of the earlier level file versions.
+	void DeserializeLegacySB(const unsigned char*& bytes)
+	{
+		Clear();
+		Core::DeserializeSB(bytes, m_Vector);
+	}
+};
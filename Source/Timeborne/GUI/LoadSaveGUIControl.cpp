@@ -72,7 +72,8 @@ void SaveGameGUIControl::OnScreenEnter(const EngineBuildingBlocks::PathHandler&
 	// Setting the pointers must be done AFTER filling the string vector.
 	UpdateStringPtrVector();
 
-	m_SaveGameTextbox.SetText(noSaveFile ? "TestSave" : m_SaveFileStrs[0]);
+	if (!m_LastSavedFileName.empty()) m_SaveGameTextbox.SetText(m_LastSavedFileName.c_str());
+	else m_SaveGameTextbox.SetText(noSaveFile ? "TestSave" : m_SaveFileStrs[0]);
 	m_PreviousSaveGameStr = m_SaveGameTextbox.GetText();
 }
 
@@ -112,7 +113,12 @@ SaveGameGUIControl::Action SaveGameGUIControl::Render(nk_context* ctx)
 	}
 
 	nk_layout_row_dynamic(ctx, c_ButtonSize.y, 2);
-	if (nk_button_label(ctx, "Save")) result = Action::Save;
+	if (m_IsSaving)
+	{
+		nk_label(ctx, "Saving...", NK_TEXT_CENTERED);
+		if (result == Action::Save) result = Action::NoAction;
+	}
+	else if (nk_button_label(ctx, "Save")) result = Action::Save;
 	if (nk_button_label(ctx, "Exit")) result = Action::Exit;
 
 	return result;
@@ -123,6 +129,17 @@ std::string SaveGameGUIControl::GetFileName() const
 	return m_SaveGameTextbox.GetText().c_str();
 }
 
+void SaveGameGUIControl::OnSaveStarted()
+{
+	m_IsSaving = true;
+}
+
+void SaveGameGUIControl::OnSaveCompleted(const std::string& fileName, bool success)
+{
+	m_IsSaving = false;
+	if (success) m_LastSavedFileName = fileName;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 LoadGameGUIControl::LoadGameGUIControl(bool hasExitButton, const char* loadText, int itemWidth)
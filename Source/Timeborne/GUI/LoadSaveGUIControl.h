@@ -36,6 +36,10 @@ class SaveGameGUIControl : public _Detail::LoadSaveGuiControlBase
 	std::string m_PreviousSaveGameStr;
 	Nuklear_TextBox m_SaveGameTextbox;
 
+	// The saves are written in the background.
+	bool m_IsSaving = false;
+	std::string m_LastSavedFileName;
+
 public:
 
 	enum class Action { NoAction, Save, Exit };
@@ -49,6 +53,9 @@ public:
 	void OnScreenEnter(const EngineBuildingBlocks::PathHandler& pathHandler);
 
 	std::string GetFileName() const;
+
+	void OnSaveStarted();
+	void OnSaveCompleted(const std::string& fileName, bool success);
 };
 
 class LoadGameGUIControl : public _Detail::LoadSaveGuiControlBase
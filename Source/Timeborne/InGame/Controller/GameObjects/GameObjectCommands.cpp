@@ -7,6 +7,7 @@
 #include <Timeborne/InGame/GameState/LocalGameState.h>
 #include <Timeborne/InGame/GameState/ServerGameState.h>
 #include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h>
 #include <Timeborne/InputHandling.h>
 #include <Timeborne/MainApplication.h>
 
@@ -36,7 +37,7 @@ GameObjectCommands::GameObjectCommands(const Level& level, const GameCreationDat
 {
 	InitializeInput(application);
 
-	gameState.GetGameObjects().AddExistenceListenerOnce(*this);
+	gameState.AddChangeListenerOnce(*this);
 }
 
 GameObjectCommands::~GameObjectCommands()
@@ -170,7 +171,7 @@ void GameObjectCommands::PreUpdate(const ComponentPreUpdateContext& context)
 				else
 				{
 					auto tIntersection = GetTerrainBlockIntersection(&m_Camera, context.WindowSize,
-						context.ContentSize, m_Level.GetTerrain(), &m_Level.GetFieldHeightQuadtree(), glm::ivec2(1),
+						context.ContentSize, *m_Level.GetTerrainTree(), glm::ivec2(1),
 						input.Position);
 					if (tIntersection.HasIntersection)
 					{
@@ -251,9 +252,15 @@ bool GameObjectCommands::IsSourceControllable() const
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void GameObjectCommands::OnGameObjectRemoved(GameObjectId objectId)
+void GameObjectCommands::OnGameObjectsChanged(const GameObjectChangeSet& changes)
 {
-	m_LocalGameState.GetControllerGameState().SourceGameObjectIds.RemoveFirst(objectId);
+	auto& sourceObjectIds = m_LocalGameState.GetControllerGameState().SourceGameObjectIds;
+
+	unsigned countRemoved = changes.RemovedIds.GetSize();
+	for (unsigned i = 0; i < countRemoved; i++)
+	{
+		sourceObjectIds.RemoveFirst(changes.RemovedIds[i]);
+	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
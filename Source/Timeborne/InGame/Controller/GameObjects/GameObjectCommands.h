@@ -19,7 +19,7 @@ class LocalGameState;
 class MainApplication;
 class ServerGameState;
 
-class GameObjectCommands : public GameObjectExistenceListener,
+class GameObjectCommands : public GameObjectChangeListener,
 	public GameObjectVisibilityListener
 {
 	const Level& m_Level;
@@ -94,10 +94,9 @@ public:
 
 	void PreUpdate(const ComponentPreUpdateContext& context);
 
-public: // GameObjectExistenceListener IF.
+public: // GameObjectChangeListener IF.
 
-	void OnGameObjectAdded(const GameObject& object) override {}
-	void OnGameObjectRemoved(GameObjectId objectId) override;
+	void OnGameObjectsChanged(const GameObjectChangeSet& changes) override;
 
 public: // GameObjectVisibilityListener IF.
 
@@ -4,6 +4,21 @@
 
 #include <Core/SimpleBinarySerialization.hpp>
 
+#include <cstring>
+
+void ClientGameStateSaveSnapshot::SerializeSB(Core::ByteVector& bytes) const
+{
+	Core::SerializeSB(bytes, CreationData);
+	Core::SerializeSB(bytes, ModelGameState);
+
+	auto offset = bytes.GetSize();
+	auto countLocalBytes = LocalGameStateBytes.GetSize();
+	bytes.Resize(offset + countLocalBytes);
+	std::memcpy(bytes.GetArray() + offset, LocalGameStateBytes.GetArray(), countLocalBytes);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 ClientGameState::ClientGameState()
 	: m_LocalGameState(m_ClientModelGameState)
 {
@@ -29,6 +44,16 @@ LocalGameState& ClientGameState::GetLocalGameState()
 	return m_LocalGameState;
 }
 
+bool ClientGameState::IsLockstep() const
+{
+	return m_IsLockstep;
+}
+
+void ClientGameState::SetLockstep(bool lockstep)
+{
+	m_IsLockstep = lockstep;
+}
+
 ServerGameState& ClientGameState::GetClientModelGameState()
 {
 	return m_ClientModelGameState;
@@ -36,23 +61,27 @@ ServerGameState& ClientGameState::GetClientModelGameState()
 
 ServerGameState& ClientGameState::GetSyncedGameState()
 {
-	// Optimization for single player mode: no need to synchronize the game state.
-	return m_GameCreationData.Players.IsMultiplayerGame() ? m_SyncedGameState : m_ClientModelGameState;
+	// Optimization for single player and lockstep mode: no need to synchronize the game state.
+	bool isSynced = m_GameCreationData.Players.IsMultiplayerGame() && !m_IsLockstep;
+	return isSynced ? m_SyncedGameState : m_ClientModelGameState;
 }
 
 void ClientGameState::Sync()
 {
-	if (m_GameCreationData.Players.IsMultiplayerGame())
+	if (m_GameCreationData.Players.IsMultiplayerGame() && !m_IsLockstep)
 	{
-		// @todo: implement synchronization. Elements must be added one by one to notify listeners.
+		// @todo: implement synchronization. The changes must be applied element by element and flushed to notify
+		// the listeners.
 	}
 }
 
-void ClientGameState::SerializeForSave(Core::ByteVector& bytes)
+std::unique_ptr<ClientGameStateSaveSnapshot> ClientGameState::CreateSaveSnapshot() const
 {
-	Core::SerializeSB(bytes, m_GameCreationData);
-	Core::SerializeSB(bytes, m_ClientModelGameState);
-	Core::SerializeSB(bytes, m_LocalGameState);
+	auto snapshot = std::make_unique<ClientGameStateSaveSnapshot>();
+	snapshot->CreationData = m_GameCreationData;
+	snapshot->ModelGameState.CopyStateFrom(m_ClientModelGameState);
+	Core::SerializeSB(snapshot->LocalGameStateBytes, m_LocalGameState);
+	return snapshot;
 }
 
 void ClientGameState::DeserializeForLoad(const Core::ByteVector& bytes)
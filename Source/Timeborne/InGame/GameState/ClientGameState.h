@@ -8,6 +8,21 @@
 
 #include <Core/DataStructures/SimpleTypeVector.hpp>
 
+#include <memory>
+
+// A copy of the saved data, which can be serialized in another thread while the game is running.
+struct ClientGameStateSaveSnapshot
+{
+	GameCreationData CreationData;
+	ServerGameState ModelGameState;
+
+	// The local game state is small, so it is serialized when the snapshot is created.
+	Core::ByteVector LocalGameStateBytes;
+
+	// The format is the same as the one of 'ClientGameState::DeserializeForLoad(...)'.
+	void SerializeSB(Core::ByteVector& bytes) const;
+};
+
 class ClientGameState
 {
 	GameCreationData m_GameCreationData;
@@ -31,6 +46,10 @@ class ClientGameState
 	// The LOCAL game state, which is only relevant for the view.
 	LocalGameState m_LocalGameState;
 
+	// In lockstep mode the commands of all players are simulated locally, e.g. when a replay is re-simulated, so no
+	// state synchronization is necessary.
+	bool m_IsLockstep = false;
+
 public:
 
 	ClientGameState();
@@ -39,6 +58,9 @@ public:
 	const GameCreationData& GetGameCreationData() const;
 	void SetGameCreationData(const GameCreationData& data);
 
+	bool IsLockstep() const;
+	void SetLockstep(bool lockstep);
+
 	ServerGameState& GetClientModelGameState();
 	ServerGameState& GetSyncedGameState();
 
@@ -46,6 +68,7 @@ public:
 
 	void Sync();
 
-	void SerializeForSave(Core::ByteVector& bytes);
+	// Only copies the data, so it's cheap enough to be done on the game thread.
+	std::unique_ptr<ClientGameStateSaveSnapshot> CreateSaveSnapshot() const;
 	void DeserializeForLoad(const Core::ByteVector& bytes);
 };
@@ -0,0 +1,200 @@
+// Timeborne/InGame/GameState/GameStateHash.cpp
+
+#include <Timeborne/InGame/GameState/GameStateHash.h>
+
+#include <Timeborne/InGame/GameState/ServerGameState.h>
+
+#include <Core/SimpleBinarySerialization.hpp>
+
+#include <cassert>
+
+// FNV-1a.
+static uint64_t HashBytes(const unsigned char* bytes, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+// The finalizer of SplitMix64. The element hashes are summed, so their bits must be well distributed.
+static uint64_t Mix(uint64_t value)
+{
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+	return value ^ (value >> 31);
+}
+
+const char* GameStateHash::GetPartName(Part part)
+{
+	switch (part)
+	{
+		case Part::GameObjects: return "GameObjects";
+		case Part::Routes: return "Routes";
+		case Part::Fight: return "Fight";
+		default: return "Unknown";
+	}
+}
+
+GameStateHash::ElementHashes& GameStateHash::AccessElementHashes(GameObjectId objectId)
+{
+	auto index = (uint32_t)objectId;
+	auto countElements = m_ElementHashes.GetSize();
+	if (index >= countElements)
+	{
+		m_ElementHashes.PushBack(ElementHashes{}, index + 1 - countElements);
+	}
+	return m_ElementHashes[index];
+}
+
+uint64_t GameStateHash::ComputeElementHash(const ServerGameState& state, GameObjectId objectId, Part part)
+{
+	m_TempBytes.Clear();
+	uint64_t pathHash = 0;
+	if (part == Part::Routes)
+	{
+		auto route = state.GetRoutes().GetRoute(objectId);
+		if (route == nullptr) return 0;
+
+		// The path is hashed by 'UpdateRoutePath'.
+		pathHash = AccessElementHashes(objectId).RoutePath;
+		Core::SerializeSB(m_TempBytes, route->NextFieldIndex);
+		Core::SerializeSB(m_TempBytes, Core::ToPlaceHolder(route->OrientationTarget));
+	}
+	else
+	{
+		const auto& gameObjects = state.GetGameObjects().Get();
+		auto gIt = gameObjects.find(objectId);
+		if (gIt == gameObjects.end()) return 0;
+		const auto& gameObject = gIt->second;
+
+		if (part == Part::GameObjects)
+		{
+			Core::SerializeSB(m_TempBytes, gameObject.Data);
+		}
+		else
+		{
+			assert(part == Part::Fight);
+			if (gameObject.FightIndex == Core::c_InvalidIndexU) return 0;
+			Core::SerializeSB(m_TempBytes, state.GetFightList()[gameObject.FightIndex]);
+		}
+	}
+
+	uint64_t seed = Mix(((uint64_t)(uint32_t)objectId << 8) | (uint64_t)part);
+	return Mix(HashBytes(m_TempBytes.GetArray(), m_TempBytes.GetSize(), seed ^ pathHash ^ 0xcbf29ce484222325ULL));
+}
+
+void GameStateHash::UpdateRoutePath(const ServerGameState& state, GameObjectId objectId)
+{
+	auto& pathHash = AccessElementHashes(objectId).RoutePath;
+
+	auto route = state.GetRoutes().GetRoute(objectId);
+	if (route == nullptr)
+	{
+		pathHash = 0;
+		return;
+	}
+
+	m_TempBytes.Clear();
+	Core::SerializeSB(m_TempBytes, route->Path);
+	pathHash = Mix(HashBytes(m_TempBytes.GetArray(), m_TempBytes.GetSize(), 0xcbf29ce484222325ULL));
+}
+
+void GameStateHash::UpdateElement(const ServerGameState& state, GameObjectId objectId, Part part)
+{
+	auto& elementHash = AccessElementHashes(objectId).Parts[(uint32_t)part];
+	auto newHash = ComputeElementHash(state, objectId, part);
+
+	// Wrapping arithmetic.
+	m_Breakdown.Parts[(uint32_t)part] += newHash - elementHash;
+	elementHash = newHash;
+}
+
+void GameStateHash::UpdateElements(const ServerGameState& state, const Core::SimpleTypeVectorU<GameObjectId>& objectIds,
+	Part part)
+{
+	unsigned countIds = objectIds.GetSize();
+	for (unsigned i = 0; i < countIds; i++)
+	{
+		UpdateElement(state, objectIds[i], part);
+	}
+}
+
+bool GameStateHash::IsValid() const
+{
+	return m_IsValid;
+}
+
+void GameStateHash::Invalidate()
+{
+	m_IsValid = false;
+}
+
+void GameStateHash::Rebuild(const ServerGameState& state)
+{
+	m_ElementHashes.Clear();
+	m_Breakdown = {};
+
+	for (const auto& gameObject : state.GetGameObjects().Get())
+	{
+		UpdateElement(state, gameObject.first, Part::GameObjects);
+		UpdateElement(state, gameObject.first, Part::Fight);
+	}
+
+	auto& routes = state.GetRoutes().GetRoutes().GetElements();
+	auto rEnd = routes.GetEndConstIterator();
+	for (auto rIt = routes.GetBeginConstIterator(); rIt != rEnd; ++rIt)
+	{
+		UpdateRoutePath(state, rIt->Key);
+		UpdateElement(state, rIt->Key, Part::Routes);
+	}
+
+	m_IsValid = true;
+}
+
+void GameStateHash::Update(const ServerGameState& state, const GameObjectChangeSet& changes,
+	const Core::SimpleTypeVectorU<GameObjectId>& accessedRouteIds)
+{
+	if (!m_IsValid)
+	{
+		Rebuild(state);
+		return;
+	}
+
+	// The route changes contain the added routes, whose path must be hashed before their elements are updated.
+	unsigned countRouteChangedIds = changes.RouteChangedIds.GetSize();
+	for (unsigned i = 0; i < countRouteChangedIds; i++)
+	{
+		UpdateRoutePath(state, changes.RouteChangedIds[i]);
+	}
+
+	// The element hashes are computed from the current state, so updating an element multiple times is harmless.
+	for (uint32_t i = 0; i < c_CountParts; i++)
+	{
+		UpdateElements(state, changes.RemovedIds, (Part)i);
+		UpdateElements(state, changes.AddedIds, (Part)i);
+	}
+	UpdateElements(state, changes.MovedIds, Part::GameObjects);
+	UpdateElements(state, changes.FightStateChangedIds, Part::Fight);
+	UpdateElements(state, changes.RouteChangedIds, Part::Routes);
+	UpdateElements(state, accessedRouteIds, Part::Routes);
+}
+
+const GameStateHash::Breakdown& GameStateHash::GetBreakdown() const
+{
+	return m_Breakdown;
+}
+
+uint64_t GameStateHash::GetHash(uint32_t tickCount, bool gameEnded) const
+{
+	assert(m_IsValid);
+
+	uint64_t hash = Mix(((uint64_t)tickCount << 1) | (gameEnded ? 1 : 0));
+	for (uint32_t i = 0; i < c_CountParts; i++)
+	{
+		hash = Mix(hash ^ m_Breakdown.Parts[i]);
+	}
+	return hash;
+}
@@ -0,0 +1,81 @@
+// Timeborne/InGame/GameState/GameStateHash.h
+
+#pragma once
+
+#include <Timeborne/InGame/Model/GameObjects/GameObjectId.h>
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+
+#include <cstdint>
+
+struct GameObjectChangeSet;
+class ServerGameState;
+
+// 64-bit hash of the server game state for the desync detection, that is updated from the per-tick changes instead of
+// hashing the whole serialized state.
+//
+// The hash of a part is the sum of the hashes of its elements: an element's contribution can be replaced without
+// touching the other elements and the result doesn't depend on the order of the changes. The element hashes include
+// the object id. The fight indices are local to the state, therefore the fight data is hashed per object.
+// The path of a route doesn't change after it was published, so it's only hashed when the route is added: accessing
+// the route only rehashes its progress.
+class GameStateHash
+{
+public:
+
+	enum class Part : uint32_t
+	{
+		GameObjects, // Ids, players, types and poses.
+		Routes,
+		Fight,
+		COUNT
+	};
+
+	static constexpr uint32_t c_CountParts = (uint32_t)Part::COUNT;
+
+	static const char* GetPartName(Part part);
+
+	struct Breakdown
+	{
+		uint64_t Parts[c_CountParts];
+	};
+
+private:
+
+	struct ElementHashes
+	{
+		uint64_t Parts[c_CountParts];
+		uint64_t RoutePath;
+	};
+
+	// Indexed by the game object id. The game object ids are never reused.
+	Core::SimpleTypeVectorU<ElementHashes> m_ElementHashes;
+
+	Breakdown m_Breakdown{};
+	bool m_IsValid = false;
+
+	Core::ByteVector m_TempBytes;
+
+	ElementHashes& AccessElementHashes(GameObjectId objectId);
+
+	uint64_t ComputeElementHash(const ServerGameState& state, GameObjectId objectId, Part part);
+	void UpdateRoutePath(const ServerGameState& state, GameObjectId objectId);
+	void UpdateElement(const ServerGameState& state, GameObjectId objectId, Part part);
+	void UpdateElements(const ServerGameState& state, const Core::SimpleTypeVectorU<GameObjectId>& objectIds,
+		Part part);
+
+public:
+
+	bool IsValid() const;
+
+	// The hash must be rebuilt after the state was changed without recording the changes, e.g. by deserialization.
+	void Invalidate();
+	void Rebuild(const ServerGameState& state);
+
+	// The accessed route ids contain the routes that were changed without adding or removing them.
+	void Update(const ServerGameState& state, const GameObjectChangeSet& changes,
+		const Core::SimpleTypeVectorU<GameObjectId>& accessedRouteIds);
+
+	const Breakdown& GetBreakdown() const;
+	uint64_t GetHash(uint32_t tickCount, bool gameEnded) const;
+};
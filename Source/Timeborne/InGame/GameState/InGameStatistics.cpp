@@ -28,7 +28,7 @@ void InGameStatistics::PlayerData::DeserializeSB(const unsigned char*& bytes)
 
 InGameStatistics::InGameStatistics(ServerGameState& modelGameState)
 {
-	modelGameState.GetGameObjects().AddFightListenerOnce(*this);
+	modelGameState.AddChangeListenerOnce(*this);
 }
 
 InGameStatistics::~InGameStatistics()
@@ -51,21 +51,28 @@ const std::vector<InGameStatistics::PlayerData>& InGameStatistics::GetPlayerData
 	return m_PlayerData;
 }
 
-void InGameStatistics::OnGameObjectDestroyed(const GameObject& sourceObject, const GameObject& targetObject)
+void InGameStatistics::OnGameObjectsChanged(const GameObjectChangeSet& changes)
 {
-	auto sourcePlayer = sourceObject.Data.PlayerIndex;
-	auto targetPlayer = targetObject.Data.PlayerIndex;
-	if (sourcePlayer == Core::c_InvalidIndexU || targetPlayer == Core::c_InvalidIndexU) return;
+	auto& prototypes = GameObjectPrototype::GetPrototypes();
 
-	auto type = GameObjectPrototype::GetPrototypes()[(uint32_t)targetObject.Data.TypeIndex]->GetType();
-
-	if (type == GameObjectPrototype::Type::Unit)
-	{
-		m_PlayerData[sourcePlayer].DestroyedUnits[targetPlayer]++;
-	}
-	else if (type == GameObjectPrototype::Type::Building)
+	unsigned countDestructions = changes.Destructions.GetSize();
+	for (unsigned i = 0; i < countDestructions; i++)
 	{
-		m_PlayerData[sourcePlayer].DestroyedBuildings[targetPlayer]++;
+		const auto& destruction = changes.Destructions[i];
+		auto sourcePlayer = destruction.SourcePlayerIndex;
+		auto targetPlayer = destruction.TargetPlayerIndex;
+		if (sourcePlayer == Core::c_InvalidIndexU || targetPlayer == Core::c_InvalidIndexU) continue;
+
+		auto type = prototypes[(uint32_t)destruction.TargetTypeIndex]->GetType();
+
+		if (type == GameObjectPrototype::Type::Unit)
+		{
+			m_PlayerData[sourcePlayer].DestroyedUnits[targetPlayer]++;
+		}
+		else if (type == GameObjectPrototype::Type::Building)
+		{
+			m_PlayerData[sourcePlayer].DestroyedBuildings[targetPlayer]++;
+		}
 	}
 }
 
@@ -12,7 +12,7 @@
 struct GameCreationData;
 class ServerGameState;
 
-class InGameStatistics : public GameObjectFightListener
+class InGameStatistics : public GameObjectChangeListener
 {
 public:
 
@@ -60,8 +60,7 @@ public:
 	void SerializeSB(Core::ByteVector& bytes) const;
 	void DeserializeSB(const unsigned char*& bytes);
 
-public: // GameObjectFightListener IF.
+public: // GameObjectChangeListener IF.
 
-	void OnGameObjectDestroyed(const GameObject& sourceObject, const GameObject& targetObject) override;
-	void OnGameObjectFightStateChanged(const GameObject& object, const GameObjectFightData& fightData) override {}
+	void OnGameObjectsChanged(const GameObjectChangeSet& changes) override;
 };
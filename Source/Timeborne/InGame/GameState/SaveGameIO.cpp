@@ -0,0 +1,127 @@
+// Timeborne/InGame/GameState/SaveGameIO.cpp
+
+#include <Timeborne/InGame/GameState/SaveGameIO.h>
+
+#include <Timeborne/InGame/GameState/ClientGameState.h>
+#include <Timeborne/Misc/Compression.h>
+#include <Timeborne/Logger.h>
+
+#include <Core/SimpleBinarySerialization.hpp>
+#include <Core/System/SimpleIO.h>
+
+#include <cassert>
+#include <chrono>
+
+// Compressed save file format: magic, uncompressed size, compressed data.
+constexpr uint32_t c_CompressedSaveFileMagic = 0x43534254; // "TBSC"
+constexpr size_t c_CompressedSaveFileHeaderSize = sizeof(uint32_t) + sizeof(uint64_t);
+
+SaveGameIO::SaveGameIO()
+{
+}
+
+SaveGameIO::~SaveGameIO()
+{
+	WaitForCompletion();
+}
+
+bool SaveGameIO::WriteSaveFile(const ClientGameStateSaveSnapshot& snapshot, const std::string& filePath)
+{
+	try
+	{
+		Core::ByteVector uncompressedBytes;
+		snapshot.SerializeSB(uncompressedBytes);
+
+		Core::ByteVector bytes;
+		Core::SerializeSB(bytes, c_CompressedSaveFileMagic);
+		Core::SerializeSB(bytes, (uint64_t)uncompressedBytes.GetSize());
+		CompressLZ(uncompressedBytes.GetArray(), uncompressedBytes.GetSize(), bytes);
+
+		Core::WriteAllBytes(filePath, bytes);
+		return true;
+	}
+	catch (const std::exception& ex)
+	{
+		Logger::Log([&](Logger::Stream& ss) { ss << "Failed to write the save file '" << filePath << "': "
+			<< ex.what(); }, LogSeverity::Error);
+		return false;
+	}
+}
+
+void SaveGameIO::Save(std::unique_ptr<ClientGameStateSaveSnapshot>&& snapshot, const std::string& filePath,
+	CompletionCallback callback)
+{
+	assert(snapshot != nullptr);
+
+	WaitForCompletion();
+
+	m_SaveTask = std::make_unique<SaveTask>();
+	m_SaveTask->Snapshot = std::move(snapshot);
+	m_SaveTask->FilePath = filePath;
+	m_SaveTask->Callback = std::move(callback);
+
+	// The snapshot is only read by the background thread.
+	auto snapshotPtr = m_SaveTask->Snapshot.get();
+	m_SaveTask->Result = std::async(std::launch::async, [snapshotPtr, filePath]() {
+		return WriteSaveFile(*snapshotPtr, filePath); });
+}
+
+bool SaveGameIO::IsSaving() const
+{
+	return (m_SaveTask != nullptr);
+}
+
+void SaveGameIO::FinishSaveTask()
+{
+	assert(m_SaveTask != nullptr);
+
+	bool success = m_SaveTask->Result.get();
+
+	// The task is moved out first, since the callback can start a new save. The snapshot is destroyed on the game
+	// thread, because the pool allocators of its containers are not thread-safe.
+	auto task = std::move(m_SaveTask);
+	if (task->Callback) task->Callback(task->FilePath, success);
+}
+
+void SaveGameIO::Update()
+{
+	if (m_SaveTask != nullptr
+		&& m_SaveTask->Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		FinishSaveTask();
+	}
+}
+
+void SaveGameIO::WaitForCompletion()
+{
+	if (m_SaveTask != nullptr)
+	{
+		FinishSaveTask();
+	}
+}
+
+bool SaveGameIO::ReadSaveFile(const std::string& filePath, Core::ByteVector& bytes)
+{
+	auto fileBytes = Core::ReadAllBytes(filePath);
+	auto fileSize = (size_t)fileBytes.GetSize();
+
+	uint32_t magic = 0;
+	auto byteArray = (const unsigned char*)fileBytes.GetArray();
+	if (fileSize >= c_CompressedSaveFileHeaderSize) Core::DeserializeSB(byteArray, magic);
+
+	if (magic != c_CompressedSaveFileMagic)
+	{
+		// Uncompressed save file.
+		bytes = std::move(fileBytes);
+		return true;
+	}
+
+	// The stored size is validated before the allocation.
+	uint64_t uncompressedSize;
+	Core::DeserializeSB(byteArray, uncompressedSize);
+	auto compressedSize = fileSize - c_CompressedSaveFileHeaderSize;
+	if (uncompressedSize > (uint64_t)GetMaxDecompressedSizeLZ(compressedSize)) return false;
+
+	bytes.Resize((size_t)uncompressedSize);
+	return DecompressLZ(byteArray, compressedSize, bytes.GetArray(), (size_t)uncompressedSize);
+}
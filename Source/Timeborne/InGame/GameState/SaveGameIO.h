@@ -0,0 +1,58 @@
+// Timeborne/InGame/GameState/SaveGameIO.h
+
+#pragma once
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+
+struct ClientGameStateSaveSnapshot;
+
+// Writes the save files in a background thread, so that the game keeps running while saving.
+//
+// The save files are compressed. The uncompressed save files of the earlier versions can be still loaded.
+class SaveGameIO
+{
+public:
+
+	using CompletionCallback = std::function<void(const std::string& filePath, bool success)>;
+
+private:
+
+	struct SaveTask
+	{
+		std::unique_ptr<ClientGameStateSaveSnapshot> Snapshot;
+		std::string FilePath;
+		CompletionCallback Callback;
+		std::future<bool> Result;
+	};
+
+	std::unique_ptr<SaveTask> m_SaveTask;
+
+	void FinishSaveTask();
+
+	static bool WriteSaveFile(const ClientGameStateSaveSnapshot& snapshot, const std::string& filePath);
+
+public:
+
+	SaveGameIO();
+	~SaveGameIO();
+
+	// Starts writing the snapshot. A running save is finished first.
+	void Save(std::unique_ptr<ClientGameStateSaveSnapshot>&& snapshot, const std::string& filePath,
+		CompletionCallback callback);
+
+	bool IsSaving() const;
+
+	// Calls the completion callback if the save has been finished. Must be called on the game thread.
+	void Update();
+
+	// Waits for the running save and calls its completion callback.
+	void WaitForCompletion();
+
+	// Returns false if the file cannot be read or is corrupted.
+	static bool ReadSaveFile(const std::string& filePath, Core::ByteVector& bytes);
+};
@@ -4,6 +4,8 @@
 
 #include <Core/SimpleBinarySerialization.hpp>
 
+#include <algorithm>
+
 uint32_t ServerGameState::GetTickCount() const
 {
 	return m_TickCount;
@@ -54,6 +56,16 @@ GameObjectFightList& ServerGameState::GetFightList()
 	return m_FightList;
 }
 
+void ServerGameState::CopyStateFrom(const ServerGameState& other)
+{
+	m_TickCount = other.m_TickCount;
+	m_GameEnded = other.m_GameEnded;
+	m_GameObjects.CopyStateFrom(other.m_GameObjects);
+	m_Routes.CopyStateFrom(other.m_Routes);
+	m_FightList = other.m_FightList;
+	m_Hash.Invalidate();
+}
+
 void ServerGameState::SerializeSB(Core::ByteVector& bytes) const
 {
 	Core::SerializeSB(bytes, m_TickCount);
@@ -70,6 +82,43 @@ void ServerGameState::DeserializeSB(const unsigned char*& bytes)
 	Core::DeserializeSB(bytes, m_GameObjects);
 	Core::DeserializeSB(bytes, m_Routes);
 	Core::DeserializeSB(bytes, m_FightList);
+	m_Hash.Invalidate();
+}
+
+uint64_t ServerGameState::ComputeChecksum() const
+{
+	Core::ByteVector bytes;
+	SerializeSB(bytes);
+
+	// FNV-1a.
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	auto data = bytes.GetArray();
+	auto size = bytes.GetSize();
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+uint64_t ServerGameState::GetStateHash() const
+{
+	if (!m_Hash.IsValid()) m_Hash.Rebuild(*this);
+	return m_Hash.GetHash(m_TickCount, m_GameEnded);
+}
+
+const GameStateHash::Breakdown& ServerGameState::GetStateHashBreakdown() const
+{
+	if (!m_Hash.IsValid()) m_Hash.Rebuild(*this);
+	return m_Hash.GetBreakdown();
+}
+
+bool ServerGameState::IsStateHashConsistent() const
+{
+	GameStateHash rebuiltHash;
+	rebuiltHash.Rebuild(*this);
+	return GetStateHash() == rebuiltHash.GetHash(m_TickCount, m_GameEnded);
 }
 
 void ServerGameState::NotifyListenersWithFullState()
@@ -77,3 +126,34 @@ void ServerGameState::NotifyListenersWithFullState()
 	m_GameObjects.NotifyListenersWithFullState();
 	m_Routes.NotifyListenersWithFullState();
 }
+
+void ServerGameState::AddChangeListenerOnce(GameObjectChangeListener& listener)
+{
+	if (std::find(m_ChangeListeners.begin(), m_ChangeListeners.end(), &listener) == m_ChangeListeners.end())
+	{
+		m_ChangeListeners.push_back(&listener);
+	}
+}
+
+void ServerGameState::FlushChanges()
+{
+	auto& changes = m_GameObjects.FinalizeChanges();
+	changes.RouteChangedIds = m_Routes.GetChangedIds();
+	changes.RouteChangedIds.SortAndRemoveDuplicates();
+
+	m_Hash.Update(*this, changes, m_Routes.GetAccessedIds());
+
+	if (!changes.IsEmpty())
+	{
+		for (auto listener : m_ChangeListeners)
+		{
+			listener->OnGameObjectsChanged(changes);
+		}
+	}
+
+	m_GameObjects.ClearChanges();
+	m_Routes.ClearChangedIds();
+
+	// No iteration is active between the ticks.
+	m_GameObjects.Compact();
+}
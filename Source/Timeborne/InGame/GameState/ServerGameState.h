@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <Timeborne/InGame/GameState/GameStateHash.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObject.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectFightData.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectRoute.h>
@@ -17,6 +18,11 @@ class ServerGameState
 	GameObjectRouteList m_Routes;
 	GameObjectFightList m_FightList;
 
+	std::vector<GameObjectChangeListener*> m_ChangeListeners;
+
+	// Updated with the changes upon flushing. Rebuilt on demand after the state is copied or deserialized.
+	mutable GameStateHash m_Hash;
+
 public:
 
 	uint32_t GetTickCount() const;
@@ -34,8 +40,28 @@ public:
 	const GameObjectFightList& GetFightList() const;
 	GameObjectFightList& GetFightList();
 
+	// Copies the state without notifying the listeners. The listeners are not copied.
+	void CopyStateFrom(const ServerGameState& other);
+
 	void SerializeSB(Core::ByteVector& bytes) const;
 	void DeserializeSB(const unsigned char*& bytes);
 
+	// Hash of the serialized state for the desync detection.
+	uint64_t ComputeChecksum() const;
+
+	// Incrementally maintained hash of the state for the per-tick desync detection. It's only up to date after
+	// flushing the changes. Note that it's not equal to the checksum.
+	uint64_t GetStateHash() const;
+	const GameStateHash::Breakdown& GetStateHashBreakdown() const;
+
+	// Compares the incrementally maintained hash with a rebuilt one. Intended for the debugging.
+	bool IsStateHashConsistent() const;
+
 	void NotifyListenersWithFullState();
+
+	void AddChangeListenerOnce(GameObjectChangeListener& listener);
+
+	// Notifies the change listeners with the changes since the last flush, then compacts the game objects. Called once
+	// per tick by the model.
+	void FlushChanges();
 };
@@ -6,24 +6,31 @@
 #include <Timeborne/InGame/Controller/InGameController.h>
 #include <Timeborne/InGame/GameCamera/GameCamera.h>
 #include <Timeborne/InGame/GameState/ClientGameState.h>
+#include <Timeborne/InGame/GameState/SaveGameIO.h>
 #include <Timeborne/InGame/Model/InGameModel.h>
 #include <Timeborne/InGame/Model/Level.h>
 #include <Timeborne/InGame/Model/TickContext.h>
+#include <Timeborne/InGame/Replay/Replay.h>
 #include <Timeborne/InGame/View/InGameView.h>
 #include <Timeborne/Logger.h>
 #include <Timeborne/MainApplication.h>
+#include <Timeborne/Profiler.h>
 
 #include <Core/System/Filesystem.h>
 #include <Core/System/SimpleIO.h>
 #include <EngineBuildingBlocks/Input/DefaultInputBinder.h>
 #include <EngineBuildingBlocks/SceneNode.h>
 
+#include <algorithm>
+#include <filesystem>
+
 using namespace EngineBuildingBlocks;
 using namespace EngineBuildingBlocks::Graphics;
 using namespace EngineBuildingBlocks::Input;
 using namespace EngineBuildingBlocks::Math;
 
 InGame::InGame()
+	: m_SaveGameIO(std::make_unique<SaveGameIO>())
 {
 	Reset();
 }
@@ -62,6 +69,8 @@ const InGameStatistics& InGame::GetStatistics() const
 
 void InGame::CheckGameEnded()
 {
+	ProfilerZone zone("CheckGameEnded");
+
 	assert(m_ClientGameState != nullptr);
 
 	// @todo: we will be able to use player data.
@@ -114,6 +123,8 @@ void InGame::Reset()
 	m_Camera.reset();
 	m_CommandList.reset();
 
+	m_ReplayRecorder.reset();
+
 	ResetGameUpdate();
 }
 
@@ -122,14 +133,14 @@ bool InGame::HasLevel(const char* levelName, const EngineBuildingBlocks::PathHan
 	return Core::FileExists(Level::GetPath(pathHandler, levelName));
 }
 
-void InGame::LoadLevel(const EngineBuildingBlocks::PathHandler& pathHandler)
+void InGame::LoadLevel(const EngineBuildingBlocks::PathHandler& pathHandler, Core::ThreadPool* threadPool)
 {
 	auto levelName = m_ClientGameState->GetGameCreationData().LevelName;
 	bool levelExists = HasLevel(levelName.c_str(), pathHandler);
 	if (levelExists)
 	{
 		m_Level = std::make_unique<Level>();
-		m_Level->Load(pathHandler, levelName, false);
+		m_Level->Load(pathHandler, levelName, false, threadPool);
 
 		Logger::Log([&](Logger::Stream& ss) { ss << "Level '" << levelName << "' has been loaded in InGame."; },
 			LogSeverity::Info);
@@ -162,11 +173,11 @@ void InGame::InitializeOnLoading(const ComponentRenderContext& context, bool loa
 
 	Reset();
 
-	LoadLevel(pathHandler);
+	LoadLevel(pathHandler, context.ThreadPool);
 
 	if (isRemappingPlayerIndices)
 	{
-		RemapPlayerIndices();
+		RemapPlayerIndices(m_ClientGameState->GetGameCreationData(), *m_Level);
 	}
 
 	CreateCamera(context, isLoadingFromSaveFile);
@@ -183,6 +194,12 @@ void InGame::InitializeOnLoading(const ComponentRenderContext& context, bool loa
 	// Creating the model.
 	m_Model = std::make_unique<InGameModel>(*m_Level, *m_ClientGameState, *m_CommandList, isLoadingFromSaveFile);
 
+	if (loadingFromLevel)
+	{
+		m_ReplayRecorder = std::make_unique<ReplayRecorder>(m_ClientGameState->GetGameCreationData(),
+			c_ReplayChecksumIntervalInTicks);
+	}
+
 	// Creating the controller.
 	m_Controller = std::make_unique<InGameController>(*m_Level, *m_ClientGameState, *m_CommandList,
 		m_View->GetGameObjectVisibilityProvider(), *m_Camera, *context.Application);
@@ -210,6 +227,7 @@ void InGame::InitializeRendering(const ComponentRenderContext& context)
 
 void InGame::DestroyMain()
 {
+	m_SaveGameIO->WaitForCompletion();
 }
 
 void InGame::DestroyRendering()
@@ -230,8 +248,10 @@ bool InGame::HandleEvent(const EngineBuildingBlocks::Event* _event)
 	return m_Controller->HandleEvent(_event);
 }
 
-void InGame::Tick()
+void InGame::Tick(Core::ThreadPool* threadPool)
 {
+	ProfilerZone zone("Tick");
+
 	assert(m_ClientGameState != nullptr);
 
 	auto& modelGameState = m_ClientGameState->GetClientModelGameState();
@@ -241,8 +261,16 @@ void InGame::Tick()
 	TickContext context;
 	context.UpdateIntervalInMillis = c_UpdateIntervalInMillis;
 	context.TickCount = tickCount;
+	context.ThreadPool = threadPool;
+	context.Timings = nullptr;
+	context.PathQueries = nullptr;
 
 	m_Model->Tick(context);
+
+	if (m_ReplayRecorder != nullptr)
+	{
+		m_ReplayRecorder->RecordTick(tickCount, *m_CommandList, m_Model->GetCommandListProcessor(), modelGameState);
+	}
 }
 
 void InGame::ResetGameUpdate()
@@ -251,12 +279,16 @@ void InGame::ResetGameUpdate()
 	m_NextUpdateTime = UpdateClock::time_point();
 	m_CountPauseSwitches = 0;
 	m_Paused = false;
+	m_TickInterpolationFactor = 1.0f;
 }
 
-void InGame::DoGameUpdate()
+void InGame::DoGameUpdate(Core::ThreadPool* threadPool)
 {
 	static constexpr int c_MaxUpdates = 10;
 
+	// Contains the catch-up ticks of the frame.
+	ProfilerZone zone("GameUpdate");
+
 	auto currentTime = UpdateClock::now();
 
 	auto ResetNextUpdateTime = [this, currentTime]() {
@@ -294,7 +326,7 @@ void InGame::DoGameUpdate()
 	bool ticked = false;
 	for (int i = 0; i < c_MaxUpdates && m_NextUpdateTime <= currentTime; i++)
 	{
-		Tick();
+		Tick(threadPool);
 		m_NextUpdateTime += std::chrono::milliseconds(c_UpdateIntervalInMillis);
 		ticked = true;
 	}
@@ -304,6 +336,8 @@ void InGame::DoGameUpdate()
 		CheckGameEnded();
 	}
 
+	UpdateTickInterpolationFactor(currentTime);
+
 	if (m_NextUpdateTime <= currentTime)
 	{
 		// Happens around 10 FPS.
@@ -311,6 +345,15 @@ void InGame::DoGameUpdate()
 	}
 }
 
+void InGame::UpdateTickInterpolationFactor(UpdateClock::time_point currentTime)
+{
+	// The last tick was due one interval before the next one. When the simulation is stalled or running slow,
+	// the latest poses are shown.
+	auto lastTickTime = m_NextUpdateTime - std::chrono::milliseconds(c_UpdateIntervalInMillis);
+	auto elapsedInMillis = std::chrono::duration<double, std::milli>(currentTime - lastTickTime).count();
+	m_TickInterpolationFactor = (float)std::min(std::max(elapsedInMillis / c_UpdateIntervalInMillis, 0.0), 1.0);
+}
+
 void InGame::DirectUpdate(double dt)
 {
 	m_Camera->Update(dt);
@@ -324,7 +367,9 @@ void InGame::PreUpdate(const ComponentPreUpdateContext& context)
 	m_Controller->PreUpdate(context);
 
 	// Updating the model.
-	DoGameUpdate();
+	DoGameUpdate(context.ThreadPool);
+
+	m_SaveGameIO->Update();
 
 	// Syncing currently here. When multiplayer mode is implemented, this should be done upon receiving
 	// the server game state.
@@ -332,6 +377,7 @@ void InGame::PreUpdate(const ComponentPreUpdateContext& context)
 
 	m_CameraSceneNodeHandler->UpdateTransformations();
 
+	m_View->SetTickInterpolationFactor(m_TickInterpolationFactor);
 	m_View->PreUpdate(context);
 }
 
@@ -357,6 +403,7 @@ void InGame::RenderGUI(const ComponentRenderContext& context)
 
 void InGame::SyncWithServerData()
 {
+	ProfilerZone zone("Sync");
 	m_ClientGameState->Sync();
 }
 
@@ -371,11 +418,9 @@ void InGame::CreateNewGame(const GameCreationData& data)
 	m_ClientGameState->SetGameCreationData(data);
 }
 
-void InGame::RemapPlayerIndices()
+void InGame::RemapPlayerIndices(const GameCreationData& data, Level& level)
 {
-	assert(m_ClientGameState != nullptr);
-
-	auto& players = m_ClientGameState->GetGameCreationData().Players;
+	auto& players = data.Players;
 
 	std::map<uint32_t, uint32_t> levelEditorToPlayerIndexMap;
 	uint32_t countPlayers = players.GetCountPlayers();
@@ -384,7 +429,7 @@ void InGame::RemapPlayerIndices()
 		levelEditorToPlayerIndexMap[players[i].LevelEditorIndex] = i;
 	}
 
-	auto& gameObjects = m_Level->GetGameObjects();
+	auto& gameObjects = level.GetGameObjects();
 	auto gEnd = gameObjects.GetEndIterator();
 	for (auto gIt = gameObjects.GetBeginIterator(); gIt != gEnd; ++gIt)
 	{
@@ -419,6 +464,9 @@ void InGame::LoadGameFromSaveFile(const ComponentRenderContext& context, bool cl
 	assert(context.Application != nullptr && context.Application->GetPathHandler() != nullptr);
 	auto& pathHandler = *context.Application->GetPathHandler();
 
+	// The file may be just written.
+	m_SaveGameIO->WaitForCompletion();
+
 	auto saveFilePath = GetSavePath(saveFileName, pathHandler);
 	if (!Core::FileExists(saveFilePath))
 	{
@@ -426,7 +474,12 @@ void InGame::LoadGameFromSaveFile(const ComponentRenderContext& context, bool cl
 		return;
 	}
 
-	auto bytes = Core::ReadAllBytes(saveFilePath);
+	Core::ByteVector bytes;
+	if (!SaveGameIO::ReadSaveFile(saveFilePath, bytes))
+	{
+		loadError = std::string("Save file '") + saveFileName + "' is corrupted.";
+		return;
+	}
 	auto newClientGameState = std::make_unique<ClientGameState>();
 	newClientGameState->DeserializeForLoad(bytes);
 
@@ -442,9 +495,28 @@ void InGame::LoadGameFromSaveFile(const ComponentRenderContext& context, bool cl
 	InitializeOnLoading(context, false);
 }
 
-void InGame::SaveGame(const char* saveFileName, const EngineBuildingBlocks::PathHandler& pathHandler) const
+void InGame::SaveGame(const char* saveFileName, const EngineBuildingBlocks::PathHandler& pathHandler,
+	std::function<void(bool success)> completionCallback)
 {
-	Core::ByteVector bytes;
-	m_ClientGameState->SerializeForSave(bytes);
-	Core::WriteAllBytes(GetSavePath(saveFileName, pathHandler), bytes);
+	// Only the snapshot is created on the game thread, it is serialized, compressed and written in the background.
+	m_SaveGameIO->Save(m_ClientGameState->CreateSaveSnapshot(), GetSavePath(saveFileName, pathHandler),
+		[completionCallback](const std::string& filePath, bool success) {
+		if (completionCallback) completionCallback(success);
+	});
+}
+
+void InGame::WaitForSaveCompletion()
+{
+	m_SaveGameIO->WaitForCompletion();
+}
+
+void InGame::SaveReplay(const EngineBuildingBlocks::PathHandler& pathHandler) const
+{
+	if (m_ReplayRecorder == nullptr) return;
+
+	auto replayPath = pathHandler.GetPathFromResourcesDirectory("Replays/LastGame.bin");
+	std::filesystem::create_directories(std::filesystem::path(replayPath).parent_path());
+	m_ReplayRecorder->GetReplay().Save(replayPath);
+
+	Logger::Log([&](Logger::Stream& ss) { ss << "Replay has been saved: " << replayPath; }, LogSeverity::Info);
 }
@@ -2,9 +2,11 @@
 
 #pragma once
 
+#include <Timeborne/Declarations/CoreDeclarations.h>
 #include <Timeborne/Declarations/EngineBuildingBlocksDeclarations.h>
 
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -22,6 +24,8 @@ class InGameModel;
 class InGameStatistics;
 class InGameView;
 class Level;
+class ReplayRecorder;
+class SaveGameIO;
 
 class InGame
 {
@@ -29,7 +33,7 @@ private: // Level data.
 
 	std::unique_ptr<Level> m_Level;
 
-	void LoadLevel(const EngineBuildingBlocks::PathHandler& pathHandler);
+	void LoadLevel(const EngineBuildingBlocks::PathHandler& pathHandler, Core::ThreadPool* threadPool);
 
 private: // Components.
 
@@ -41,6 +45,18 @@ private:
 
 	std::unique_ptr<CommandList> m_CommandList;
 
+private: // Replay.
+
+	// Only the games that have been started from a level are recorded.
+	std::unique_ptr<ReplayRecorder> m_ReplayRecorder;
+
+	static constexpr unsigned c_ReplayChecksumIntervalInTicks = 100;
+
+public:
+
+	// Writes the replay of the current game, if it is recorded.
+	void SaveReplay(const EngineBuildingBlocks::PathHandler& pathHandler) const;
+
 private: // Input.
 
 	unsigned m_PauseECI;
@@ -93,16 +109,23 @@ public: // Load, save.
 		bool clearState,
 		const char* saveFileName,
 		std::string& loadError);
+	// The save file is written in the background, the callback is called on the game thread.
 	void SaveGame(const char* saveFileName,
-		const EngineBuildingBlocks::PathHandler& pathHandler) const;
+		const EngineBuildingBlocks::PathHandler& pathHandler,
+		std::function<void(bool success)> completionCallback);
+	// Waits for the background save and calls its callback.
+	void WaitForSaveCompletion();
+
+	// Maps the level editor player indices of the level's game objects to the player indices of the game.
+	static void RemapPlayerIndices(const GameCreationData& data, Level& level);
 
 private:
 
+	std::unique_ptr<SaveGameIO> m_SaveGameIO;
+
 	std::string GetSavePath(const char* fileName,
 		const EngineBuildingBlocks::PathHandler& pathHandler) const;
 
-	void RemapPlayerIndices();
-
 	void InitializeOnLoading(const ComponentRenderContext& context,
 		bool loadingFromLevel);
 
@@ -124,10 +147,16 @@ private: // Game update.
 	int m_CountPauseSwitches = 0;
 	bool m_Paused = false;
 
+	// The elapsed fraction of the current tick, which is used by the view for interpolating between the ticks.
+	// Kept while paused.
+	float m_TickInterpolationFactor = 1.0f;
+
+	void UpdateTickInterpolationFactor(UpdateClock::time_point currentTime);
+
 	void ResetGameUpdate();
-	void DoGameUpdate();
+	void DoGameUpdate(Core::ThreadPool* threadPool);
 	void DirectUpdate(double dt);
-	void Tick();
+	void Tick(Core::ThreadPool* threadPool);
 
 private: // Game result.
 
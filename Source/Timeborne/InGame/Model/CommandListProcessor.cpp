@@ -71,13 +71,13 @@ unsigned CommandListProcessor::GetGameObjectCommandCost(const GameObjectCommand&
 	for (unsigned j = 0; j < countSources; j++)
 	{
 		auto objectId = command.SourceIds[j];
-		auto oIt = gameObjectsMap.find(objectId);
+		auto slotIndex = gameObjectsMap.GetSlotIndex(objectId);
 
 		// If the game object does not exist anymore, skipping it. Note that the object stays in the command.
-		if (oIt == gameObjectsMap.end()) continue;
+		if (slotIndex == Core::c_InvalidIndexU) continue;
 
-		const auto& object = oIt->second;
-		cost += prototypes[(uint32_t)object.Data.TypeIndex]->GetActionCost();
+		auto typeIndex = gameObjectsMap.GetTypeIndices()[slotIndex];
+		cost += prototypes[(uint32_t)typeIndex]->GetActionCost();
 	}
 	return cost;
 }
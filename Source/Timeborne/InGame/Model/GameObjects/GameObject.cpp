@@ -5,6 +5,7 @@
 #include <Core/Constants.h>
 #include <Core/SimpleBinarySerialization.hpp>
 
+#include <algorithm>
 #include <cassert>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -60,40 +61,219 @@ void AddListenerOnce(std::vector<T*>& listenerVector, T& listener)
 	}
 }
 
-void GameObjectList::AddExistenceListenerOnce(GameObjectExistenceListener& listener)
+GameObjectMap::const_iterator::const_iterator(const GameObjectMap* map, unsigned slotIndex)
+	: m_Map(map)
+	, m_SlotIndex(slotIndex)
 {
-	::AddListenerOnce(m_ExistenceListeners, listener);
+	SkipRemovedAndAssemble();
+}
+
+void GameObjectMap::const_iterator::SkipRemovedAndAssemble()
+{
+	auto& ids = m_Map->m_Ids;
+	auto countSlots = ids.GetSize();
+	while (m_SlotIndex < countSlots && ids[m_SlotIndex] == c_InvalidGameObjectId) ++m_SlotIndex;
+	if (m_SlotIndex < countSlots)
+	{
+		m_Value.first = ids[m_SlotIndex];
+		m_Map->AssembleObject(m_SlotIndex, m_Value.second);
+	}
+}
+
+GameObjectMap::const_iterator GameObjectMap::begin() const
+{
+	return const_iterator(this, 0);
+}
+
+GameObjectMap::const_iterator GameObjectMap::end() const
+{
+	return const_iterator(this, m_Ids.GetSize());
+}
+
+GameObjectMap::const_iterator GameObjectMap::find(GameObjectId id) const
+{
+	auto slotIndex = GetSlotIndex(id);
+	return (slotIndex == Core::c_InvalidIndexU) ? end() : const_iterator(this, slotIndex);
+}
+
+size_t GameObjectMap::size() const
+{
+	return m_CountObjects;
+}
+
+bool GameObjectMap::empty() const
+{
+	return m_CountObjects == 0;
+}
+
+void GameObjectMap::clear()
+{
+	m_Ids.Clear();
+	m_Poses.Clear();
+	m_FightIndices.Clear();
+	m_PlayerIndices.Clear();
+	m_TypeIndices.Clear();
+	m_IdToSlotIndex.Clear();
+	m_CountObjects = 0;
+}
+
+void GameObjectMap::Add(const GameObject& gameObject)
+{
+	auto idValue = (uint32_t)gameObject.Id;
+	assert(GetSlotIndex(gameObject.Id) == Core::c_InvalidIndexU);
+	assert(m_Ids.IsEmpty() || (uint32_t)m_Ids[m_Ids.GetSize() - 1] < idValue);
+
+	auto slotIndex = m_Ids.GetSize();
+	m_Ids.PushBack(gameObject.Id);
+	m_Poses.PushBack(gameObject.Data.Pose);
+	m_FightIndices.PushBack(gameObject.FightIndex);
+	m_PlayerIndices.PushBack(gameObject.Data.PlayerIndex);
+	m_TypeIndices.PushBack(gameObject.Data.TypeIndex);
+
+	if (idValue >= m_IdToSlotIndex.GetSize())
+	{
+		m_IdToSlotIndex.PushBack(Core::c_InvalidIndexU, idValue + 1 - m_IdToSlotIndex.GetSize());
+	}
+	m_IdToSlotIndex[idValue] = slotIndex;
+
+	m_CountObjects++;
+}
+
+void GameObjectMap::Remove(GameObjectId id)
+{
+	auto slotIndex = GetSlotIndex(id);
+	assert(slotIndex != Core::c_InvalidIndexU);
+
+	m_Ids[slotIndex] = c_InvalidGameObjectId;
+	m_IdToSlotIndex[(uint32_t)id] = Core::c_InvalidIndexU;
+	m_CountObjects--;
+}
+
+void GameObjectMap::Compact()
+{
+	auto countSlots = m_Ids.GetSize();
+	auto countRemovedSlots = countSlots - m_CountObjects;
+	if (countRemovedSlots <= 64 || countRemovedSlots <= m_CountObjects) return;
+
+	unsigned targetIndex = 0;
+	for (unsigned i = 0; i < countSlots; i++)
+	{
+		auto id = m_Ids[i];
+		if (id == c_InvalidGameObjectId) continue;
+		m_IdToSlotIndex[(uint32_t)id] = targetIndex;
+		if (i != targetIndex)
+		{
+			m_Ids[targetIndex] = id;
+			m_Poses[targetIndex] = m_Poses[i];
+			m_FightIndices[targetIndex] = m_FightIndices[i];
+			m_PlayerIndices[targetIndex] = m_PlayerIndices[i];
+			m_TypeIndices[targetIndex] = m_TypeIndices[i];
+		}
+		targetIndex++;
+	}
+	m_Ids.Resize(targetIndex);
+	m_Poses.Resize(targetIndex);
+	m_FightIndices.Resize(targetIndex);
+	m_PlayerIndices.Resize(targetIndex);
+	m_TypeIndices.Resize(targetIndex);
+}
+
+unsigned GameObjectMap::GetSlotIndex(GameObjectId id) const
+{
+	auto idValue = (uint32_t)id;
+	return (idValue < m_IdToSlotIndex.GetSize()) ? m_IdToSlotIndex[idValue] : Core::c_InvalidIndexU;
+}
+
+unsigned GameObjectMap::GetCountSlots() const
+{
+	return m_Ids.GetSize();
+}
+
+const Core::SimpleTypeVectorU<GameObjectId>& GameObjectMap::GetIds() const
+{
+	return m_Ids;
 }
 
-void GameObjectList::AddPoseListenerOnce(GameObjectPoseListener& listener)
+const Core::SimpleTypeVectorU<GameObjectPose>& GameObjectMap::GetPoses() const
 {
-	::AddListenerOnce(m_PoseListeners, listener);
+	return m_Poses;
 }
 
-void GameObjectList::AddFightListenerOnce(GameObjectFightListener& listener)
+const Core::IndexVectorU& GameObjectMap::GetFightIndices() const
 {
-	::AddListenerOnce(m_FightListeners, listener);
+	return m_FightIndices;
+}
+
+const Core::IndexVectorU& GameObjectMap::GetPlayerIndices() const
+{
+	return m_PlayerIndices;
+}
+
+const Core::SimpleTypeVectorU<GameObjectTypeIndex>& GameObjectMap::GetTypeIndices() const
+{
+	return m_TypeIndices;
+}
+
+void GameObjectMap::AssembleObject(unsigned slotIndex, GameObject& gameObject) const
+{
+	gameObject.Id = m_Ids[slotIndex];
+	gameObject.Data.PlayerIndex = m_PlayerIndices[slotIndex];
+	gameObject.Data.TypeIndex = m_TypeIndices[slotIndex];
+	gameObject.Data.Pose = m_Poses[slotIndex];
+	gameObject.FightIndex = m_FightIndices[slotIndex];
+}
+
+void GameObjectMap::SetPose(unsigned slotIndex, const GameObjectPose& pose)
+{
+	assert(m_Ids[slotIndex] != c_InvalidGameObjectId);
+	m_Poses[slotIndex] = pose;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool GameObjectChangeSet::IsEmpty() const
+{
+	return AddedIds.IsEmpty() && RemovedIds.IsEmpty() && MovedIds.IsEmpty() && FightStateChangedIds.IsEmpty()
+		&& RouteChangedIds.IsEmpty() && Destructions.IsEmpty();
+}
+
+void GameObjectChangeSet::Clear()
+{
+	AddedIds.Clear();
+	RemovedIds.Clear();
+	MovedIds.Clear();
+	FightStateChangedIds.Clear();
+	RouteChangedIds.Clear();
+	Destructions.Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void GameObjectList::AddExistenceListenerOnce(GameObjectExistenceListener& listener)
+{
+	::AddListenerOnce(m_ExistenceListeners, listener);
 }
 
 void GameObjectList::Add(const GameObject& gameObject)
 {
-	assert(m_GameObjects.find(gameObject.Id) == m_GameObjects.end());
-	m_GameObjects[gameObject.Id] = gameObject;
+	assert(m_GameObjects.GetSlotIndex(gameObject.Id) == Core::c_InvalidIndexU);
+	m_GameObjects.Add(gameObject);
 	for (auto listener : m_ExistenceListeners)
 	{
 		listener->OnGameObjectAdded(gameObject);
 	}
+	m_Changes.AddedIds.PushBack(gameObject.Id);
 }
 
 void GameObjectList::Remove(GameObjectId id)
 {
-	auto gIt = m_GameObjects.find(id);
-	assert(gIt != m_GameObjects.end());
-	m_GameObjects.erase(gIt);
+	assert(m_GameObjects.GetSlotIndex(id) != Core::c_InvalidIndexU);
+	m_GameObjects.Remove(id);
 	for (auto listener : m_ExistenceListeners)
 	{
 		listener->OnGameObjectRemoved(id);
 	}
+	m_Changes.RemovedIds.PushBack(id);
 }
 
 void GameObjectList::Clear()
@@ -106,29 +286,21 @@ void GameObjectList::Clear()
 
 void GameObjectList::SetPose(GameObjectId id, const GameObjectPose& pose)
 {
-	auto gIt = m_GameObjects.find(id);
-	assert(gIt != m_GameObjects.end());
-	gIt->second.Data.Pose = pose;
-	for (auto listener : m_PoseListeners)
-	{
-		listener->OnGameObjectPoseChanged(id, pose);
-	}
+	auto slotIndex = m_GameObjects.GetSlotIndex(id);
+	assert(slotIndex != Core::c_InvalidIndexU);
+	m_GameObjects.SetPose(slotIndex, pose);
+	m_Changes.MovedIds.PushBack(id);
 }
 
 void GameObjectList::NotifyGameObjectDestroyed(const GameObject& source, const GameObject& target)
 {
-	for (auto listener : m_FightListeners)
-	{
-		listener->OnGameObjectDestroyed(source, target);
-	}
+	m_Changes.Destructions.PushBack({ source.Id, target.Id, source.Data.PlayerIndex, target.Data.PlayerIndex,
+		target.Data.TypeIndex });
 }
 
-void GameObjectList::NotifyFightStateChanged(const GameObject& object, const GameObjectFightData& fightData)
+void GameObjectList::NotifyFightStateChanged(const GameObject& object)
 {
-	for (auto listener : m_FightListeners)
-	{
-		listener->OnGameObjectFightStateChanged(object, fightData);
-	}
+	m_Changes.FightStateChangedIds.PushBack(object.Id);
 }
 
 const GameObjectMap& GameObjectList::Get() const
@@ -136,6 +308,11 @@ const GameObjectMap& GameObjectList::Get() const
 	return m_GameObjects;
 }
 
+void GameObjectList::CopyStateFrom(const GameObjectList& other)
+{
+	m_GameObjects = other.m_GameObjects;
+}
+
 void GameObjectList::SerializeSB(Core::ByteVector& bytes) const
 {
 	// The serialized state only consists of the game objects, NOT the listeners.
@@ -158,7 +335,7 @@ void GameObjectList::DeserializeSB(const unsigned char*& bytes)
 	{
 		GameObject gameObject;
 		Core::DeserializeSB(bytes, gameObject);
-		m_GameObjects[gameObject.Id] = gameObject;
+		m_GameObjects.Add(gameObject);
 	}
 }
 
@@ -170,7 +347,50 @@ void GameObjectList::NotifyListenersWithFullState()
 		{
 			listener->OnGameObjectAdded(gameObject.second);
 		}
+		m_Changes.AddedIds.PushBack(gameObject.first);
+	}
+}
+
+template <typename TPredicate>
+void RemoveIds(Core::SimpleTypeVectorU<GameObjectId>& ids, TPredicate&& predicate)
+{
+	auto end = std::remove_if(ids.GetArray(), ids.GetEndPointer(), predicate);
+	ids.Resize((unsigned)(end - ids.GetArray()));
+}
+
+GameObjectChangeSet& GameObjectList::FinalizeChanges()
+{
+	auto& addedIds = m_Changes.AddedIds;
+	auto& removedIds = m_Changes.RemovedIds;
+	auto isRemoved = [this](GameObjectId id) { return m_GameObjects.GetSlotIndex(id) == Core::c_InvalidIndexU; };
+
+	// Objects that were added and removed since the last notification are omitted.
+	// Since the game object ids are never reused, these are the added objects that don't exist anymore.
+	addedIds.SortAndRemoveDuplicates();
+	removedIds.SortAndRemoveDuplicates();
+	if (!addedIds.IsEmpty() && !removedIds.IsEmpty())
+	{
+		RemoveIds(removedIds, [&addedIds](GameObjectId id) {
+			return std::binary_search(addedIds.GetArray(), addedIds.GetEndPointer(), id); });
+		RemoveIds(addedIds, isRemoved);
 	}
+
+	m_Changes.MovedIds.SortAndRemoveDuplicates();
+	m_Changes.FightStateChangedIds.SortAndRemoveDuplicates();
+	RemoveIds(m_Changes.MovedIds, isRemoved);
+	RemoveIds(m_Changes.FightStateChangedIds, isRemoved);
+
+	return m_Changes;
+}
+
+void GameObjectList::ClearChanges()
+{
+	m_Changes.Clear();
+}
+
+void GameObjectList::Compact()
+{
+	m_GameObjects.Compact();
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -9,10 +9,12 @@
 #include <Core/Constants.h>
 #include <Core/SingleElementPoolAllocator.hpp>
 #include <Core/DataStructures/ResourceUnorderedVector.hpp>
+#include <Core/DataStructures/SimpleTypeVector.hpp>
 #include <EngineBuildingBlocks/Math/AABoundingBox.h>
 #include <EngineBuildingBlocks/Math/GLM.h>
 
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -41,7 +43,98 @@ struct GameObject
 	void DeserializeSB(const unsigned char*& bytes);
 };
 
-using GameObjectMap = Core::FastStdMap<GameObjectId, GameObject>;
+// Dense game object store with a std::map compatible interface for the lookups and the iteration.
+//
+// The fields of the objects are stored in parallel arrays, which are indexed with slots. The hot fields, that are
+// read by the per-tick loops, i.e. the ids, the poses and the fight indices, are separated from the cold ones, so these
+// loops only load what they use. The slots are addressed with a sparse id -> slot table, therefore lookups are O(1)
+// and the iteration is linear. Since the game object ids are never reused, the sparse table doesn't need generation
+// counters: the id of a removed object always maps to an invalid slot.
+//
+// Objects must be added with increasing ids and are appended, so the iteration order is the id order,
+// exactly as with the ordered map. Since the objects are not stored as a whole, the iterators assemble the object
+// that they point to: the returned references are only valid until the iterator is incremented or destroyed.
+// The per-tick loops should rather access the arrays with the slot indices.
+//
+// Adding and removing objects never move the slots: the iterators and the slot indices stay valid, only the arrays
+// might be reallocated by adding. The removed slots are only dropped by 'Compact', which invalidates the iterators and
+// the slot indices. The game state calls it once per tick, when the changes are flushed.
+class GameObjectMap
+{
+public:
+
+	using value_type = std::pair<GameObjectId, GameObject>;
+
+private:
+
+	// Hot fields. The id of a removed slot is invalid.
+	Core::SimpleTypeVectorU<GameObjectId> m_Ids;
+	Core::SimpleTypeVectorU<GameObjectPose> m_Poses;
+	Core::IndexVectorU m_FightIndices;
+
+	// Cold fields.
+	Core::IndexVectorU m_PlayerIndices;
+	Core::SimpleTypeVectorU<GameObjectTypeIndex> m_TypeIndices;
+
+	Core::IndexVectorU m_IdToSlotIndex;
+	unsigned m_CountObjects = 0;
+
+public:
+
+	class const_iterator
+	{
+		const GameObjectMap* m_Map;
+		unsigned m_SlotIndex;
+		value_type m_Value;
+
+		void SkipRemovedAndAssemble();
+
+	public:
+
+		const_iterator(const GameObjectMap* map, unsigned slotIndex);
+
+		unsigned GetSlotIndex() const { return m_SlotIndex; }
+
+		const value_type& operator*() const { return m_Value; }
+		const value_type* operator->() const { return &m_Value; }
+		const_iterator& operator++() { ++m_SlotIndex; SkipRemovedAndAssemble(); return *this; }
+		bool operator==(const const_iterator& other) const { return m_SlotIndex == other.m_SlotIndex; }
+		bool operator!=(const const_iterator& other) const { return m_SlotIndex != other.m_SlotIndex; }
+	};
+
+	// The objects can only be changed via the dedicated functions.
+	using iterator = const_iterator;
+
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	const_iterator find(GameObjectId id) const;
+
+	size_t size() const;
+	bool empty() const;
+	void clear();
+
+	void Add(const GameObject& gameObject);
+	void Remove(GameObjectId id);
+
+	// Drops the removed slots, if they are the majority.
+	void Compact();
+
+public: // Slot access.
+
+	// Returns Core::c_InvalidIndexU, if the object doesn't exist.
+	unsigned GetSlotIndex(GameObjectId id) const;
+	unsigned GetCountSlots() const;
+
+	const Core::SimpleTypeVectorU<GameObjectId>& GetIds() const;
+	const Core::SimpleTypeVectorU<GameObjectPose>& GetPoses() const;
+	const Core::IndexVectorU& GetFightIndices() const;
+	const Core::IndexVectorU& GetPlayerIndices() const;
+	const Core::SimpleTypeVectorU<GameObjectTypeIndex>& GetTypeIndices() const;
+
+	void AssembleObject(unsigned slotIndex, GameObject& gameObject) const;
+	void SetPose(unsigned slotIndex, const GameObjectPose& pose);
+};
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -63,36 +156,56 @@ public:
 	virtual void OnGameObjectRemoved(GameObjectId objectId) = 0;
 };
 
-class GameObjectPoseListener
+struct GameObjectDestruction
 {
-public:
-	virtual ~GameObjectPoseListener() {}
-	virtual void OnGameObjectPoseChanged(GameObjectId objectId, const GameObjectPose& pose) = 0;
+	GameObjectId SourceId;
+	GameObjectId TargetId;
+
+	// The target doesn't exist anymore, when the destruction is notified.
+	unsigned SourcePlayerIndex;
+	unsigned TargetPlayerIndex;
+	GameObjectTypeIndex TargetTypeIndex;
 };
 
-struct GameObjectFightData;
+// The changes of a game state, that are accumulated during a tick and are notified at once.
+//
+// The id arrays are sorted and don't contain duplicates. An object that is both added and removed since the last
+// notification is omitted from these arrays. The moved and the fight state changed ids only contain existing objects,
+// while the route changed ids might contain removed objects, so the route list must be queried for the current route.
+// The destructions are stored in the order of their occurrence.
+struct GameObjectChangeSet
+{
+	Core::SimpleTypeVectorU<GameObjectId> AddedIds;
+	Core::SimpleTypeVectorU<GameObjectId> RemovedIds;
+	Core::SimpleTypeVectorU<GameObjectId> MovedIds;
+	Core::SimpleTypeVectorU<GameObjectId> FightStateChangedIds;
+	Core::SimpleTypeVectorU<GameObjectId> RouteChangedIds;
+	Core::SimpleTypeVectorU<GameObjectDestruction> Destructions;
+
+	bool IsEmpty() const;
+	void Clear();
+};
 
-class GameObjectFightListener
+class GameObjectChangeListener
 {
 public:
-	virtual ~GameObjectFightListener() {}
-	virtual void OnGameObjectDestroyed(const GameObject& sourceObject, const GameObject& targetObject) = 0;
-	virtual void OnGameObjectFightStateChanged(const GameObject& object, const GameObjectFightData& fightData) = 0;
+	virtual ~GameObjectChangeListener() {}
+	virtual void OnGameObjectsChanged(const GameObjectChangeSet& changes) = 0;
 };
 
+// The existence listeners are notified immediately, they are intended for the model, which must be consistent during
+// the tick. All other changes are only recorded in the change set, that is notified by the game state once per tick.
 class GameObjectList
 {
 	std::vector<GameObjectExistenceListener*> m_ExistenceListeners;
-	std::vector<GameObjectPoseListener*> m_PoseListeners;
-	std::vector<GameObjectFightListener*> m_FightListeners;
 
 	GameObjectMap m_GameObjects;
 
+	GameObjectChangeSet m_Changes;
+
 public:
 
 	void AddExistenceListenerOnce(GameObjectExistenceListener& listener);
-	void AddPoseListenerOnce(GameObjectPoseListener& listener);
-	void AddFightListenerOnce(GameObjectFightListener& listener);
 
 	void Add(const GameObject& gameObject);
 	void Remove(GameObjectId id);
@@ -101,14 +214,25 @@ public:
 	void SetPose(GameObjectId id, const GameObjectPose& pose);
 	
 	void NotifyGameObjectDestroyed(const GameObject& source, const GameObject& target);
-	void NotifyFightStateChanged(const GameObject& object, const GameObjectFightData& fightData);
+	void NotifyFightStateChanged(const GameObject& object);
 
 	const GameObjectMap& Get() const;
 
+	// Copies the game objects without notifying the listeners. The listeners are not copied.
+	void CopyStateFrom(const GameObjectList& other);
+
 	void SerializeSB(Core::ByteVector& bytes) const;
 	void DeserializeSB(const unsigned char*& bytes);
 
 	void NotifyListenersWithFullState();
+
+	// Sorts the recorded changes and removes the obsolete ones. The route changes are recorded by the route list.
+	GameObjectChangeSet& FinalizeChanges();
+	void ClearChanges();
+
+	// Drops the slots of the removed objects. Must not be called while iterating the objects or while using their slot
+	// indices.
+	void Compact();
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -8,17 +8,24 @@
 #include <Timeborne/InGame/Model/GameObjects/Prototype/GameObjectPrototype.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObject.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectMovementSubsystem.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObjectSpatialQuery.h>
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
 #include <Timeborne/InGame/Model/Level.h>
 #include <Timeborne/InGame/Model/TickContext.h>
 #include <Timeborne/Math/Math.h>
 
+#include <Core/System/ThreadPool.h>
+
+#include <algorithm>
+
 GameObjectFightSubsystem::GameObjectFightSubsystem(const Level& level, const GameCreationData& gameCreationData,
 	GameObjectData& gameObjectData, GameObjectMovementSubsystem& movementSubsystem)
 	: m_Level(level)
 	, m_GameCreationData(gameCreationData)
 	, m_GameObjectData(gameObjectData)
 	, m_MovementSubsystem(movementSubsystem)
+	, m_SpatialQuery(std::make_unique<GameObjectSpatialQuery>(*level.GetTerrainTree(),
+		movementSubsystem.GetObjectToNodeMapping(), gameCreationData, gameObjectData))
 {
 	assert(gameObjectData.ClientModelGameState != nullptr);
 
@@ -54,11 +61,12 @@ void GameObjectFightSubsystem::OnGameObjectRemoved(GameObjectId objectId)
 	m_FightingObjects.erase(objectId);
 }
 
-void GameObjectFightSubsystem::OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route)
+void GameObjectFightSubsystem::OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route,
+	RouteAddReason reason)
 {
 	// We handle the event, in which the game object was commanded to follow a non-attack route.
 
-	if (!m_ReactOnRouteEvents || m_Loading) return;
+	if (reason != RouteAddReason::Commanded || m_Loading) return;
 
 	auto fIt = m_FightingObjects.find(objectId);
 	if (fIt != m_FightingObjects.end())
@@ -79,197 +87,305 @@ void GameObjectFightSubsystem::OnRouteAdded(GameObjectId objectId, const GameObj
 
 		m_FightingObjects.erase(objectId);
 
-		gameObjectList.NotifyFightStateChanged(gameObject, fightState);
+		gameObjectList.NotifyFightStateChanged(gameObject);
 	}
 }
 
+constexpr unsigned c_MinCountParallelFightingObjects = 64;
+constexpr unsigned c_FightingObjectPackageSize = 16;
+
 void GameObjectFightSubsystem::Tick(const TickContext& context)
 {
 	assert(m_GameObjectData.ClientModelGameState != nullptr);
 
-	m_ReactOnRouteEvents = false;
-
-	auto& prototypes = GameObjectPrototype::GetPrototypes();
 	auto& gameObjectList = m_GameObjectData.ClientModelGameState->GetGameObjects();
 	auto& gameObjects = gameObjectList.Get();
-	auto& fightList = m_GameObjectData.ClientModelGameState->GetFightList();
 
 	m_FightingObjectsToRemove.ClearAndReserveWithGrow((uint32_t)m_FightingObjects.size());
 	m_ChangedFightStates.Clear();
 
-	double animTime = (double)context.UpdateIntervalInMillis * 1e-3;
+	m_TickEndTimeMs = context.TickCount * context.UpdateIntervalInMillis;
+	m_AnimTime = (double)context.UpdateIntervalInMillis * 1e-3;
 
+	// The intents are applied in object id order, so that the result does not depend on the set.
+	m_AttackIntents.ClearAndReserve((uint32_t)m_FightingObjects.size());
 	for (auto sourceId : m_FightingObjects)
 	{
-		auto sgIt = gameObjects.find(sourceId);
+		m_AttackIntents.UnsafePushBack({ sourceId });
+	}
+	std::sort(m_AttackIntents.GetArray(), m_AttackIntents.GetEndPointer(),
+		[](const AttackIntent& a, const AttackIntent& b) { return a.SourceId < b.SourceId; });
 
-		// The SOURCE might be destroyed by another game object or another mechanism.
-		// VERY IMPORTANT: alone because of this check the game object indices are NOT allowed to be reused.
-		if (sgIt == gameObjects.end())
+	// Computing the attack intents.
+	unsigned countIntents = m_AttackIntents.GetSize();
+	auto threadPool = context.ThreadPool;
+	if (threadPool != nullptr && countIntents >= c_MinCountParallelFightingObjects)
+	{
+		threadPool->ExecuteWithDynamicScheduling(countIntents,
+			&GameObjectFightSubsystem::ComputeAttackIntentsInThread, this, c_FightingObjectPackageSize);
+	}
+	else
+	{
+		ComputeAttackIntentsInThread(0, 0, countIntents);
+	}
+
+	// Applying the attack intents.
+	for (unsigned i = 0; i < countIntents; i++)
+	{
+		ApplyAttackIntent(m_AttackIntents[i]);
+	}
+
+	m_ChangedFightStates.SortAndRemoveDuplicates();
+	unsigned countChangedFightStates = m_ChangedFightStates.GetSize();
+	for (uint32_t i = 0; i < countChangedFightStates; i++)
+	{
+		auto gIt = gameObjects.find(m_ChangedFightStates[i]);
+		if (gIt != gameObjects.end())
 		{
-			m_FightingObjectsToRemove.UnsafePushBack(sourceId);
-			continue;
+			auto& gameObject = gIt->second;
+			gameObjectList.NotifyFightStateChanged(gameObject);
 		}
+	}
 
-		const auto& sourceObject = sgIt->second;
-		auto& sourceFightData = fightList[sourceObject.FightIndex];
-		auto attackTarget = sourceFightData.AttackTarget;
+	unsigned countFightingObjectsToRemove = m_FightingObjectsToRemove.GetSize();
+	for (uint32_t i = 0; i < countFightingObjectsToRemove; i++)
+	{
+		m_FightingObjects.erase(m_FightingObjectsToRemove[i]);
+	}
+}
 
-		assert(sourceFightData.AttackState != AttackState::None && attackTarget != c_InvalidGameObjectId);
+void GameObjectFightSubsystem::ComputeAttackIntentsInThread(unsigned threadId,
+	unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		ComputeAttackIntent(m_AttackIntents[i]);
+	}
+}
 
-		auto changeAttackState = [this, &sourceFightData, sourceId](AttackState state) {
-			assert(sourceFightData.AttackState != state);
-			sourceFightData.AttackState = state;
-			if (state == AttackState::None)
-			{
-				sourceFightData.AttackTarget = c_InvalidGameObjectId;
-				m_FightingObjectsToRemove.UnsafePushBack(sourceId);
-			}
-			m_ChangedFightStates.PushBack(sourceId);
-		};
+void GameObjectFightSubsystem::ComputeAttackIntent(AttackIntent& intent) const
+{
+	// This function must not change the game state: it's executed in parallel for the fighting objects.
 
-		auto tgIt = gameObjects.find(attackTarget);
+	auto& prototypes = GameObjectPrototype::GetPrototypes();
+	const auto& gameObjects = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
+	const auto& fightList = m_GameObjectData.ClientModelGameState->GetFightList();
+
+	auto sourceId = intent.SourceId;
+	intent.TargetId = c_InvalidGameObjectId;
+	intent.State = AttackState::None;
+	intent.IsSourceMissing = false;
+	intent.IsApproachRouteNeeded = false;
+	intent.IsAttacking = false;
+	intent.LastAttackTimeMs = 0;
+	intent.HitPoints = 0;
+
+	auto sgIt = gameObjects.find(sourceId);
+
+	// The SOURCE might be destroyed by another game object or another mechanism.
+	// VERY IMPORTANT: alone because of this check the game object indices are NOT allowed to be reused.
+	if (sgIt == gameObjects.end())
+	{
+		intent.IsSourceMissing = true;
+		return;
+	}
 
-		// The TARGET might be destroyed by another game object or another mechanism.
-		// VERY IMPORTANT: alone because of this check the game object indices are NOT allowed to be reused.
-		if (tgIt == gameObjects.end())
-		{
-			changeAttackState(AttackState::None);
-			continue;
-		}
+	const auto& sourceObject = sgIt->second;
+	const auto& sourceFightData = fightList[sourceObject.FightIndex];
+	auto attackTarget = sourceFightData.AttackTarget;
 
-		// @todo: currently only considering ground objects here.
+	assert(sourceFightData.AttackState != AttackState::None && attackTarget != c_InvalidGameObjectId);
 
-		const auto& sourcePrototype = *prototypes[(uint32_t)sourceObject.Data.TypeIndex];
-		const auto& sourceFightPrototype = sourcePrototype.GetFight();
-		const auto& sourceAttackPrototype = sourceFightPrototype.GroundAttack;
+	intent.TargetId = attackTarget;
+	intent.LastAttackTimeMs = sourceFightData.LastAttackTimeMs;
+
+	auto tgIt = gameObjects.find(attackTarget);
+
+	// The TARGET might be destroyed by another game object or another mechanism.
+	// VERY IMPORTANT: alone because of this check the game object indices are NOT allowed to be reused.
+	if (tgIt == gameObjects.end()) return;
+
+	intent.State = sourceFightData.AttackState;
+
+	// @todo: currently only considering ground objects here.
 
-		const auto& targetObject = tgIt->second;
+	const auto& sourcePrototype = *prototypes[(uint32_t)sourceObject.Data.TypeIndex];
+	const auto& sourceFightPrototype = sourcePrototype.GetFight();
+	const auto& sourceAttackPrototype = sourceFightPrototype.GroundAttack;
 
-		bool hasRoute = HasRoute(sourceId);
+	const auto& targetObject = tgIt->second;
 
-		// Note that the movement subsystem's rest time is not taken into account here, the object gets
-		// its full fight time, when the target is approached.
+	bool hasRoute = HasRoute(sourceId);
 
-		// Turning is object game object specific and as such, it's handled differently for different object types:
-		//
-		// - en-route-attackers: e.g. tanks, the orientation wouldn't change, just the tower is rotated.
-		// - non-en-route-attackers: e.g. infantry, the orientation will be changed in the movement subsystem
-		//   to make sure no collisions occur.
-		//
-		// Thus the fight subsystem will NEVER change the object's pose directly, neither the position nor the
-		// orientation.
+	// Note that the movement subsystem's rest time is not taken into account here, the object gets
+	// its full fight time, when the target is approached.
 
-		auto& targetFightData = fightList[targetObject.FightIndex];
+	// Turning is object game object specific and as such, it's handled differently for different object types:
+	//
+	// - en-route-attackers: e.g. tanks, the orientation wouldn't change, just the tower is rotated.
+	// - non-en-route-attackers: e.g. infantry, the orientation will be changed in the movement subsystem
+	//   to make sure no collisions occur.
+	//
+	// Thus the fight subsystem will NEVER change the object's pose directly, neither the position nor the
+	// orientation.
 
-		double restAnimTime = animTime;
-		while (restAnimTime > 0.0)
+	double restAnimTime = m_AnimTime;
+	while (restAnimTime > 0.0)
+	{
+		if (intent.State == AttackState::Approach)
 		{
-			if (sourceFightData.AttackState == AttackState::Approach)
+			if (hasRoute)
 			{
-				if (hasRoute)
+				if (sourceAttackPrototype.EnRouteAttacker)
 				{
-					if (sourceAttackPrototype.EnRouteAttacker)
-					{
-						// @todo: handle secondary targets.
-						break;
-					}
-					else
-					{
-						break;
-					}
+					// @todo: handle secondary targets.
+					break;
 				}
 				else
 				{
-					// Approaching is finished, proceeding to the next state.
-					changeAttackState(sourceAttackPrototype.EnRouteAttacker
-						? AttackState::Turning : AttackState::Attack);
+					break;
 				}
 			}
-			else if (sourceFightData.AttackState == AttackState::Turning)
+			else
 			{
-				bool turnReady = TurnAhead(gameObjectList, sourceId, targetObject.Data.Pose, restAnimTime);
-				if (turnReady)
-				{
-					changeAttackState(AttackState::Attack);
-				}
+				// Approaching is finished, proceeding to the next state.
+				intent.State = sourceAttackPrototype.EnRouteAttacker ? AttackState::Turning : AttackState::Attack;
 			}
-			else
+		}
+		else if (intent.State == AttackState::Turning)
+		{
+			bool turnReady = TurnAhead(sourceObject, targetObject.Data.Pose, restAnimTime);
+			if (turnReady)
 			{
-				assert(sourceFightData.AttackState == AttackState::Attack);
+				intent.State = AttackState::Attack;
+			}
+		}
+		else
+		{
+			assert(intent.State == AttackState::Attack);
 
-				if (IsCloseEnoughForAttack(sourceObject, sourceAttackPrototype, targetObject.Data.Pose))
+			if (IsCloseEnoughForAttack(sourceObject, sourceAttackPrototype, targetObject.Data.Pose))
+			{
+				if (IsTurnedAheadForAttack(sourceObject, sourceAttackPrototype, targetObject.Data.Pose))
 				{
-					if (IsTurnedAheadForAttack(sourceObject, sourceAttackPrototype, targetObject.Data.Pose))
-					{
-						auto hpBefore = targetFightData.HealthPoints;
-						Attack(context, sourceAttackPrototype, sourceFightData, targetFightData, restAnimTime);
-						auto hpAfter = targetFightData.HealthPoints;
-
-						if (hpAfter == 0)
-						{
-							changeAttackState(AttackState::None);
-							gameObjectList.NotifyGameObjectDestroyed(sourceObject, targetObject);
-							gameObjectList.Remove(attackTarget);
-							break;
-						}
-						else if (hpAfter != hpBefore)
-						{
-							m_ChangedFightStates.PushBack(attackTarget);
-						}
-					}
-					else if (sourceAttackPrototype.EnRouteAttacker)
-					{
-						changeAttackState(AttackState::Turning);
-					}
-					else
-					{
-						bool rotationExist = CreateApproachRoute(sourceObject, sourceAttackPrototype,
-							targetObject.Data.Pose);
-						assert(rotationExist);
-						changeAttackState(AttackState::Approach);
-						break;
-					}
+					Attack(sourceAttackPrototype, intent, restAnimTime);
+				}
+				else if (sourceAttackPrototype.EnRouteAttacker)
+				{
+					intent.State = AttackState::Turning;
 				}
 				else
 				{
-					// @todo: when following is not intended, this must be changed.
-
-					bool routeExists = CreateApproachRoute(sourceObject, sourceAttackPrototype,
-						targetObject.Data.Pose);
-					if (routeExists)
-					{
-						changeAttackState(AttackState::Approach);
-						break;
-					}
-					else
-					{
-						changeAttackState(AttackState::None);
-					}
+					// Only a rotation is needed, creating the route is deferred.
+					intent.IsApproachRouteNeeded = true;
+					break;
 				}
 			}
+			else
+			{
+				// @todo: when following is not intended, this must be changed.
+
+				// Creating the route is deferred.
+				intent.IsApproachRouteNeeded = true;
+				break;
+			}
 		}
 	}
+}
 
-	m_ChangedFightStates.SortAndRemoveDuplicates();
-	unsigned countChangedFightStates = m_ChangedFightStates.GetSize();
-	for (uint32_t i = 0; i < countChangedFightStates; i++)
+void GameObjectFightSubsystem::ApplyAttackIntent(const AttackIntent& intent)
+{
+	auto& prototypes = GameObjectPrototype::GetPrototypes();
+	auto& gameObjectList = m_GameObjectData.ClientModelGameState->GetGameObjects();
+	auto& gameObjects = gameObjectList.Get();
+	auto& fightList = m_GameObjectData.ClientModelGameState->GetFightList();
+
+	auto sourceId = intent.SourceId;
+
+	// The SOURCE might also be destroyed by an intent that has been applied in this tick.
+	auto sgIt = gameObjects.find(sourceId);
+	if (intent.IsSourceMissing || sgIt == gameObjects.end())
 	{
-		auto gIt = gameObjects.find(m_ChangedFightStates[i]);
-		if (gIt != gameObjects.end())
+		m_FightingObjectsToRemove.PushBack(sourceId);
+		return;
+	}
+
+	const auto& sourceObject = sgIt->second;
+	auto& sourceFightData = fightList[sourceObject.FightIndex];
+
+	// The TARGET might also be destroyed by an intent that has been applied in this tick.
+	auto tgIt = gameObjects.find(intent.TargetId);
+	bool isTargetDestroyed = false;
+
+	auto state = intent.State;
+	auto targetId = intent.TargetId;
+	bool isTargetLost = (tgIt == gameObjects.end());
+	if (isTargetLost)
+	{
+		state = AttackState::None;
+	}
+	else if (intent.IsApproachRouteNeeded)
+	{
+		const auto& sourceAttackPrototype = prototypes[(uint32_t)sourceObject.Data.TypeIndex]->GetFight().GroundAttack;
+		bool routeExists = CreateApproachRoute(sourceObject, sourceAttackPrototype, tgIt->second.Data.Pose);
+		state = routeExists ? AttackState::Approach : AttackState::None;
+	}
+	else if (intent.IsAttacking)
+	{
+		sourceFightData.LastAttackTimeMs = intent.LastAttackTimeMs;
+		m_ChangedFightStates.PushBack(sourceId);
+
+		auto& targetFightData = fightList[tgIt->second.FightIndex];
+		uint32_t hp = targetFightData.HealthPoints;
+		hp -= std::min(intent.HitPoints, hp);
+		targetFightData.HealthPoints = hp;
+
+		if (hp == 0)
 		{
-			auto& gameObject = gIt->second;
-			gameObjectList.NotifyFightStateChanged(gameObject, fightList[gameObject.FightIndex]);
+			state = AttackState::None;
+			isTargetDestroyed = true;
+			isTargetLost = true;
+		}
+		else if (intent.HitPoints > 0)
+		{
+			m_ChangedFightStates.PushBack(intent.TargetId);
 		}
 	}
 
-	unsigned countFightingObjectsToRemove = m_FightingObjectsToRemove.GetSize();
-	for (uint32_t i = 0; i < countFightingObjectsToRemove; i++)
+	// Continuing the fight with an enemy in the attack range, when the target has been lost.
+	if (isTargetLost)
 	{
-		m_FightingObjects.erase(m_FightingObjectsToRemove[i]);
+		const auto& sourceAttackPrototype = prototypes[(uint32_t)sourceObject.Data.TypeIndex]->GetFight().GroundAttack;
+		targetId = AcquireTarget(sourceObject, sourceAttackPrototype);
+		if (targetId != c_InvalidGameObjectId)
+		{
+			// The approach route of the lost target is no longer needed.
+			DeleteRoute(sourceId);
+			state = AttackState::Attack;
+		}
 	}
 
-	m_ReactOnRouteEvents = true;
+	if (state != sourceFightData.AttackState || targetId != sourceFightData.AttackTarget)
+	{
+		sourceFightData.AttackState = state;
+		if (state == AttackState::None)
+		{
+			sourceFightData.AttackTarget = c_InvalidGameObjectId;
+			m_FightingObjectsToRemove.PushBack(sourceId);
+		}
+		else
+		{
+			sourceFightData.AttackTarget = targetId;
+		}
+		m_ChangedFightStates.PushBack(sourceId);
+	}
+
+	// The fight data must not be accessed after the removal.
+	if (isTargetDestroyed)
+	{
+		gameObjectList.NotifyGameObjectDestroyed(sourceObject, tgIt->second);
+		gameObjectList.Remove(intent.TargetId);
+	}
 }
 
 void GameObjectFightSubsystem::ProcessCommand(const GameObjectCommand& command)
@@ -277,8 +393,6 @@ void GameObjectFightSubsystem::ProcessCommand(const GameObjectCommand& command)
 	assert(command.Type == GameObjectCommand::Type::ObjectToObject);
 	assert(m_GameObjectData.ClientModelGameState != nullptr);
 
-	m_ReactOnRouteEvents = false;
-
 	auto& prototypes = GameObjectPrototype::GetPrototypes();
 	auto& gameObjectList = m_GameObjectData.ClientModelGameState->GetGameObjects();
 	auto& gameObjects = gameObjectList.Get();
@@ -377,14 +491,12 @@ void GameObjectFightSubsystem::ProcessCommand(const GameObjectCommand& command)
 			m_FightingObjects.insert(sourceObject.Id);
 		}
 
-		gameObjectList.NotifyFightStateChanged(sourceObject, sourceFightData);
+		gameObjectList.NotifyFightStateChanged(sourceObject);
 	}
-
-	m_ReactOnRouteEvents = true;
 }
 
 bool GameObjectFightSubsystem::IsCloseEnoughForAttack(const GameObject& sourceObject,
-	const AttackPrototypeData& sourceAttackPData, const GameObjectPose& targetPose)
+	const AttackPrototypeData& sourceAttackPData, const GameObjectPose& targetPose) const
 {
 	float distance = (float)sourceObject.Data.Pose.GetDistance2d(targetPose);
 	float maxDistance = sourceAttackPData.ApproachDistance.GetValue(
@@ -448,33 +560,68 @@ bool GameObjectFightSubsystem::CreateApproachRoute(const GameObject& sourceObjec
 		&approachData, orientationTarget);
 }
 
-bool GameObjectFightSubsystem::TurnAhead(GameObjectList& gameObjectList,
-	GameObjectId objectId, const GameObjectPose& targetPose, double& restAnimTime)
+GameObjectId GameObjectFightSubsystem::AcquireTarget(const GameObject& sourceObject,
+	const AttackPrototypeData& sourceAttackPData)
+{
+	// The query is not thread-safe: this function must only be called in the serial phase of the tick.
+
+	constexpr unsigned c_MaxCountTargetCandidates = 8;
+
+	const auto& gameObjects = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
+	const auto& fightList = m_GameObjectData.ClientModelGameState->GetFightList();
+
+	GameObjectQueryFilter filter;
+	filter.PlayerIndex = sourceObject.Data.PlayerIndex;
+	filter.Relation = GameObjectQueryFilter::PlayerRelation::Enemy;
+	filter.ExcludedObjectId = sourceObject.Id;
+
+	m_SpatialQuery->QueryNearest(sourceObject.Data.Pose.GetPosition2d(), c_MaxCountTargetCandidates,
+		(double)sourceAttackPData.ApproachDistance.GetMax(), filter, m_TargetCandidates);
+
+	// The candidates are ordered by the distance and the object id.
+	auto countCandidates = m_TargetCandidates.GetSize();
+	for (unsigned i = 0; i < countCandidates; i++)
+	{
+		auto gIt = gameObjects.find(m_TargetCandidates[i]);
+		if (gIt == gameObjects.end()) continue;
+		const auto& targetObject = gIt->second;
+
+		// Objects destroyed in this tick are only removed after their attacker's intent has been applied.
+		if (targetObject.FightIndex == Core::c_InvalidIndexU
+			|| fightList[targetObject.FightIndex].HealthPoints == 0) continue;
+
+		if (IsCloseEnoughForAttack(sourceObject, sourceAttackPData, targetObject.Data.Pose)) return targetObject.Id;
+	}
+
+	return c_InvalidGameObjectId;
+}
+
+bool GameObjectFightSubsystem::TurnAhead(const GameObject& sourceObject,
+	const GameObjectPose& targetPose, double& restAnimTime) const
 {
 	// @todo
 	return true;
 }
 
-void GameObjectFightSubsystem::Attack(const TickContext& context, const AttackPrototypeData& sourceAttackPData,
-	GameObjectFightData& sourceFightData, GameObjectFightData& targetFightData, double& restAnimTime)
+void GameObjectFightSubsystem::Attack(const AttackPrototypeData& sourceAttackPData, AttackIntent& intent,
+	double& restAnimTime) const
 {
 	// The attack happens at a given time point - not throughout a time duration.
 
 	uint32_t restAnimTimeMs = (uint32_t)std::round(restAnimTime * 1e3);
 
-	uint32_t endTimeMs = context.TickCount * context.UpdateIntervalInMillis;
-	uint32_t lastAttackTimeMs = sourceFightData.LastAttackTimeMs;
+	uint32_t endTimeMs = m_TickEndTimeMs;
+	uint32_t lastAttackTimeMs = intent.LastAttackTimeMs;
 	uint32_t currentAttackTimeMs = lastAttackTimeMs + sourceAttackPData.ReattackDurationMs;
 
 	if (endTimeMs >= currentAttackTimeMs)
 	{
 		uint32_t attackTimeOffsetMs = std::min(endTimeMs - currentAttackTimeMs, restAnimTimeMs);
-		sourceFightData.LastAttackTimeMs = endTimeMs - attackTimeOffsetMs;
+		intent.LastAttackTimeMs = endTimeMs - attackTimeOffsetMs;
 
-		uint32_t hitPoints = sourceAttackPData.HitPoints;
-		uint32_t hp = targetFightData.HealthPoints;
-		hp -= std::min(hitPoints, hp);
-		targetFightData.HealthPoints = hp;
+		// The damage is dealt when the intent is applied.
+		intent.IsAttacking = true;
+		intent.HitPoints = sourceAttackPData.HitPoints;
 	}
 
 	restAnimTime = 0.0;
@@ -4,21 +4,24 @@
 
 #include <Timeborne/InGame/Model/GameObjects/GameObjectSubsystem.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObject.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObjectFightData.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectRoute.h>
 
 #include <Timeborne/InGame/Model/GameObjects/GameObjectId.h>
 
+#include <memory>
+
 struct AttackApproachPrototypeData;
 struct AttackPrototypeData;
 struct GameCreationData;
 struct GameObject;
 struct GameObjectCommand;
 struct GameObjectData;
-struct GameObjectFightData;
 class GameObjectList;
 class GameObjectMovementSubsystem;
 class GameObjectPose;
 class GameObjectPrototype;
+class GameObjectSpatialQuery;
 
 class GameObjectFightSubsystem : public GameObjectSubsystem
 	, public GameObjectExistenceListener
@@ -29,15 +32,16 @@ class GameObjectFightSubsystem : public GameObjectSubsystem
 	GameObjectData& m_GameObjectData;
 	GameObjectMovementSubsystem& m_MovementSubsystem;
 
+	std::unique_ptr<GameObjectSpatialQuery> m_SpatialQuery;
+
 	Core::FastStdSet<GameObjectId> m_FightingObjects;
 	Core::SimpleTypeVectorU<GameObjectId> m_FightingObjectsToRemove;
 	Core::SimpleTypeVectorU<GameObjectId> m_ChangedFightStates;
-
-	bool m_ReactOnRouteEvents = true;
+	Core::SimpleTypeVectorU<GameObjectId> m_TargetCandidates;
 
 	bool IsCloseEnoughForAttack(const GameObject& sourceObject,
 		const AttackPrototypeData& sourceAttackPData,
-		const GameObjectPose& targetPose);
+		const GameObjectPose& targetPose) const;
 
 	static bool IsTurnedAheadForAttack(const GameObject& sourceObject,
 		const AttackPrototypeData& sourceAttackPData,
@@ -49,14 +53,46 @@ class GameObjectFightSubsystem : public GameObjectSubsystem
 		const AttackPrototypeData& sourceAttackPData,
 		const GameObjectPose& targetPose);
 
-	bool TurnAhead(GameObjectList& gameObjectList,
-		GameObjectId objectId, const GameObjectPose& targetPose,
-		double& restAnimTime);
-	void Attack(const TickContext& context,
-		const AttackPrototypeData& sourceAttackPData,
-		GameObjectFightData& sourceFightData,
-		GameObjectFightData& targetFightData,
-		double& restAnimTime);
+	// Returns the nearest enemy that can be attacked without approaching it, or an invalid id.
+	GameObjectId AcquireTarget(const GameObject& sourceObject,
+		const AttackPrototypeData& sourceAttackPData);
+
+private: // Tick.
+
+	// The tick is executed in two phases. First the attack intents are computed in parallel from the state at the
+	// beginning of the tick, without changing it. Then the intents are applied in object id order: the routes are
+	// created, the damage is dealt and the destroyed objects are removed. This way the result depends neither on the
+	// thread count nor on the iteration order of the fighting object set.
+
+	struct AttackIntent
+	{
+		GameObjectId SourceId;
+		GameObjectId TargetId;
+
+		// The attack state after the transitions that don't require changing the game state.
+		AttackState State;
+
+		bool IsSourceMissing;
+		bool IsApproachRouteNeeded;
+		bool IsAttacking;
+		uint32_t LastAttackTimeMs;
+		uint32_t HitPoints;
+	};
+
+	Core::SimpleTypeVectorU<AttackIntent> m_AttackIntents;
+	uint32_t m_TickEndTimeMs = 0;
+	double m_AnimTime = 0.0;
+
+	void ComputeAttackIntentsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void ComputeAttackIntent(AttackIntent& intent) const;
+	void ApplyAttackIntent(const AttackIntent& intent);
+
+	bool TurnAhead(const GameObject& sourceObject,
+		const GameObjectPose& targetPose,
+		double& restAnimTime) const;
+	void Attack(const AttackPrototypeData& sourceAttackPData,
+		AttackIntent& intent,
+		double& restAnimTime) const;
 
 public:
 	GameObjectFightSubsystem(const Level& level,
@@ -82,7 +118,7 @@ public: // GameObjectExistenceListener IF.
 public: // GameObjectRouteListener IF.
 
 	void OnRouteAdded(GameObjectId objectId,
-		const GameObjectRoute& route) override;
+		const GameObjectRoute& route, RouteAddReason reason) override;
 	void OnRouteRemoved(GameObjectId objectId,
 		RouteRemoveReason reason) {}
 };
\ No newline at end of file
@@ -11,6 +11,8 @@
 #include <Timeborne/InGame/Model/GameObjects/GameObjectWorkSubsystem.h>
 #include <Timeborne/InGame/Model/CommandListProcessor.h>
 #include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/TickContext.h>
+#include <Timeborne/Profiler.h>
 
 using namespace EngineBuildingBlocks::Graphics;
 
@@ -31,6 +33,7 @@ GameObjectModel::GameObjectModel(const Level& level, const GameCreationData& gam
 	m_Subsystems.push_back(m_MovementSubsystem.get());
 	m_Subsystems.push_back(m_FightSubsystem.get());
 	m_Subsystems.push_back(m_WorkSubsystem.get());
+	m_SubsystemStages = { TickTimings::Stage::Movement, TickTimings::Stage::Fight, TickTimings::Stage::Work };
 
 	if (fromSaveFile)
 	{
@@ -62,15 +65,17 @@ void GameObjectModel::ProcessCommands()
 		assert(m_CommandList.GetCommandForCommandId(commandId).Source == CommandSource::GameObject);
 		auto& commandData = m_CommandList.GetGameObjectCommand(commandId);
 
+		ProfilerZone zone("ProcessCommand");
+
 		if (commandData.Type == GameObjectCommand::Type::ObjectToTerrain)
 		{
 			m_MovementSubsystem->ProcessCommand(commandData);
 		}
 		else // ObjectToObject
 		{
-			auto oIt = gameObjectsMap.find(commandData.TargetId);
-			assert(oIt != gameObjectsMap.end());
-			auto targetTypeIndex = oIt->second.Data.TypeIndex;
+			auto slotIndex = gameObjectsMap.GetSlotIndex(commandData.TargetId);
+			assert(slotIndex != Core::c_InvalidIndexU);
+			auto targetTypeIndex = gameObjectsMap.GetTypeIndices()[slotIndex];
 			auto targetType = prototypes[(uint32_t)targetTypeIndex]->GetType();
 			if (targetType == GameObjectPrototype::Type::Resource)
 			{
@@ -87,12 +92,33 @@ void GameObjectModel::ProcessCommands()
 
 void GameObjectModel::Tick(const TickContext& context)
 {
-	ProcessCommands();
+	{
+		TickStageTimer timer(context.Timings, TickTimings::Stage::Commands);
+		ProcessCommands();
+	}
+
+	// The path requests are collected and solved in parallel before and after the subsystem ticks.
+	{
+		TickStageTimer timer(context.Timings, TickTimings::Stage::PathRequests);
+		m_MovementSubsystem->SolvePathRequests(context);
+	}
 
-	for (auto subsystem : m_Subsystems)
+	auto countSubsystems = (unsigned)m_Subsystems.size();
+	for (unsigned i = 0; i < countSubsystems; i++)
 	{
-		subsystem->Tick(context);
+		TickStageTimer timer(context.Timings, m_SubsystemStages[i]);
+		m_Subsystems[i]->Tick(context);
 	}
+
+	{
+		TickStageTimer timer(context.Timings, TickTimings::Stage::PathRequests);
+		m_MovementSubsystem->SolvePathRequests(context);
+	}
+}
+
+const GameObjectMovementSubsystem& GameObjectModel::GetMovementSubsystem() const
+{
+	return *m_MovementSubsystem;
 }
 
 void GameObjectModel::AddGameObject(const GameObjectLevelData& goData)
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <Timeborne/InGame/Model/TickTimings.h>
+
 #include <Core/DataStructures/SimpleTypeVector.hpp>
 
 #include <memory>
@@ -32,6 +34,7 @@ class GameObjectModel
 	std::unique_ptr<GameObjectFightSubsystem> m_FightSubsystem;
 	std::unique_ptr<GameObjectWorkSubsystem> m_WorkSubsystem;
 	std::vector<GameObjectSubsystem*> m_Subsystems;
+	std::vector<TickTimings::Stage> m_SubsystemStages;
 
 	Core::IndexVectorU m_AvailableCommandIds;
 
@@ -51,4 +54,6 @@ public:
 	~GameObjectModel();
 
 	void Tick(const TickContext& context);
+
+	const GameObjectMovementSubsystem& GetMovementSubsystem() const;
 };
\ No newline at end of file
@@ -10,6 +10,8 @@
 #include <Timeborne/InGame/Model/TickContext.h>
 #include <Timeborne/InGame/GameState/ServerGameState.h>
 
+#include <Core/System/ThreadPool.h>
+
 GameObjectMovementSubsystem::GameObjectMovementSubsystem(const Level& level, GameObjectData& gameObjectData)
 	: m_Level(level)
 	, m_GameObjectData(gameObjectData)
@@ -30,34 +32,61 @@ float GameObjectMovementSubsystem::GetPathFindingHeight(const GameObjectPose& po
 	return m_PathFinder->GetPathFindingHeight(pose);
 }
 
-bool GameObjectMovementSubsystem::CreateRoute(GameObjectId objectId, const glm::ivec2& targetField,
-	const HeightDependentDistanceParameters* distanceParameters, const glm::dvec2& orientationTarget)
+const GroundObjectTerrainTreeNodeMapping& GameObjectMovementSubsystem::GetObjectToNodeMapping() const
+{
+	return m_ObjectToNodeMapping;
+}
+
+const PathFinder& GameObjectMovementSubsystem::GetPathFinder() const
+{
+	return *m_PathFinder;
+}
+
+bool GameObjectMovementSubsystem::IsDynamicObject(GameObjectId objectId) const
 {
 	assert(m_GameObjectData.ClientModelGameState != nullptr);
 	const auto& gameObjectsMap = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
 
-	auto gIt = gameObjectsMap.find(objectId);
-	if (gIt == gameObjectsMap.end()) return false;
+	auto slotIndex = gameObjectsMap.GetSlotIndex(objectId);
+	if (slotIndex == Core::c_InvalidIndexU) return false;
 
-	auto& routes = m_GameObjectData.ClientModelGameState->GetRoutes();
-	auto& prototypes = GameObjectPrototype::GetPrototypes();
+	auto typeIndex = gameObjectsMap.GetTypeIndices()[slotIndex];
+	auto& objectPrototype = *GameObjectPrototype::GetPrototypes()[(uint32_t)typeIndex];
+	return objectPrototype.GetMovement().IsDynamic();
+}
+
+bool GameObjectMovementSubsystem::CreateRoute(GameObjectId objectId, const glm::ivec2& targetField,
+	const HeightDependentDistanceParameters* distanceParameters, const glm::dvec2& orientationTarget)
+{
+	return CreateRoute(objectId, targetField, distanceParameters, orientationTarget, false,
+		RouteAddReason::AttackApproach);
+}
 
-	const auto& gameObject = gIt->second;
-	auto& objectPrototype = *prototypes[(uint32_t)gameObject.Data.TypeIndex];
+bool GameObjectMovementSubsystem::CreateRoute(GameObjectId objectId, const glm::ivec2& targetField,
+	const HeightDependentDistanceParameters* distanceParameters, const glm::dvec2& orientationTarget,
+	bool isGroupPath, RouteAddReason reason)
+{
+	assert(m_GameObjectData.ClientModelGameState != nullptr);
+	auto& routes = m_GameObjectData.ClientModelGameState->GetRoutes();
 
-	if (!objectPrototype.GetMovement().IsDynamic()) return false;
+	if (!IsDynamicObject(objectId)) return false;
 
 	RemoveFromRoute(objectId, RouteRemoveReason::Aborted);
 
 	auto& route = routes.BeginAdd(objectId);
 
-	
-	bool pathValid = m_PathFinder->FindPath(objectId, targetField, distanceParameters, route.Path);
+	// The group path must have been computed for the same target without distance parameters.
+	// A requested path is only published by 'SolvePathRequests', when the search result is committed.
+	assert(!isGroupPath || distanceParameters == nullptr);
+	bool pathPending = false;
+	bool pathValid = isGroupPath
+		? m_PathFinder->FindGroupPath(objectId, route.Path)
+		: m_PathFinder->RequestPath(objectId, targetField, distanceParameters, reason, route.Path, pathPending);
 	if (pathValid)
 	{
 		route.OrientationTarget = orientationTarget;
 		route.NextFieldIndex = 1U; // Skipping the current field.
-		routes.FinishAdd(objectId);
+		if (!pathPending) routes.FinishAdd(objectId, reason);
 	}
 	else
 	{
@@ -76,25 +105,50 @@ void GameObjectMovementSubsystem::ProcessCommand(const GameObjectCommand& comman
 {
 	assert(command.Type == GameObjectCommand::Type::ObjectToTerrain);
 
+	// All objects move to the same target: a single search is executed for them.
+	m_GroupObjectIds.Clear();
 	auto countSources = command.SourceIds.GetSize();
 	for (unsigned i = 0; i < countSources; i++)
 	{
-		CreateRoute(command.SourceIds[i], command.TargetField, nullptr,
-			GameObjectRoute::c_InvalidOrientationTarget);
+		auto objectId = command.SourceIds[i];
+		if (IsDynamicObject(objectId)) m_GroupObjectIds.PushBack(objectId);
+	}
+
+	auto countObjects = m_GroupObjectIds.GetSize();
+	if (countObjects == 0) return;
+
+	bool isGroupPath = (countObjects > 1);
+	if (isGroupPath) m_PathFinder->ComputeGroupPaths(m_GroupObjectIds, command.TargetField);
+
+	for (unsigned i = 0; i < countObjects; i++)
+	{
+		CreateRoute(m_GroupObjectIds[i], command.TargetField, nullptr,
+			GameObjectRoute::c_InvalidOrientationTarget, isGroupPath, RouteAddReason::Commanded);
 	}
 }
 
+void GameObjectMovementSubsystem::SolvePathRequests(const TickContext& context)
+{
+	assert(m_GameObjectData.ClientModelGameState != nullptr);
+	m_PathFinder->SolvePathRequests(context.ThreadPool, m_GameObjectData.ClientModelGameState->GetRoutes(),
+		context.PathQueries);
+}
+
 void GameObjectMovementSubsystem::RemoveFromRoute(GameObjectId objectId, RouteRemoveReason reason)
 {
 	assert(m_GameObjectData.ClientModelGameState != nullptr);
 	auto& routes = m_GameObjectData.ClientModelGameState->GetRoutes();
 
+	// A pending route has not been published yet, so it is aborted without notifying the listeners.
+	bool pathPending = m_PathFinder->CancelPathRequest(objectId);
+
 	auto route = routes.GetRoutes().Get(objectId);
 	if (route != nullptr)
 	{
 		// Currently a route belongs to a single object.
 		assert(route->Path.ObjectId == objectId);
-		routes.Remove(objectId, reason);
+		if (pathPending) routes.AbortAdd(objectId);
+		else routes.Remove(objectId, reason);
 	}
 }
 
@@ -109,165 +163,286 @@ void GameObjectMovementSubsystem::OnGameObjectRemoved(GameObjectId objectId)
 	m_ObjectToNodeMapping.RemoveObject(objectId);
 }
 
-void GameObjectMovementSubsystem::Tick(const TickContext& context)
+void GameObjectMovementSubsystem::PlanMovementSteps(MovementWorkspace& workspace, const GameObjectRoute& route,
+	const GameObjectPose& startPose, const GameObjectMovementPrototype& movementPrototype)
 {
-	assert(m_GameObjectData.ClientModelGameState != nullptr);
-	const auto& gameObjectsMap = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
-	auto& routes = m_GameObjectData.ClientModelGameState->GetRoutes();
-	auto& routeContainer = routes.GetRoutes().GetElements();
-
-	auto& terrain = m_Level.GetTerrain();
-
-	auto& prototypes = GameObjectPrototype::GetPrototypes();
-
-	double animTime = (double)context.UpdateIntervalInMillis * 1e-3;
-
-	m_RoutesToRemove.ClearAndReserve(routeContainer.GetSize());
-
-	auto pathEnd = routeContainer.GetEndConstIterator();
-	for (auto pathIt = routeContainer.GetBeginConstIterator(); pathIt != pathEnd; ++pathIt)
+	auto currentPosition2d = startPose.GetPosition2d();
+	float yaw = startPose.GetYaw();
+	auto currentNextFieldIndex = route.NextFieldIndex;
+
+	// Moving object along the path.
+	double restAnimTime = m_AnimTime;
+	bool moving = true;
+	while (restAnimTime > 0.0 && moving)
 	{
-		auto objectId = pathIt->Key;
-		auto& pathData = pathIt->Data;
-
-		assert(objectId == pathData.Path.ObjectId);
-
-		auto gIt = gameObjectsMap.find(objectId);
-		assert(gIt != gameObjectsMap.end());
+		bool translating = false;
 
-		auto& gameObject = gIt->second;
-		auto typeIndex = gameObject.Data.TypeIndex;
-		auto& prototype = *prototypes[(uint32_t)typeIndex];
-		auto& movementPrototype = prototype.GetMovement();
+		auto rotate = [&yaw, &movementPrototype, &restAnimTime](float targetYaw) {
+			float rotationSpeed = movementPrototype.RotationSpeed;
+			float angleDiff = GameObjectPose::WrapWithRepeat(targetYaw - yaw);
+			double totalTime = (double)(std::abs(angleDiff) / rotationSpeed);
 
-		// Copying the pose.
-		auto currentPose = gameObject.Data.Pose;
-		auto startPose = currentPose;
-
-		// Copying the next field index.
-		auto currentNextFieldIndex = pathData.NextFieldIndex;
-		auto startNextFieldIndex = currentNextFieldIndex;
+			if (totalTime <= restAnimTime)
+			{
+				yaw = targetYaw;
+				restAnimTime -= totalTime;
+			}
+			else
+			{
+				yaw += (angleDiff > 0.0f ? 1.0f : -1.0f) * rotationSpeed * (float)restAnimTime;
+				restAnimTime = 0.0;
+			}
+		};
 
-		// Moving object along the path.
-		double restAnimTime = animTime;
-		bool moving = true;
-		bool collisionDetected = false;
-		while (restAnimTime > 0.0 && moving && !collisionDetected)
+		if (currentNextFieldIndex >= route.Path.Fields.GetSize())
 		{
-			auto originalPose = currentPose;
-			auto originalNextFieldIndex = currentNextFieldIndex;
+			assert(route.IsOrienting());
 
-			auto currentPosition2d = currentPose.GetPosition2d();
-			float yaw = currentPose.GetYaw();
+			float targetYaw = GameObjectPose::GetTargetYaw(currentPosition2d, route.OrientationTarget);
+			rotate(targetYaw);
+			if (yaw == targetYaw)
+			{
+				moving = false;
+			}
+		}
+		else
+		{
+			auto targetFieldIndex = route.Path.Fields[currentNextFieldIndex].FieldIndex;
+			auto targetPosition2d = GameObjectPose::GetMiddle2dFromTerrainFieldIndex(targetFieldIndex);
+			float targetYaw = GameObjectPose::GetTargetYaw(currentPosition2d, targetPosition2d);
 
-			auto rotate = [&yaw, &movementPrototype, &restAnimTime](float targetYaw) {
-				float rotationSpeed = movementPrototype.RotationSpeed;
-				float angleDiff = GameObjectPose::WrapWithRepeat(targetYaw - yaw);
-				double totalTime = (double)(std::abs(angleDiff) / rotationSpeed);
+			if (yaw != targetYaw) // Rotating.
+			{
+				rotate(targetYaw);
+			}
+			else // Translating.
+			{
+				double speed = (double)movementPrototype.Speed;
+				double distance = GameObjectPose::GetDistance2d(currentPosition2d, targetPosition2d);
+				double totalTime = distance / speed;
 
 				if (totalTime <= restAnimTime)
 				{
-					yaw = targetYaw;
+					currentPosition2d = targetPosition2d;
 					restAnimTime -= totalTime;
+					if (++currentNextFieldIndex >= route.Path.Fields.GetSize() && !route.IsOrienting())
+					{
+						moving = false;
+					}
 				}
 				else
 				{
-					yaw += (angleDiff > 0.0f ? 1.0f : -1.0f) * rotationSpeed * (float)restAnimTime;
+					double drivenDistance = restAnimTime * speed;
+					currentPosition2d = GameObjectPose::GetOffsetPosition2d(currentPosition2d, targetPosition2d,
+						drivenDistance);
 					restAnimTime = 0.0;
 				}
-			};
-
-			if (currentNextFieldIndex >= pathData.Path.Fields.GetSize())
-			{
-				assert(pathData.IsOrienting());
 
-				float targetYaw = currentPose.GetTargetYaw(pathData.OrientationTarget);
-				rotate(targetYaw);
-				if (yaw == targetYaw)
-				{
-					moving = false;
-				}
+				translating = true;
 			}
-			else
-			{
-				auto targetFieldIndex = pathData.Path.Fields[currentNextFieldIndex].FieldIndex;
-				auto targetPosition2d = GameObjectPose::GetMiddle2dFromTerrainFieldIndex(targetFieldIndex);
-				float targetYaw = currentPose.GetTargetYaw(targetPosition2d);
+		}
 
-				if (yaw != targetYaw) // Rotating.
-				{
-					rotate(targetYaw);
-				}
-				else // Translating.
-				{
-					double speed = (double)movementPrototype.Speed;
-					double distance = currentPose.GetDistance2d(targetPosition2d);
-					double totalTime = distance / speed;
+		// The pose stores the wrapped yaw.
+		yaw = GameObjectPose::WrapWithRepeat(yaw);
 
-					if (totalTime <= restAnimTime)
-					{
-						currentPosition2d = targetPosition2d;
-						restAnimTime -= totalTime;
-						if (++currentNextFieldIndex >= pathData.Path.Fields.GetSize() && !pathData.IsOrienting())
-						{
-							moving = false;
-						}
-					}
-					else
-					{
-						double drivenDistance = restAnimTime * speed;
-						currentPosition2d = currentPose.GetOffsetPosition2d(targetPosition2d, drivenDistance);
-						restAnimTime = 0.0;
-					}
+		auto& step = workspace.Steps.PushBackPlaceHolder();
+		step.Position2d = currentPosition2d;
+		step.Yaw = yaw;
+		step.NextFieldIndex = currentNextFieldIndex;
+		step.IsTranslating = translating;
+		step.IsMoving = moving;
 
-					float flyHeight = movementPrototype.FlyHeight;
-					currentPose.SetPosition(terrain, currentPosition2d, flyHeight);
-				}
-			}
+		auto& sample = workspace.TerrainSamples.PushBackPlaceHolder();
+		GameObjectPose::ToTerrainIndices(currentPosition2d, sample.FieldIndex, sample.XInField, sample.ZInField);
+	}
+}
 
-			currentPose.SetOrientationFromTerrain(terrain, yaw);
+void GameObjectMovementSubsystem::ComputeCandidatePosesInThread(unsigned threadId,
+	unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	auto& workspace = m_MovementWorkspaces[threadId];
+	auto& steps = workspace.Steps;
+	auto& prototypes = GameObjectPrototype::GetPrototypes();
+	const auto& gameObjectsMap = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
+	auto& poses = gameObjectsMap.GetPoses();
+	auto& typeIndices = gameObjectsMap.GetTypeIndices();
 
-			// Checking whether the nodes are not occupied by ANOTHER object.
-			// Note that if multiple steps taking place we ensure that as many as possible of them are executed.
-			// More fine-granular collision check can be implemented here.
-			{
-				m_ObjectToNodeMapping.SetObject(objectId, typeIndex, currentPose);
+	// Planning the movement steps.
+	unsigned startStepIndex = steps.GetSize();
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		auto& movingObject = m_MovingObjects[i];
+		auto slotIndex = movingObject.SlotIndex;
+		auto& movementPrototype = prototypes[(uint32_t)typeIndices[slotIndex]]->GetMovement();
+
+		movingObject.WorkspaceIndex = threadId;
+		movingObject.StartStepIndex = steps.GetSize();
+		PlanMovementSteps(workspace, *movingObject.Route, poses[slotIndex], movementPrototype);
+		movingObject.EndStepIndex = steps.GetSize();
+	}
 
-				if (m_ObjectToNodeMapping.IsObjectColliding(objectId, true))
-				{
-					// Reverting the change.
-					currentPose = originalPose;
-					currentNextFieldIndex = originalNextFieldIndex;
-					moving = true;
-					collisionDetected = true;
-					m_ObjectToNodeMapping.SetObject(objectId, typeIndex, originalPose);
-				}
-			}
-		}
+	// Evaluating the terrain for the planned steps.
+	unsigned countSteps = steps.GetSize();
+	workspace.TerrainHeights.Resize(countSteps);
+	workspace.TerrainNormals.Resize(countSteps);
+	m_Level.GetTerrain().GetHeightsAndNormals(workspace.TerrainSamples.GetArray() + startStepIndex,
+		countSteps - startStepIndex, workspace.TerrainHeights.GetArray() + startStepIndex,
+		workspace.TerrainNormals.GetArray() + startStepIndex);
 
-		// Publising the pose change.
-		if (currentPose != startPose)
-		{
-			m_GameObjectData.ClientModelGameState->GetGameObjects().SetPose(objectId, currentPose);
-		}
+	// Computing the candidate poses and their nodes.
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		auto& movingObject = m_MovingObjects[i];
+		auto typeIndex = typeIndices[movingObject.SlotIndex];
+		float flyHeight = prototypes[(uint32_t)typeIndex]->GetMovement().FlyHeight;
 
-		// Publishing the next field index change.
-		if (currentNextFieldIndex != startNextFieldIndex)
+		auto currentPose = poses[movingObject.SlotIndex];
+		for (unsigned j = movingObject.StartStepIndex; j < movingObject.EndStepIndex; j++)
 		{
-			routes.AccessRoute(objectId).NextFieldIndex = currentNextFieldIndex;
+			auto& step = steps[j];
+			if (step.IsTranslating) currentPose.SetPosition(step.Position2d, workspace.TerrainHeights[j], flyHeight);
+			currentPose.SetOrientation(workspace.TerrainNormals[j], step.Yaw);
+			step.Pose = currentPose;
+
+			m_ObjectToNodeMapping.GetNodeIndices(typeIndex, currentPose, workspace.CurrentNodeIndices);
+			step.NodeIndicesStart = workspace.NodeIndices.GetSize();
+			step.CountNodeIndices = workspace.CurrentNodeIndices.GetSize();
+			workspace.NodeIndices.PushBack(workspace.CurrentNodeIndices.GetArray(), step.CountNodeIndices);
 		}
+	}
+}
+
+void GameObjectMovementSubsystem::CommitMovement(const MovingObject& movingObject)
+{
+	auto objectId = movingObject.ObjectId;
+	auto& gameObjects = m_GameObjectData.ClientModelGameState->GetGameObjects();
+	auto& gameObjectsMap = gameObjects.Get();
+	auto typeIndex = gameObjectsMap.GetTypeIndices()[movingObject.SlotIndex];
+	auto& workspace = m_MovementWorkspaces[movingObject.WorkspaceIndex];
+	auto& routes = m_GameObjectData.ClientModelGameState->GetRoutes();
+
+	// Copying the pose.
+	auto startPose = gameObjectsMap.GetPoses()[movingObject.SlotIndex];
+	const GameObjectPose* currentPose = &startPose;
 
-		// Marking the route for remove. This must happen after checking collisions.
-		if (!moving)
+	// Copying the next field index.
+	auto startNextFieldIndex = movingObject.Route->NextFieldIndex;
+	auto currentNextFieldIndex = startNextFieldIndex;
+
+	bool moving = true;
+	for (unsigned j = movingObject.StartStepIndex; j < movingObject.EndStepIndex; j++)
+	{
+		auto& step = workspace.Steps[j];
+
+		// Checking whether the nodes are not occupied by ANOTHER object.
+		// Note that if multiple steps taking place we ensure that as many as possible of them are executed.
+		// More fine-granular collision check can be implemented here.
+		m_ObjectToNodeMapping.SetObjectWithNodeIndices(objectId,
+			workspace.NodeIndices.GetArray() + step.NodeIndicesStart, step.CountNodeIndices);
+
+		if (m_ObjectToNodeMapping.IsObjectColliding(objectId, true))
 		{
-			m_RoutesToRemove.UnsafePushBack(objectId);
+			// Reverting the change.
+			if (j == movingObject.StartStepIndex)
+			{
+				m_ObjectToNodeMapping.SetObject(objectId, typeIndex, startPose);
+			}
+			else
+			{
+				auto& previousStep = workspace.Steps[j - 1];
+				m_ObjectToNodeMapping.SetObjectWithNodeIndices(objectId,
+					workspace.NodeIndices.GetArray() + previousStep.NodeIndicesStart, previousStep.CountNodeIndices);
+			}
+			moving = true;
+			break;
 		}
+
+		currentPose = &step.Pose;
+		currentNextFieldIndex = step.NextFieldIndex;
+		moving = step.IsMoving;
+	}
+
+	// Publising the pose change.
+	if (*currentPose != startPose)
+	{
+		gameObjects.SetPose(objectId, *currentPose);
+	}
+
+	// Publishing the next field index change.
+	if (currentNextFieldIndex != startNextFieldIndex)
+	{
+		routes.AccessRoute(objectId).NextFieldIndex = currentNextFieldIndex;
+	}
+
+	// Marking the route for remove. This must happen after checking collisions.
+	if (!moving)
+	{
+		m_RoutesToRemove.UnsafePushBack(objectId);
+	}
+}
+
+constexpr unsigned c_MinCountParallelMovingObjects = 64;
+constexpr unsigned c_MovingObjectPackageSize = 16;
+
+void GameObjectMovementSubsystem::Tick(const TickContext& context)
+{
+	assert(m_GameObjectData.ClientModelGameState != nullptr);
+	const auto& gameObjectsMap = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
+	auto& routes = m_GameObjectData.ClientModelGameState->GetRoutes();
+	auto& routeContainer = routes.GetRoutes().GetElements();
+
+	m_AnimTime = (double)context.UpdateIntervalInMillis * 1e-3;
+
+	m_RoutesToRemove.ClearAndReserve(routeContainer.GetSize());
+	m_MovingObjects.ClearAndReserve(routeContainer.GetSize());
+
+	// The objects are only addressed with their slots, their fields are read from the arrays of the map.
+	auto pathEnd = routeContainer.GetEndConstIterator();
+	for (auto pathIt = routeContainer.GetBeginConstIterator(); pathIt != pathEnd; ++pathIt)
+	{
+		auto objectId = pathIt->Key;
+		auto& pathData = pathIt->Data;
+
+		assert(objectId == pathData.Path.ObjectId);
+
+		auto slotIndex = gameObjectsMap.GetSlotIndex(objectId);
+		assert(slotIndex != Core::c_InvalidIndexU);
+
+		m_MovingObjects.UnsafePushBack({ objectId, slotIndex, &pathData });
+	}
+
+	// Computing the candidate poses.
+	unsigned countMovingObjects = m_MovingObjects.GetSize();
+	auto threadPool = context.ThreadPool;
+	bool isParallel = (threadPool != nullptr && countMovingObjects >= c_MinCountParallelMovingObjects);
+	unsigned countWorkspaces = isParallel ? threadPool->GetCountThreads() : 1;
+	if ((unsigned)m_MovementWorkspaces.size() < countWorkspaces) m_MovementWorkspaces.resize(countWorkspaces);
+	for (auto& workspace : m_MovementWorkspaces)
+	{
+		workspace.Steps.Clear();
+		workspace.TerrainSamples.Clear();
+		workspace.NodeIndices.Clear();
+	}
+	if (isParallel)
+	{
+		threadPool->ExecuteWithDynamicScheduling(countMovingObjects,
+			&GameObjectMovementSubsystem::ComputeCandidatePosesInThread, this, c_MovingObjectPackageSize);
+	}
+	else
+	{
+		ComputeCandidatePosesInThread(0, 0, countMovingObjects);
+	}
+
+	// Committing the movement in the route container order.
+	for (unsigned i = 0; i < countMovingObjects; i++)
+	{
+		CommitMovement(m_MovingObjects[i]);
 	}
 
 	// Deleting the path if the object has reached the target point or it has stuck.
 	unsigned countIndicesToRemove = m_RoutesToRemove.GetSize();
 	for (unsigned i = 0; i < countIndicesToRemove; i++)
 	{
-		routes.Remove(m_RoutesToRemove[i], RouteRemoveReason::Ended);
+		RemoveFromRoute(m_RoutesToRemove[i], RouteRemoveReason::Ended);
 	}
 }
@@ -7,12 +7,15 @@
 
 #include <Timeborne/InGame/Model/GameObjects/ObjectToNodeMapping/GroundObjectTerrainTreeNodeMapping.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectRoute.h>
+#include <Timeborne/InGame/Model/Terrain/Terrain.h>
 
 #include <memory>
+#include <vector>
 
 struct ComponentRenderContext;
 struct GameObjectCommand;
 struct GameObjectData;
+struct GameObjectMovementPrototype;
 class GameObjectPose;
 struct HeightDependentDistanceParameters;
 class Level;
@@ -30,22 +33,87 @@ class GameObjectMovementSubsystem : public GameObjectSubsystem
 
 	void RemoveFromRoute(GameObjectId objectId, RouteRemoveReason reason);
 
+	bool IsDynamicObject(GameObjectId objectId) const;
+
+	bool CreateRoute(GameObjectId objectId, const glm::ivec2& targetField,
+		const HeightDependentDistanceParameters* distanceParameters,
+		const glm::dvec2& orientationTarget, bool isGroupPath, RouteAddReason reason);
+
+private: // Temp in ProcessCommand(...).
+
+	Core::SimpleTypeVectorU<GameObjectId> m_GroupObjectIds;
+
 private: // Temp in Tick(...).
 
 	Core::SimpleTypeVectorU<GameObjectId> m_RoutesToRemove;
 
+	// The tick first computes the candidate poses of all moving objects in parallel: the movement steps are planned in
+	// 2d, the terrain is evaluated in a batch and the node indices of the poses are computed. Then the steps are
+	// committed serially in the order of the route container, the steps of each object until its first collision, as
+	// in the serial movement. Since the candidate poses do not depend on the collisions, the result is independent of
+	// the thread count.
+	struct MovementStep
+	{
+		glm::dvec2 Position2d;
+		float Yaw;
+		unsigned NextFieldIndex;
+		bool IsTranslating;
+		bool IsMoving;
+
+		GameObjectPose Pose;
+		unsigned NodeIndicesStart;
+		unsigned CountNodeIndices;
+	};
+
+	struct MovementWorkspace
+	{
+		Core::SimpleTypeVectorU<MovementStep> Steps;
+		Core::SimpleTypeVectorU<Terrain::SurfaceSample> TerrainSamples;
+		Core::SimpleTypeVectorU<float> TerrainHeights;
+		Core::SimpleTypeVectorU<glm::vec3> TerrainNormals;
+		Core::IndexVectorU NodeIndices;
+		Core::IndexVectorU CurrentNodeIndices;
+	};
+
+	struct MovingObject
+	{
+		GameObjectId ObjectId;
+		unsigned SlotIndex; // In the game object map, which is not compacted during the tick.
+		const GameObjectRoute* Route;
+		unsigned WorkspaceIndex;
+		unsigned StartStepIndex;
+		unsigned EndStepIndex;
+	};
+
+	Core::SimpleTypeVectorU<MovingObject> m_MovingObjects;
+	std::vector<MovementWorkspace> m_MovementWorkspaces;
+	double m_AnimTime = 0.0;
+
+	void PlanMovementSteps(MovementWorkspace& workspace, const GameObjectRoute& route, const GameObjectPose& startPose,
+		const GameObjectMovementPrototype& movementPrototype);
+	void ComputeCandidatePosesInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void CommitMovement(const MovingObject& movingObject);
+
 public:
 	GameObjectMovementSubsystem(const Level& level, GameObjectData& gameObjectData);
 	~GameObjectMovementSubsystem() override;
 
 	float GetPathFindingHeight(const GameObjectPose& pose) const;
 
+	const GroundObjectTerrainTreeNodeMapping& GetObjectToNodeMapping() const;
+	const PathFinder& GetPathFinder() const;
+
+	// Creates an approach route for an attack.
 	bool CreateRoute(GameObjectId objectId, const glm::ivec2& targetField,
 		const HeightDependentDistanceParameters* distanceParameters,
 		const glm::dvec2& orientationTarget);
 	void DeleteRoute(GameObjectId objectId);
 	void ProcessCommand(const GameObjectCommand& command);
 
+	// Routes that need a search are pending until their path is set and they are published here.
+	// Must be called before the routes are used.
+	void SolvePathRequests(const TickContext& context);
+
 public: // GameObjectSubsystem IF.
 
 	void Tick(const TickContext& context) override;
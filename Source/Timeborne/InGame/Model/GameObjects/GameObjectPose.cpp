@@ -49,18 +49,27 @@ glm::dvec2 GameObjectPose::GetPosition2d() const
 
 glm::dvec2 GameObjectPose::GetOffsetPosition2d(const glm::dvec2& target, double length) const
 {
-	auto position2d = GetPosition2d();
-	return position2d + glm::normalize(target - position2d) * length;
+	return GetOffsetPosition2d(GetPosition2d(), target, length);
+}
+
+glm::dvec2 GameObjectPose::GetOffsetPosition2d(const glm::dvec2& position, const glm::dvec2& target, double length)
+{
+	return position + glm::normalize(target - position) * length;
 }
 
 double GameObjectPose::GetDistance2d(const glm::dvec2& target) const
 {
-	return glm::length(target - GetPosition2d());
+	return GetDistance2d(GetPosition2d(), target);
 }
 
 double GameObjectPose::GetDistance2d(const GameObjectPose& target) const
 {
-	return glm::length(target.GetPosition2d() - GetPosition2d());
+	return GetDistance2d(GetPosition2d(), target.GetPosition2d());
+}
+
+double GameObjectPose::GetDistance2d(const glm::dvec2& position, const glm::dvec2& target)
+{
+	return glm::length(target - position);
 }
 
 float GameObjectPose::GetYaw() const
@@ -70,8 +79,7 @@ float GameObjectPose::GetYaw() const
 
 float GameObjectPose::GetTargetYaw(const glm::dvec2& target) const
 {
-	auto d = target - GetPosition2d();
-	return WrapWithRepeat((float)std::atan2(-d.y, d.x));
+	return GetTargetYaw(GetPosition2d(), target);
 }
 
 float GameObjectPose::GetTargetYaw(const GameObjectPose& target) const
@@ -79,6 +87,12 @@ float GameObjectPose::GetTargetYaw(const GameObjectPose& target) const
 	return GetTargetYaw(target.GetPosition2d());
 }
 
+float GameObjectPose::GetTargetYaw(const glm::dvec2& position, const glm::dvec2& target)
+{
+	auto d = target - position;
+	return WrapWithRepeat((float)std::atan2(-d.y, d.x));
+}
+
 GameObjectPose::GameOrientation2d GameObjectPose::GetGameOrientation2d() const
 {
 	glm::vec2 dir2 = glm::normalize(glm::vec2(m_Direction.x, m_Direction.z));
@@ -89,17 +103,25 @@ void GameObjectPose::SetPosition(const Terrain& terrain, const glm::dvec2& posit
 {
 	glm::ivec2 fieldIndex; float xInField, zInField;
 	ToTerrainIndices(position2d, fieldIndex, xInField, zInField);
-	float height = terrain.GetHeight(fieldIndex, xInField, zInField);
-	m_Position = glm::dvec3(position2d.x, (double)height + (double)flyHeight, position2d.y);
+	SetPosition(position2d, terrain.GetHeight(fieldIndex, xInField, zInField), flyHeight);
 }
 
 void GameObjectPose::SetOrientationFromTerrain(const Terrain& terrain, float yaw)
 {
-	m_Yaw = WrapWithRepeat(yaw);
-
 	glm::ivec2 fieldIndex; float xInField, zInField;
 	ToTerrainIndices(GetPosition2d(), fieldIndex, xInField, zInField);
-	m_Up = glm::vec3(terrain.GetNormal(fieldIndex, xInField, zInField));
+	SetOrientation(terrain.GetNormal(fieldIndex, xInField, zInField), yaw);
+}
+
+void GameObjectPose::SetPosition(const glm::dvec2& position2d, float terrainHeight, float flyHeight)
+{
+	m_Position = glm::dvec3(position2d.x, (double)terrainHeight + (double)flyHeight, position2d.y);
+}
+
+void GameObjectPose::SetOrientation(const glm::vec3& up, float yaw)
+{
+	m_Yaw = WrapWithRepeat(yaw);
+	m_Up = up;
 
 	// Prefering correct direction over right vector. Note that this is identical to projecting the 2d direction vector
 	// onto the surface (plane described by the normal vector).
@@ -41,11 +41,14 @@ public: // Game positioning.
 	static glm::ivec2 GetTerrainFieldIndex(const glm::dvec2& position);
 	glm::dvec2 GetPosition2d() const;
 	glm::dvec2 GetOffsetPosition2d(const glm::dvec2& target, double length) const;
+	static glm::dvec2 GetOffsetPosition2d(const glm::dvec2& position, const glm::dvec2& target, double length);
 	double GetDistance2d(const glm::dvec2& target) const;
 	double GetDistance2d(const GameObjectPose& target) const;
+	static double GetDistance2d(const glm::dvec2& position, const glm::dvec2& target);
 	float GetYaw() const;
 	float GetTargetYaw(const glm::dvec2& target) const;
 	float GetTargetYaw(const GameObjectPose& target) const;
+	static float GetTargetYaw(const glm::dvec2& position, const glm::dvec2& target);
 
 	struct GameOrientation2d
 	{
@@ -59,11 +62,13 @@ public: // Game positioning.
 	void SetPosition(const Terrain& terrain, const glm::dvec2& position2d, float flyHeight);
 	void SetOrientationFromTerrain(const Terrain& terrain, float yaw);
 
+	// Setters for terrain data that has been evaluated in advance, e.g. in a batch.
+	void SetPosition(const glm::dvec2& position2d, float terrainHeight, float flyHeight);
+	void SetOrientation(const glm::vec3& up, float yaw);
+
 	static glm::dvec2 GetMiddle2dFromTerrainFieldIndex(const glm::ivec2& fieldIndex);
 	static float WrapWithRepeat(float angle);
 
-private:
-
 	static void ToTerrainIndices(const glm::dvec2& position2d, glm::ivec2& fieldIndex, float& xInField, float& zInField);
 
 public: // World positioning.
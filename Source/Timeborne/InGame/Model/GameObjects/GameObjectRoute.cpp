@@ -50,14 +50,15 @@ GameObjectRoute& GameObjectRouteList::BeginAdd(GameObjectId objectId)
 	return m_Routes.Add(objectId);
 }
 
-void GameObjectRouteList::FinishAdd(GameObjectId objectId)
+void GameObjectRouteList::FinishAdd(GameObjectId objectId, RouteAddReason reason)
 {
 	for (auto& listener : m_Listeners)
 	{
 		auto* route = m_Routes.Get(objectId);
 		assert(route != nullptr);
-		listener->OnRouteAdded(objectId, *route);
+		listener->OnRouteAdded(objectId, *route, reason);
 	}
+	m_ChangedIds.PushBack(objectId);
 }
 
 void GameObjectRouteList::AbortAdd(GameObjectId objectId)
@@ -73,6 +74,7 @@ void GameObjectRouteList::Remove(GameObjectId objectId, RouteRemoveReason reason
 	{
 		listener->OnRouteRemoved(objectId, reason);
 	}
+	m_ChangedIds.PushBack(objectId);
 }
 
 const GameObjectRoute* GameObjectRouteList::GetRoute(GameObjectId objectId) const
@@ -84,6 +86,7 @@ GameObjectRoute& GameObjectRouteList::AccessRoute(GameObjectId objectId)
 {
 	auto data = m_Routes.Get(objectId);
 	assert(data != nullptr);
+	m_AccessedIds.PushBack(objectId);
 	return *data;
 }
 
@@ -92,6 +95,11 @@ const FastReusableResourceMap<GameObjectId, GameObjectRoute>& GameObjectRouteLis
 	return m_Routes;
 }
 
+void GameObjectRouteList::CopyStateFrom(const GameObjectRouteList& other)
+{
+	m_Routes = other.m_Routes;
+}
+
 void GameObjectRouteList::SerializeSB(Core::ByteVector& bytes) const
 {
 	// The serialized state only consists of the game objects, NOT the listeners.
@@ -128,7 +136,24 @@ void GameObjectRouteList::NotifyListenersWithFullState()
 	{
 		for (auto listener : m_Listeners)
 		{
-			listener->OnRouteAdded(rIt->Key, rIt->Data);
+			listener->OnRouteAdded(rIt->Key, rIt->Data, RouteAddReason::Loaded);
 		}
+		m_ChangedIds.PushBack(rIt->Key);
 	}
 }
+
+const Core::SimpleTypeVectorU<GameObjectId>& GameObjectRouteList::GetChangedIds() const
+{
+	return m_ChangedIds;
+}
+
+const Core::SimpleTypeVectorU<GameObjectId>& GameObjectRouteList::GetAccessedIds() const
+{
+	return m_AccessedIds;
+}
+
+void GameObjectRouteList::ClearChangedIds()
+{
+	m_ChangedIds.Clear();
+	m_AccessedIds.Clear();
+}
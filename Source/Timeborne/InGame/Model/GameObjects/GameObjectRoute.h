@@ -24,6 +24,12 @@ struct GameObjectRoute
 
 class GameObjectRouteList;
 
+// Only the commanded routes change the fight state of their objects.
+enum class RouteAddReason
+{
+	Commanded, AttackApproach, Loaded
+};
+
 enum class RouteRemoveReason
 {
 	Ended, ObjectRemoved, Aborted
@@ -35,34 +41,53 @@ public:
 	GameObjectRouteListener();
 	virtual ~GameObjectRouteListener();
 
-	virtual void OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route) = 0;
+	virtual void OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route, RouteAddReason reason) = 0;
 	virtual void OnRouteRemoved(GameObjectId objectId, RouteRemoveReason reason) = 0;
 };
 
+// The listeners are notified immediately, they are intended for the model. The views use the route changed ids
+// of the game state's change set.
+// A route is only published by 'FinishAdd': between 'BeginAdd' and 'FinishAdd' it is pending and must be finished or
+// aborted by its creator, it must not be removed with 'Remove'.
 class GameObjectRouteList
 {
 	std::vector<GameObjectRouteListener*> m_Listeners;
 
 	FastReusableResourceMap<GameObjectId, GameObjectRoute> m_Routes;
 
+	Core::SimpleTypeVectorU<GameObjectId> m_ChangedIds;
+	Core::SimpleTypeVectorU<GameObjectId> m_AccessedIds;
+
 public:
 
 	void AddListenerOnce(GameObjectRouteListener& listener);
 
 	GameObjectRoute& BeginAdd(GameObjectId objectId);
-	void FinishAdd(GameObjectId objectId);
+	void FinishAdd(GameObjectId objectId, RouteAddReason reason);
 	void AbortAdd(GameObjectId objectId);
 
 	void Remove(GameObjectId objectId, RouteRemoveReason reason);
 
 	const GameObjectRoute* GetRoute(GameObjectId objectId) const;
 
-	GameObjectRoute& AccessRoute(GameObjectId objectId); // Changes are not listened.
+	// Changes are not listened, only recorded for the hashing. The path of a published route must not be changed.
+	GameObjectRoute& AccessRoute(GameObjectId objectId);
 
 	const FastReusableResourceMap<GameObjectId, GameObjectRoute>& GetRoutes() const;
 
+	// Copies the routes without notifying the listeners. The listeners are not copied.
+	void CopyStateFrom(const GameObjectRouteList& other);
+
 	void SerializeSB(Core::ByteVector& bytes) const;
 	void DeserializeSB(const unsigned char*& bytes);
 
 	void NotifyListenersWithFullState();
+
+	// The ids of the objects, whose route has been added or removed since the last clearing. Might contain duplicates.
+	const Core::SimpleTypeVectorU<GameObjectId>& GetChangedIds() const;
+
+	// The ids of the objects, whose route has been accessed for changing since the last clearing.
+	const Core::SimpleTypeVectorU<GameObjectId>& GetAccessedIds() const;
+
+	void ClearChangedIds();
 };
\ No newline at end of file
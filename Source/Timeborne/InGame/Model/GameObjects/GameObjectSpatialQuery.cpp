@@ -0,0 +1,212 @@
+// Timeborne/InGame/Model/GameObjects/GameObjectSpatialQuery.cpp
+
+#include <Timeborne/InGame/Model/GameObjects/GameObjectSpatialQuery.h>
+
+#include <Timeborne/GameCreation/GameCreationData.h>
+#include <Timeborne/InGame/GameState/ServerGameState.h>
+#include <Timeborne/InGame/Model/GameObjects/ObjectToNodeMapping/GroundObjectTerrainTreeNodeMapping.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObject.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
+
+// The object positions are not necessarily in the mapped nodes, but in their neighborhood.
+// The queried field ranges and node bounds are extended with this value.
+constexpr int c_FieldMargin = 1;
+
+bool GameObjectSpatialQuery::QueueElement::operator<(const QueueElement& other) const
+{
+	if (DistanceSqr != other.DistanceSqr) return DistanceSqr > other.DistanceSqr;
+	if (IsObject != other.IsObject) return other.IsObject;
+	return Index > other.Index;
+}
+
+GameObjectSpatialQuery::GameObjectSpatialQuery(const TerrainTree& terrainTree,
+	const GroundObjectTerrainTreeNodeMapping& objectToNodeMapping,
+	const GameCreationData& gameCreationData,
+	const GameObjectData& gameObjectData)
+	: m_TerrainTree(terrainTree)
+	, m_ObjectToNodeMapping(objectToNodeMapping)
+	, m_GameCreationData(gameCreationData)
+	, m_GameObjectData(gameObjectData)
+{
+}
+
+const GameObjectMap& GameObjectSpatialQuery::GetGameObjects() const
+{
+	assert(m_GameObjectData.ClientModelGameState != nullptr);
+	return m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
+}
+
+bool GameObjectSpatialQuery::IsMatching(const GameObjectMap& gameObjects, unsigned slotIndex,
+	const GameObjectQueryFilter& filter) const
+{
+	if (gameObjects.GetIds()[slotIndex] == filter.ExcludedObjectId) return false;
+
+	auto playerIndex = gameObjects.GetPlayerIndices()[slotIndex];
+	auto& players = m_GameCreationData.Players;
+
+	using PlayerRelation = GameObjectQueryFilter::PlayerRelation;
+	switch (filter.Relation)
+	{
+		case PlayerRelation::Own: return playerIndex == filter.PlayerIndex;
+		case PlayerRelation::Allied: return players.AreAllied(playerIndex, filter.PlayerIndex);
+		case PlayerRelation::Enemy: return !players.AreAllied(playerIndex, filter.PlayerIndex);
+		default: return true;
+	}
+}
+
+double GameObjectSpatialQuery::GetNodeDistanceSqr(unsigned nodeIndex, const glm::dvec2& position) const
+{
+	auto& node = m_TerrainTree.GetNode(nodeIndex);
+	auto minPosition = glm::dvec2(node.Start - c_FieldMargin);
+	auto maxPosition = glm::dvec2(node.End + 1 + c_FieldMargin);
+	auto diff = glm::max(glm::max(minPosition - position, position - maxPosition), glm::dvec2(0.0));
+	return glm::length2(diff);
+}
+
+void GameObjectSpatialQuery::CollectCandidates(const glm::ivec2& startField, const glm::ivec2& endField,
+	Core::SimpleTypeVectorU<GameObjectId>& candidates) const
+{
+	candidates.Clear();
+
+	m_NodeIndexStack.Clear();
+	m_NodeIndexStack.PushBack(0U); // Root node.
+
+	while (!m_NodeIndexStack.IsEmpty())
+	{
+		auto nodeIndex = m_NodeIndexStack.PopBackReturn();
+		auto& node = m_TerrainTree.GetNode(nodeIndex);
+
+		if (node.End.x < startField.x || node.End.y < startField.y
+			|| node.Start.x > endField.x || node.Start.y > endField.y)
+		{
+			continue;
+		}
+
+		if (node.Children[0] == Core::c_InvalidIndexU)
+		{
+			auto objectIdsPtr = m_ObjectToNodeMapping.GetObjectsForNode(nodeIndex);
+			if (objectIdsPtr != nullptr) candidates.PushBack(*objectIdsPtr);
+		}
+		else
+		{
+			for (unsigned i = 0; i < 4; i++)
+			{
+				auto childIndex = node.Children[i];
+				if (childIndex != Core::c_InvalidIndexU) m_NodeIndexStack.PushBack(childIndex);
+			}
+		}
+	}
+
+	candidates.SortAndRemoveDuplicates();
+}
+
+void GameObjectSpatialQuery::QueryBox(const glm::dvec2& minPosition, const glm::dvec2& maxPosition,
+	const GameObjectQueryFilter& filter, Core::SimpleTypeVectorU<GameObjectId>& result) const
+{
+	auto startField = glm::ivec2(glm::floor(minPosition)) - c_FieldMargin;
+	auto endField = glm::ivec2(glm::floor(maxPosition)) + c_FieldMargin;
+	CollectCandidates(startField, endField, result);
+
+	auto& gameObjects = GetGameObjects();
+	auto& poses = gameObjects.GetPoses();
+
+	unsigned countResults = 0;
+	auto countCandidates = result.GetSize();
+	for (unsigned i = 0; i < countCandidates; i++)
+	{
+		auto slotIndex = gameObjects.GetSlotIndex(result[i]);
+		if (slotIndex == Core::c_InvalidIndexU || !IsMatching(gameObjects, slotIndex, filter)) continue;
+		auto position = poses[slotIndex].GetPosition2d();
+		if (glm::all(glm::greaterThanEqual(position, minPosition)) && glm::all(glm::lessThanEqual(position, maxPosition)))
+		{
+			result[countResults++] = result[i];
+		}
+	}
+	result.Resize(countResults);
+}
+
+void GameObjectSpatialQuery::QueryRadius(const glm::dvec2& center, double radius,
+	const GameObjectQueryFilter& filter, Core::SimpleTypeVectorU<GameObjectId>& result) const
+{
+	auto startField = glm::ivec2(glm::floor(center - radius)) - c_FieldMargin;
+	auto endField = glm::ivec2(glm::floor(center + radius)) + c_FieldMargin;
+	CollectCandidates(startField, endField, result);
+
+	auto& gameObjects = GetGameObjects();
+	auto& poses = gameObjects.GetPoses();
+
+	double radiusSqr = radius * radius;
+	unsigned countResults = 0;
+	auto countCandidates = result.GetSize();
+	for (unsigned i = 0; i < countCandidates; i++)
+	{
+		auto slotIndex = gameObjects.GetSlotIndex(result[i]);
+		if (slotIndex == Core::c_InvalidIndexU || !IsMatching(gameObjects, slotIndex, filter)) continue;
+		if (glm::length2(poses[slotIndex].GetPosition2d() - center) <= radiusSqr)
+		{
+			result[countResults++] = result[i];
+		}
+	}
+	result.Resize(countResults);
+}
+
+void GameObjectSpatialQuery::QueryNearest(const glm::dvec2& center, unsigned countObjects, double maxRadius,
+	const GameObjectQueryFilter& filter, Core::SimpleTypeVectorU<GameObjectId>& result) const
+{
+	result.Clear();
+	if (countObjects == 0) return;
+
+	auto& gameObjects = GetGameObjects();
+	auto& poses = gameObjects.GetPoses();
+
+	double maxDistanceSqr = maxRadius * maxRadius;
+
+	// Best-first traversal: the nodes are ordered by their lower distance bound, so an object is only
+	// taken from the queue when no closer object can be found in the remaining nodes.
+	while (!m_Queue.empty()) m_Queue.pop();
+	m_Queue.push({ GetNodeDistanceSqr(0U, center), 0U, false });
+
+	while (!m_Queue.empty() && result.GetSize() < countObjects)
+	{
+		auto current = m_Queue.top();
+		m_Queue.pop();
+
+		if (current.DistanceSqr > maxDistanceSqr) break;
+
+		if (current.IsObject)
+		{
+			// Objects can be mapped to multiple nodes.
+			auto objectId = GameObjectId(current.Index);
+			if (!result.Contains(objectId)) result.PushBack(objectId);
+			continue;
+		}
+
+		auto nodeIndex = current.Index;
+		auto& node = m_TerrainTree.GetNode(nodeIndex);
+		if (node.Children[0] == Core::c_InvalidIndexU)
+		{
+			auto objectIdsPtr = m_ObjectToNodeMapping.GetObjectsForNode(nodeIndex);
+			if (objectIdsPtr == nullptr) continue;
+
+			auto& objectIds = *objectIdsPtr;
+			auto countNodeObjects = objectIds.GetSize();
+			for (unsigned i = 0; i < countNodeObjects; i++)
+			{
+				auto slotIndex = gameObjects.GetSlotIndex(objectIds[i]);
+				if (slotIndex == Core::c_InvalidIndexU || !IsMatching(gameObjects, slotIndex, filter)) continue;
+				double distanceSqr = glm::length2(poses[slotIndex].GetPosition2d() - center);
+				if (distanceSqr <= maxDistanceSqr) m_Queue.push({ distanceSqr, (uint32_t)objectIds[i], true });
+			}
+		}
+		else
+		{
+			for (unsigned i = 0; i < 4; i++)
+			{
+				auto childIndex = node.Children[i];
+				if (childIndex == Core::c_InvalidIndexU) continue;
+				double distanceSqr = GetNodeDistanceSqr(childIndex, center);
+				if (distanceSqr <= maxDistanceSqr) m_Queue.push({ distanceSqr, childIndex, false });
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+// Timeborne/InGame/Model/GameObjects/GameObjectSpatialQuery.h
+
+#pragma once
+
+#include <Timeborne/InGame/Model/GameObjects/GameObjectId.h>
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+#include <EngineBuildingBlocks/Math/GLM.h>
+
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+struct GameCreationData;
+struct GameObjectData;
+class GameObjectMap;
+class GroundObjectTerrainTreeNodeMapping;
+class TerrainTree;
+
+struct GameObjectQueryFilter
+{
+	enum class PlayerRelation { Any, Own, Allied, Enemy };
+
+	// The relation is evaluated to this player.
+	uint32_t PlayerIndex = Core::c_InvalidIndexU;
+	PlayerRelation Relation = PlayerRelation::Any;
+
+	// Typically the querying object itself.
+	GameObjectId ExcludedObjectId = c_InvalidGameObjectId;
+};
+
+// Implements proximity queries of the ground objects by traversing the terrain tree and reading the objects
+// from the node mapping of the leaf nodes. Therefore the cost depends on the object density of the queried
+// region, NOT on the total number of objects.
+//
+// The objects are tested with their position.
+class GameObjectSpatialQuery
+{
+	const TerrainTree& m_TerrainTree;
+	const GroundObjectTerrainTreeNodeMapping& m_ObjectToNodeMapping;
+	const GameCreationData& m_GameCreationData;
+	const GameObjectData& m_GameObjectData;
+
+	struct QueueElement
+	{
+		double DistanceSqr;
+		unsigned Index; // Node index or object id.
+		bool IsObject;
+
+		// Priority queue order: the lowest distance has the highest priority. On equal distances objects are
+		// processed first, then the lower indices.
+		bool operator<(const QueueElement& other) const;
+	};
+
+	// Temp.
+	mutable Core::IndexVectorU m_NodeIndexStack;
+	mutable std::priority_queue<QueueElement, std::vector<QueueElement>> m_Queue;
+
+	const GameObjectMap& GetGameObjects() const;
+	bool IsMatching(const GameObjectMap& gameObjects, unsigned slotIndex, const GameObjectQueryFilter& filter) const;
+
+	double GetNodeDistanceSqr(unsigned nodeIndex, const glm::dvec2& position) const;
+
+	// Collects the objects of the leaf nodes, which intersect the given field range. The result may
+	// contain duplicates.
+	void CollectCandidates(const glm::ivec2& startField, const glm::ivec2& endField,
+		Core::SimpleTypeVectorU<GameObjectId>& candidates) const;
+
+public:
+
+	GameObjectSpatialQuery(const TerrainTree& terrainTree,
+		const GroundObjectTerrainTreeNodeMapping& objectToNodeMapping,
+		const GameCreationData& gameCreationData,
+		const GameObjectData& gameObjectData);
+
+	// The results of these queries are ordered by the object id.
+	void QueryBox(const glm::dvec2& minPosition, const glm::dvec2& maxPosition,
+		const GameObjectQueryFilter& filter, Core::SimpleTypeVectorU<GameObjectId>& result) const;
+	void QueryRadius(const glm::dvec2& center, double radius,
+		const GameObjectQueryFilter& filter, Core::SimpleTypeVectorU<GameObjectId>& result) const;
+
+	// Returns at most 'countObjects' objects within 'maxRadius', ordered by the distance and the object id.
+	void QueryNearest(const glm::dvec2& center, unsigned countObjects, double maxRadius,
+		const GameObjectQueryFilter& filter, Core::SimpleTypeVectorU<GameObjectId>& result) const;
+};
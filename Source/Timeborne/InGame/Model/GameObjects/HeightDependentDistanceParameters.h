@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <EngineBuildingBlocks/Math/GLM.h>
+
 struct HeightDependentDistanceParameters
 {
 	float BaseDistance = 0.0f;
@@ -14,24 +14,31 @@ GroundObjectTerrainTreeNodeMapping::GroundObjectTerrainTreeNodeMapping(const Ter
 
 void GroundObjectTerrainTreeNodeMapping::_UpdateCurrentNodeIndices(GameObjectId objectId,
 	GameObjectTypeIndex typeIndex, const GameObjectPose& pose)
+{
+	GetNodeIndices(typeIndex, pose, m_CurrentNodeIndices);
+}
+
+void GroundObjectTerrainTreeNodeMapping::GetNodeIndices(GameObjectTypeIndex typeIndex, const GameObjectPose& pose,
+	Core::IndexVectorU& nodeIndices) const
 {
 	auto& prototype = GameObjectPrototype::GetPrototypes()[(uint32_t)typeIndex];
 	auto& movementPrototype = prototype->GetMovement();
 
-	m_CurrentNodeIndices.Clear();
+	nodeIndices.Clear();
 
 	double circleRadius = (double)movementPrototype.PositionTerrainNodeMappingCircleRadius;
 	if (circleRadius > 0.0)
 	{
-		PushForCirle(circleRadius, pose);
+		PushForCirle(circleRadius, pose, nodeIndices);
 	}
 	else
 	{
-		PushForRectangle(movementPrototype.GameLogicSize, pose);
+		PushForRectangle(movementPrototype.GameLogicSize, pose, nodeIndices);
 	}
 }
 
-void GroundObjectTerrainTreeNodeMapping::PushForCirle(double circleRadius, const GameObjectPose& pose)
+void GroundObjectTerrainTreeNodeMapping::PushForCirle(double circleRadius, const GameObjectPose& pose,
+	Core::IndexVectorU& nodeIndices) const
 {
 	auto position2d = pose.GetPosition2d();
 
@@ -41,7 +48,7 @@ void GroundObjectTerrainTreeNodeMapping::PushForCirle(double circleRadius, const
 	auto startPosition = position2d;
 	auto startFieldIndex = GameObjectPose::GetTerrainFieldIndex(startPosition);
 
-	auto PushNodeIfContained = [this, &startFieldIndex, &position2d, circleRadius, circleRadiusSqr]
+	auto PushNodeIfContained = [this, &nodeIndices, &startFieldIndex, &position2d, circleRadius, circleRadiusSqr]
 	(int xOffset, int zOffset) {
 		auto fieldIndex = startFieldIndex + glm::ivec2(xOffset, zOffset);
 		auto fieldMiddle = GameObjectPose::GetMiddle2dFromTerrainFieldIndex(fieldIndex);
@@ -69,13 +76,13 @@ void GroundObjectTerrainTreeNodeMapping::PushForCirle(double circleRadius, const
 		if (intersecting)
 		{
 			auto nodeIndex = m_TerrainTree->GetNodeIndexForField(fieldIndex);
-			if (nodeIndex != Core::c_InvalidIndexU) m_CurrentNodeIndices.UnsafePushBack(nodeIndex);
+			if (nodeIndex != Core::c_InvalidIndexU) nodeIndices.UnsafePushBack(nodeIndex);
 		}
 	};
 
 	if (circleRadius < 0.5)
 	{
-		m_CurrentNodeIndices.Reserve(4);
+		nodeIndices.Reserve(4);
 		int xOffset = std::round(startPosition.x) < startPosition.x ? -1 : 1;
 		int zOffset = std::round(startPosition.y) < startPosition.y ? -1 : 1;
 		PushNodeIfContained(0, 0);
@@ -90,7 +97,8 @@ void GroundObjectTerrainTreeNodeMapping::PushForCirle(double circleRadius, const
 	}
 }
 
-void GroundObjectTerrainTreeNodeMapping::PushForRectangle(const glm::vec3& sizeF, const GameObjectPose& pose)
+void GroundObjectTerrainTreeNodeMapping::PushForRectangle(const glm::vec3& sizeF, const GameObjectPose& pose,
+	Core::IndexVectorU& nodeIndices) const
 {
 	auto position2d = pose.GetPosition2d();
 
@@ -122,26 +130,26 @@ void GroundObjectTerrainTreeNodeMapping::PushForRectangle(const glm::vec3& sizeF
 			auto currentPosition = currentPositionBase + incrementZ * (double)j;
 			auto fieldIndex = GameObjectPose::GetTerrainFieldIndex(currentPosition);
 			auto nodeIndex = m_TerrainTree->GetNodeIndexForField(fieldIndex);
-			if (nodeIndex != Core::c_InvalidIndexU) m_CurrentNodeIndices.PushBack(nodeIndex);
+			if (nodeIndex != Core::c_InvalidIndexU) nodeIndices.PushBack(nodeIndex);
 		}
 	}
 
 	// Removing duplicates.
-	m_CurrentNodeIndices.SortAndRemoveDuplicates();
+	nodeIndices.SortAndRemoveDuplicates();
 
 	// Adding missing nodes. Given the criteria in MatchesSamplingCriteria, after sampling the object, we only have to
 	// sample the 4 corners and the middle point of the field.
 	glm::dvec2 offsets[] = {
 		glm::dvec2(0.0, 0.0), glm::dvec2(0.0, 1.0), glm::dvec2(1.0, 0.0), glm::dvec2(1.0, 1.0), glm::dvec2(0.5, 0.5) };
-	for (unsigned i = 0; i < m_CurrentNodeIndices.GetSize(); i++)
+	for (unsigned i = 0; i < nodeIndices.GetSize(); i++)
 	{
-		auto& currentNode = m_TerrainTree->GetNode(m_CurrentNodeIndices[i]);
+		auto& currentNode = m_TerrainTree->GetNode(nodeIndices[i]);
 		auto neighbors = (const unsigned*)currentNode.Neighbors;
 
 		for (unsigned j = 0; j < 8; j++)
 		{
 			auto neighborNodeIndex = neighbors[j];
-			if (neighborNodeIndex == Core::c_InvalidIndexU || m_CurrentNodeIndices.Contains(neighborNodeIndex)) continue;
+			if (neighborNodeIndex == Core::c_InvalidIndexU || nodeIndices.Contains(neighborNodeIndex)) continue;
 			auto& neighborNode = m_TerrainTree->GetNode(neighborNodeIndex);
 			glm::dvec2 startPos(neighborNode.Start);
 			
@@ -153,7 +161,7 @@ void GroundObjectTerrainTreeNodeMapping::PushForRectangle(const glm::vec3& sizeF
 				auto dotZ = glm::dot(offsetToStart, right);
 				if (dotX >= 0.0 && dotX <= size.x && dotZ >= 0.0 && dotZ <= size.y)
 				{
-					m_CurrentNodeIndices.PushBack(neighborNodeIndex);
+					nodeIndices.PushBack(neighborNodeIndex);
 					break;
 				}
 			}
@@ -13,8 +13,8 @@ class GameObjectPose;
 
 class GroundObjectTerrainTreeNodeMapping : public ObjectToNodeMapping<GroundObjectTerrainTreeNodeMapping>
 {
-	void PushForCirle(double circleRadius, const GameObjectPose& pose);
-	void PushForRectangle(const glm::vec3& sizeF, const GameObjectPose& pose);
+	void PushForCirle(double circleRadius, const GameObjectPose& pose, Core::IndexVectorU& nodeIndices) const;
+	void PushForRectangle(const glm::vec3& sizeF, const GameObjectPose& pose, Core::IndexVectorU& nodeIndices) const;
 
 public:
 	explicit GroundObjectTerrainTreeNodeMapping(const TerrainTree& terrainTree);
@@ -22,5 +22,9 @@ public:
 	void _UpdateCurrentNodeIndices(GameObjectId objectId,
 		GameObjectTypeIndex typeIndex, const GameObjectPose& pose);
 
+	// Computes the node indices of the object without changing the mapping. Can be called from multiple threads.
+	void GetNodeIndices(GameObjectTypeIndex typeIndex, const GameObjectPose& pose,
+		Core::IndexVectorU& nodeIndices) const;
+
 	static bool MatchesSamplingCriteria(const GameObjectPrototype& prototype);
 };
\ No newline at end of file
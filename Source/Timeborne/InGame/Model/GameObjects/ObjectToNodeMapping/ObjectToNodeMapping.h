@@ -8,44 +8,50 @@
 #include <Timeborne/InGame/Model/GameObjects/GameObjectId.h>
 
 #include <cassert>
+#include <cstdint>
 #include <utility>
 #include <vector>
 
 class TerrainTree;
 
+// Maps dense integer keys - node indices and game object ids - to value vectors. The vectors are indexed
+// directly by the key and keep their capacity after removal, therefore lookups are O(1) and
+// no allocation happens when objects move between already used nodes.
 template <typename TKey, typename TData>
 class ObjectToNodeMapping_IndexMapping
 {
 	std::vector<Core::SimpleTypeVectorU<TData>> m_Mappings;
-	Core::IndexVectorU m_UnusedVectors;
-	Core::FastStdMap<TKey, unsigned> m_VectorIndices;
+	Core::SimpleTypeVectorU<unsigned char> m_Exists; // SoA with 'm_Mappings'.
+
+	static unsigned ToIndex(TKey key)
+	{
+		return (unsigned)(uint32_t)key;
+	}
+
+	bool Exists(unsigned index) const
+	{
+		return index < m_Exists.GetSize() && m_Exists[index] != 0;
+	}
 
 public:
 
 	void Add(TKey key, TData value)
 	{
-		auto sIt = m_VectorIndices.find(key);
-		if (sIt == m_VectorIndices.end())
+		auto index = ToIndex(key);
+		if (index >= m_Exists.GetSize())
 		{
-			unsigned mappingIndex;
-			if (m_UnusedVectors.IsEmpty())
-			{
-				mappingIndex = (unsigned)m_Mappings.size();
-				m_Mappings.emplace_back();
-			}
-			else
-			{
-				mappingIndex = m_UnusedVectors.PopBackReturn();
-			}
-			sIt = m_VectorIndices.insert(std::make_pair(key, mappingIndex)).first;
+			m_Mappings.resize(index + 1);
+			m_Exists.PushBack(0, index + 1 - m_Exists.GetSize());
 		}
-		m_Mappings[sIt->second].PushBack(value);
+		m_Exists[index] = 1;
+		m_Mappings[index].PushBack(value);
 	}
 
 	void Remove(TKey key, TData value)
 	{
-		auto mappingIndex = m_VectorIndices[key];
-		auto& values = m_Mappings[mappingIndex];
+		auto index = ToIndex(key);
+		assert(Exists(index));
+		auto& values = m_Mappings[index];
 		auto countValues = values.GetSize();
 		for (unsigned i = 0; i < countValues; i++)
 		{
@@ -57,30 +63,30 @@ public:
 		}
 		if (values.IsEmpty())
 		{
-			m_UnusedVectors.PushBack(mappingIndex);
-			m_VectorIndices.erase(key);
+			m_Exists[index] = 0;
 		}
 	}
 
 	void Remove(TKey key)
 	{
-		auto mappingIndex = m_VectorIndices[key];
-		m_Mappings[mappingIndex].Clear();
-		m_UnusedVectors.PushBack(mappingIndex);
-		m_VectorIndices.erase(key);
+		auto index = ToIndex(key);
+		assert(Exists(index));
+		m_Mappings[index].Clear();
+		m_Exists[index] = 0;
 	}
 
 	void RemoveMappings(TKey key)
 	{
-		auto mappingIndex = m_VectorIndices[key];
-		m_Mappings[mappingIndex].Clear();
+		auto index = ToIndex(key);
+		assert(Exists(index));
+		m_Mappings[index].Clear();
 	}
 
 	const Core::SimpleTypeVectorU<TData>* GetValues(TKey key) const
 	{
-		auto sIt = m_VectorIndices.find(key);
-		if (sIt == m_VectorIndices.end()) return nullptr;
-		return &m_Mappings[sIt->second];
+		auto index = ToIndex(key);
+		if (!Exists(index)) return nullptr;
+		return &m_Mappings[index];
 	}
 };
 
@@ -106,6 +112,19 @@ class ObjectToNodeMapping
 		}
 	}
 
+	void UpdateMappings(GameObjectId objectId)
+	{
+		auto oldNodeIndices = m_ObjectToNodesMapping.GetValues(objectId);
+		assert(oldNodeIndices != nullptr);
+
+		if (*oldNodeIndices != m_CurrentNodeIndices)
+		{
+			RemoveNodeToObjectMappings(objectId);
+			m_ObjectToNodesMapping.RemoveMappings(objectId);
+			AddMappings(objectId);
+		}
+	}
+
 	void RemoveNodeToObjectMappings(GameObjectId objectId)
 	{
 		auto nodeIndices = m_ObjectToNodesMapping.GetValues(objectId);
@@ -146,16 +165,15 @@ public:
 	void SetObject(GameObjectId objectId, TArgs&&... args)
 	{
 		Crtp()._UpdateCurrentNodeIndices(objectId, std::forward<TArgs>(args)...);
+		UpdateMappings(objectId);
+	}
 
-		auto oldNodeIndices = m_ObjectToNodesMapping.GetValues(objectId);
-		assert(oldNodeIndices != nullptr);
-
-		if (*oldNodeIndices != m_CurrentNodeIndices)
-		{
-			RemoveNodeToObjectMappings(objectId);
-			m_ObjectToNodesMapping.RemoveMappings(objectId);
-			AddMappings(objectId);
-		}
+	// Sets the object with node indices that have been computed in advance, e.g. in parallel.
+	void SetObjectWithNodeIndices(GameObjectId objectId, const unsigned* nodeIndices, unsigned countNodeIndices)
+	{
+		m_CurrentNodeIndices.Clear();
+		m_CurrentNodeIndices.PushBack(nodeIndices, countNodeIndices);
+		UpdateMappings(objectId);
 	}
 
 	void RemoveObject(GameObjectId objectId)
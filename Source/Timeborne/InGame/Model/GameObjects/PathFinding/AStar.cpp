@@ -7,6 +7,7 @@
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
 
 #include <Core/Constants.h>
+#include <Core/SingleElementPoolAllocator.hpp>
 
 bool HasSingleNodeSize(const TerrainTree& terrainTree, unsigned nodeIndex1, unsigned nodeIndex2)
 {
@@ -25,8 +26,90 @@ void AStar::ReconstructPath(unsigned endLocalIndex, Core::IndexVectorU& nodeIndi
 	for (unsigned i = 0; i < limit; i++) std::swap(nodeIndices[i], nodeIndices[lastIndex - i]);
 }
 
+bool AStar::IsLess(unsigned localIndex1, unsigned localIndex2) const
+{
+	auto& data1 = m_Nodes[localIndex1];
+	auto& data2 = m_Nodes[localIndex2];
+	auto totalCostDiff = (data1.CostFromStart + data1.HeuriticCostToEnd) - (data2.CostFromStart + data2.HeuriticCostToEnd);
+	int totalCostSign = totalCostDiff.GetSign();
+	if (totalCostSign != 0) return totalCostSign < 0;
+	int heuristicCostSign = (data1.HeuriticCostToEnd - data2.HeuriticCostToEnd).GetSign();
+	if (heuristicCostSign != 0) return heuristicCostSign < 0;
+	return localIndex1 < localIndex2;
+}
+
+inline void AStar::SetHeapElement(unsigned heapIndex, unsigned localIndex)
+{
+	m_OpenHeap[heapIndex] = localIndex;
+	m_Nodes[localIndex].HeapIndex = heapIndex;
+}
+
+void AStar::SiftUp(unsigned heapIndex)
+{
+	unsigned localIndex = m_OpenHeap[heapIndex];
+	while (heapIndex > 0)
+	{
+		unsigned parentHeapIndex = (heapIndex - 1) >> 1;
+		unsigned parentLocalIndex = m_OpenHeap[parentHeapIndex];
+		if (!IsLess(localIndex, parentLocalIndex)) break;
+		SetHeapElement(heapIndex, parentLocalIndex);
+		heapIndex = parentHeapIndex;
+	}
+	SetHeapElement(heapIndex, localIndex);
+}
+
+void AStar::SiftDown(unsigned heapIndex)
+{
+	unsigned countElements = m_OpenHeap.GetSize();
+	unsigned localIndex = m_OpenHeap[heapIndex];
+	while (true)
+	{
+		unsigned childHeapIndex = (heapIndex << 1) + 1;
+		if (childHeapIndex >= countElements) break;
+		if (childHeapIndex + 1 < countElements
+			&& IsLess(m_OpenHeap[childHeapIndex + 1], m_OpenHeap[childHeapIndex])) childHeapIndex++;
+		unsigned childLocalIndex = m_OpenHeap[childHeapIndex];
+		if (!IsLess(childLocalIndex, localIndex)) break;
+		SetHeapElement(heapIndex, childLocalIndex);
+		heapIndex = childHeapIndex;
+	}
+	SetHeapElement(heapIndex, localIndex);
+}
+
+void AStar::PushToOpenSet(unsigned localIndex)
+{
+	unsigned heapIndex = m_OpenHeap.GetSize();
+	m_OpenHeap.PushBack(localIndex);
+	SiftUp(heapIndex);
+}
+
+unsigned AStar::PopFromOpenSet()
+{
+	unsigned localIndex = m_OpenHeap[0];
+	m_Nodes[localIndex].HeapIndex = Core::c_InvalidIndexU;
+	unsigned lastLocalIndex = m_OpenHeap.PopBackReturn();
+	if (!m_OpenHeap.IsEmpty())
+	{
+		m_OpenHeap[0] = lastLocalIndex;
+		SiftDown(0);
+	}
+	return localIndex;
+}
+
+inline bool IsInCorridor(const TerrainTree& terrainTree, const AStarCorridor& corridor, unsigned nodeIndex)
+{
+	for (unsigned i = 0; i < corridor.CountLevelsAboveLeafs; i++) nodeIndex = terrainTree.GetNode(nodeIndex).Parent;
+	return (*corridor.NodeMarks)[nodeIndex] != Core::c_InvalidIndexU;
+}
+
+unsigned AStar::GetCountExpandedNodes() const
+{
+	return m_CountExpandedNodes;
+}
+
 void AStar::FindPath(const PathFindingContext& context, unsigned startNodeIndex, unsigned endNodeIndex,
-	const HeightDependentDistanceParameters* distanceParameters, Core::IndexVectorU& nodeIndices)
+	const HeightDependentDistanceParameters* distanceParameters, Core::IndexVectorU& nodeIndices,
+	const AStarCorridor* corridor)
 {
 #if MEASURE_PATH_FINDING_EXECUTION_TIME
 	auto startTime = std::chrono::steady_clock::now();
@@ -40,11 +123,8 @@ void AStar::FindPath(const PathFindingContext& context, unsigned startNodeIndex,
 	};
 #endif
 
-	auto MakeNodeSortData = [](const PathDistance& totalCost, const PathDistance& heuriticCostToEnd) {
-		return NodeSortData{ (float)totalCost, (float)heuriticCostToEnd };
-	};
-
 	nodeIndices.Clear();
+	m_CountExpandedNodes = 0;
 	if (startNodeIndex == endNodeIndex) return;
 
 	auto& terrainTree = context.TerrainTree;
@@ -71,6 +151,7 @@ void AStar::FindPath(const PathFindingContext& context, unsigned startNodeIndex,
 	startLocalNode.NodeIndex = startNodeIndex;
 	startLocalNode.CostFromStart = PathDistance::Zero();
 	startLocalNode.HeuriticCostToEnd = startHeuristicDistance;
+	startLocalNode.HeapIndex = Core::c_InvalidIndexU;
 
 	if (m_NodeToDataMap.GetSize() != terrainTree.GetCountNodes())
 	{
@@ -79,22 +160,21 @@ void AStar::FindPath(const PathFindingContext& context, unsigned startNodeIndex,
 	}
 	m_NodeToDataMap[startNodeIndex] = 0U;
 
-	m_OpenSet.clear();
-	m_OpenSet.insert(std::make_pair(MakeNodeSortData(startHeuristicDistance, startHeuristicDistance), 0U));
+	m_OpenHeap.Clear();
+	PushToOpenSet(0U);
 
 	m_CameFrom.Clear();
 	m_CameFrom.PushBack(Core::c_InvalidIndexU);
 
-	while (!m_OpenSet.empty())
+	while (!m_OpenHeap.IsEmpty())
 	{
-		auto currentIt = m_OpenSet.begin();
-		auto current = *currentIt;
-		m_OpenSet.erase(currentIt);
-		auto currentLocalIndex = current.second;
+		auto currentLocalIndex = PopFromOpenSet();
 		auto& currentData = m_Nodes[currentLocalIndex];
 		auto currentNodeIndex = currentData.NodeIndex;
 		auto currentCostFromStart = currentData.CostFromStart;
 
+		m_CountExpandedNodes++;
+
 #if CREATE_PATH_FINDING_STATISTICS
 		Statistics_Visit(currentLocalIndex);
 #endif
@@ -113,6 +193,8 @@ void AStar::FindPath(const PathFindingContext& context, unsigned startNodeIndex,
 			if (TerrainTree::HasDirection(nodeFlags, d))
 			{
 				unsigned neighborNodeIndex = currentNodeData.Neighbors[d];
+
+				if (corridor != nullptr && !IsInCorridor(terrainTree, *corridor, neighborNodeIndex)) continue;
 				
 				auto currentToNeighborDistance = GetPathFindingNodeDistance(context, currentNodeIndex, neighborNodeIndex);
 				auto newCostFromStateForNeighbor = currentCostFromStart + currentToNeighborDistance;
@@ -121,46 +203,33 @@ void AStar::FindPath(const PathFindingContext& context, unsigned startNodeIndex,
 				if (localIndex == Core::c_InvalidIndexU)
 				{
 					auto heuristicCost = GetPathFindingHeuristicGuess(context, neighborNodeIndex, endNodeIndex);
-					auto totalCost = newCostFromStateForNeighbor + heuristicCost;
 
 					localIndex = m_Nodes.GetSize();
 					auto& neighborData = m_Nodes.PushBackPlaceHolder();
 					neighborData.NodeIndex = neighborNodeIndex;
 					neighborData.CostFromStart = newCostFromStateForNeighbor;
 					neighborData.HeuriticCostToEnd = heuristicCost;
+					neighborData.HeapIndex = Core::c_InvalidIndexU;
 
 					m_NodeToDataMap[neighborNodeIndex] = localIndex;
 
-					m_OpenSet.insert(std::make_pair(MakeNodeSortData(totalCost, heuristicCost), localIndex));
-
 					m_CameFrom.PushBack(currentLocalIndex);
+
+					PushToOpenSet(localIndex);
 				}
 				else
 				{
 					auto& neighborData = m_Nodes[localIndex];
 					if (newCostFromStateForNeighbor < neighborData.CostFromStart)
 					{
-						const auto& heuristicCost = neighborData.HeuriticCostToEnd;
-						auto oldTotalCost = neighborData.CostFromStart + heuristicCost;
-						auto newTotalCost = newCostFromStateForNeighbor + heuristicCost;
-
 						neighborData.CostFromStart = newCostFromStateForNeighbor;
 
 						m_CameFrom[localIndex] = currentLocalIndex;
 
-						// Updating the cost in the open set.
-						{
-							auto searchedElement = MakeNodeSortData(oldTotalCost, heuristicCost);
-							auto oIt = m_OpenSet.lower_bound(searchedElement);
-							auto oEnd = m_OpenSet.end();
-							bool found = false;
-							for (; oIt != oEnd && oIt->first == searchedElement; ++oIt)
-							{
-								if (oIt->second == localIndex) { found = true; break; }
-							}
-							if(found) m_OpenSet.erase(oIt);
-						}
-						m_OpenSet.insert(std::make_pair(MakeNodeSortData(newTotalCost, heuristicCost), localIndex));
+						// Updating the cost in the open set. Since the heuristic cost is constant, the total cost
+						// can only decrease. A closed node is reopened.
+						if (neighborData.HeapIndex == Core::c_InvalidIndexU) PushToOpenSet(localIndex);
+						else SiftUp(neighborData.HeapIndex);
 					}
 				}
 			}
@@ -5,33 +5,21 @@
 #include <Timeborne/InGame/Model/GameObjects/PathFinding/PathFinding.h>
 
 #include <Core/DataStructures/SimpleTypeVector.hpp>
-#include <Core/Comparison.h>
-#include <Core/SingleElementPoolAllocator.hpp>
 
 struct HeightDependentDistanceParameters;
 
-class AStar
+// Restricts the search to the leaf nodes, whose ancestor on the given level is marked.
+struct AStarCorridor
 {
-	// Storing the node with the lowest heuristic value in the lowest total value class.
-	// We won't compute anything from this data so it ca be stored as floats.
-	struct NodeSortData
-	{
-		float TotalCost;
-		float HeuriticCostToEnd;
-
-		inline constexpr bool operator==(const NodeSortData& other) const
-		{
-			NumericalEqualCompareBlock(TotalCost);
-			return HeuriticCostToEnd == other.HeuriticCostToEnd;
-		}
-
-		inline constexpr bool operator<(const NodeSortData& other) const
-		{
-			NumericalLessCompareBlock(TotalCost);
-			return HeuriticCostToEnd < other.HeuriticCostToEnd;
-		}
-	};
+	// SoA with the terrain tree's nodes. The corridor nodes are marked with a valid index.
+	const Core::IndexVectorU* NodeMarks;
 
+	// The number of levels between the leafs and the marked nodes.
+	unsigned CountLevelsAboveLeafs;
+};
+
+class AStar
+{
 	struct NodeData
 	{
 		unsigned NodeIndex;
@@ -40,6 +28,9 @@ class AStar
 
 		// Note that the total cost - f function - is not stored explicitly,
 		// since f = g + h always holds.
+
+		// Position in 'm_OpenHeap' or invalid index if the node is not in the open set.
+		unsigned HeapIndex;
 	};
 
 	Core::SimpleTypeVectorU<NodeData> m_Nodes;
@@ -47,17 +38,32 @@ class AStar
 	// Node index -> Index in 'm_Nodes'. SoA with the terrain tree's nodes.
 	Core::IndexVectorU m_NodeToDataMap;
 
-	// TotalCost -> Index in 'm_Nodes'.
-	Core::FastStdMultiMap<NodeSortData, unsigned> m_OpenSet;
+	// Binary min-heap of the open set, storing indices in 'm_Nodes'. The nodes are ordered by the total cost,
+	// then by the heuristic cost and finally by the local index. All comparisons are exact, therefore
+	// the search is deterministic.
+	Core::IndexVectorU m_OpenHeap;
 
 	// SoA with m_Nodes. Indexed by and stores local indices.
 	Core::SimpleTypeVectorU<unsigned> m_CameFrom;
 
+	unsigned m_CountExpandedNodes = 0;
+
+	bool IsLess(unsigned localIndex1, unsigned localIndex2) const;
+	void SetHeapElement(unsigned heapIndex, unsigned localIndex);
+	void SiftUp(unsigned heapIndex);
+	void SiftDown(unsigned heapIndex);
+	void PushToOpenSet(unsigned localIndex);
+	unsigned PopFromOpenSet();
+
 	void ReconstructPath(unsigned endNodeIndex, Core::IndexVectorU& nodeIndices);
 
 public:
 	void FindPath(const PathFindingContext& context, 
 		unsigned startNodeIndex, unsigned endNodeIndex,
 		const HeightDependentDistanceParameters* distanceParameters,
-		Core::IndexVectorU& nodeIndices);
+		Core::IndexVectorU& nodeIndices,
+		const AStarCorridor* corridor = nullptr);
+
+	// Returns the number of nodes taken from the open set in the last search.
+	unsigned GetCountExpandedNodes() const;
 };
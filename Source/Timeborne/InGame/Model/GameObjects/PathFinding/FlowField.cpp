@@ -0,0 +1,136 @@
+// Timeborne/InGame/Model/GameObjects/PathFinding/FlowField.cpp
+
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/FlowField.h>
+
+#include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
+
+#include <Core/Constants.h>
+
+void FlowField::Reset(unsigned countNodes)
+{
+	if (m_NextNodeIndices.GetSize() != countNodes)
+	{
+		m_CostToTarget.Clear();
+		m_CostToTarget.PushBack(PathDistance::Zero(), countNodes);
+		m_NextNodeIndices.Clear();
+		m_NextNodeIndices.PushBack(Core::c_InvalidIndexU, countNodes);
+		m_NodeStates.Clear();
+		m_NodeStates.PushBack(0, countNodes);
+	}
+	else
+	{
+		auto countTouchedNodes = m_TouchedNodeIndices.GetSize();
+		for (unsigned i = 0; i < countTouchedNodes; i++)
+		{
+			auto nodeIndex = m_TouchedNodeIndices[i];
+			m_CostToTarget[nodeIndex] = PathDistance::Zero();
+			m_NextNodeIndices[nodeIndex] = Core::c_InvalidIndexU;
+			m_NodeStates[nodeIndex] = 0;
+		}
+	}
+	m_TouchedNodeIndices.Clear();
+
+	while (!m_OpenSet.empty()) m_OpenSet.pop();
+}
+
+bool FlowField::IsSettled(unsigned nodeIndex) const
+{
+	return nodeIndex < m_NodeStates.GetSize() && (m_NodeStates[nodeIndex] & c_SettledState) != 0;
+}
+
+void FlowField::Compute(const PathFindingContext& context, unsigned targetNodeIndex,
+	const Core::IndexVectorU& sourceNodeIndices)
+{
+	auto& terrainTree = context.TerrainTree;
+
+	Reset(terrainTree.GetCountNodes());
+	m_TargetNodeIndex = targetNodeIndex;
+	m_CountExpandedNodes = 0;
+
+	// The target points to itself.
+	m_NextNodeIndices[targetNodeIndex] = targetNodeIndex;
+	m_TouchedNodeIndices.PushBack(targetNodeIndex);
+
+	// Marking the sources. Only the sources on the target's island can be reached.
+	auto targetIslandIndex = terrainTree.GetIslandIndex(targetNodeIndex);
+	unsigned countUnsettledSources = 0;
+	auto countSources = sourceNodeIndices.GetSize();
+	for (unsigned i = 0; i < countSources; i++)
+	{
+		auto sourceNodeIndex = sourceNodeIndices[i];
+		auto& state = m_NodeStates[sourceNodeIndex];
+		if ((state & c_SourceState) == 0 && terrainTree.GetIslandIndex(sourceNodeIndex) == targetIslandIndex)
+		{
+			state |= c_SourceState;
+			if (m_NextNodeIndices[sourceNodeIndex] == Core::c_InvalidIndexU) m_TouchedNodeIndices.PushBack(sourceNodeIndex);
+			countUnsettledSources++;
+		}
+	}
+	m_OpenSet.push({ PathDistance::Zero(), targetNodeIndex });
+
+	while (!m_OpenSet.empty() && countUnsettledSources > 0)
+	{
+		auto current = m_OpenSet.top();
+		m_OpenSet.pop();
+		auto currentNodeIndex = current.NodeIndex;
+
+		// The open set may contain multiple entries for a node: only the first one is processed.
+		auto& currentState = m_NodeStates[currentNodeIndex];
+		if ((currentState & c_SettledState) != 0) continue;
+		currentState |= c_SettledState;
+
+		m_CountExpandedNodes++;
+
+		if ((currentState & c_SourceState) != 0) countUnsettledSources--;
+
+		// Relaxing the incoming edges: a neighbor is a predecessor if it is connected towards the current node.
+		auto& currentNode = terrainTree.GetNode(currentNodeIndex);
+		for (unsigned d = 0; d < 8; d++)
+		{
+			if (!TerrainTree::HasDirection(currentNode.Flags, d)) continue;
+
+			unsigned neighborNodeIndex = currentNode.Neighbors[d];
+			if (IsSettled(neighborNodeIndex)) continue;
+			if (!TerrainTree::HasDirection(terrainTree.GetNode(neighborNodeIndex).Flags, (d + 4) & 7)) continue;
+
+			auto newCost = current.CostToTarget
+				+ GetPathFindingNodeDistance(context, neighborNodeIndex, currentNodeIndex);
+
+			auto& nextNodeIndex = m_NextNodeIndices[neighborNodeIndex];
+			if (nextNodeIndex == Core::c_InvalidIndexU)
+			{
+				if (m_NodeStates[neighborNodeIndex] == 0) m_TouchedNodeIndices.PushBack(neighborNodeIndex);
+			}
+			else if (!(newCost < m_CostToTarget[neighborNodeIndex]))
+			{
+				continue;
+			}
+
+			nextNodeIndex = currentNodeIndex;
+			m_CostToTarget[neighborNodeIndex] = newCost;
+			m_OpenSet.push({ newCost, neighborNodeIndex });
+		}
+	}
+}
+
+bool FlowField::GetPath(unsigned sourceNodeIndex, Core::IndexVectorU& nodeIndices) const
+{
+	nodeIndices.Clear();
+	if (m_TargetNodeIndex == Core::c_InvalidIndexU || !IsSettled(sourceNodeIndex)) return false;
+
+	if (sourceNodeIndex == m_TargetNodeIndex) return true;
+
+	for (unsigned i = sourceNodeIndex; i != m_TargetNodeIndex; i = m_NextNodeIndices[i]) nodeIndices.PushBack(i);
+	nodeIndices.PushBack(m_TargetNodeIndex);
+	return true;
+}
+
+unsigned FlowField::GetTargetNodeIndex() const
+{
+	return m_TargetNodeIndex;
+}
+
+unsigned FlowField::GetCountExpandedNodes() const
+{
+	return m_CountExpandedNodes;
+}
@@ -0,0 +1,66 @@
+// Timeborne/InGame/Model/GameObjects/PathFinding/FlowField.h
+
+#pragma once
+
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/PathFinding.h>
+
+#include <Core/Constants.h>
+
+#include <queue>
+#include <vector>
+
+// Computes the shortest paths from multiple leaf nodes to a common target leaf node with a single
+// reverse Dijkstra search, which is started from the target. The search is stopped when all
+// source nodes are settled, so the explored region is the same as for the farthest source only.
+class FlowField
+{
+	struct OpenNode
+	{
+		PathDistance CostToTarget;
+		unsigned NodeIndex;
+
+		// Priority queue order: the lowest cost has the highest priority, ties are broken
+		// by the node index to keep the search deterministic.
+		inline bool operator<(const OpenNode& other) const
+		{
+			int costSign = (CostToTarget - other.CostToTarget).GetSign();
+			if (costSign != 0) return costSign > 0;
+			return NodeIndex > other.NodeIndex;
+		}
+	};
+
+	// SoA with the terrain tree's nodes.
+	Core::SimpleTypeVectorU<PathDistance> m_CostToTarget;
+	Core::IndexVectorU m_NextNodeIndices;  // Invalid for nodes which are not reached.
+	Core::SimpleTypeVectorU<unsigned char> m_NodeStates;
+
+	static constexpr unsigned char c_SourceState = 0x01;
+	static constexpr unsigned char c_SettledState = 0x02;
+
+	bool IsSettled(unsigned nodeIndex) const;
+
+	// Nodes with changed data, used for reverting the changes.
+	Core::IndexVectorU m_TouchedNodeIndices;
+
+	std::priority_queue<OpenNode, std::vector<OpenNode>> m_OpenSet;
+
+	unsigned m_TargetNodeIndex = Core::c_InvalidIndexU;
+	unsigned m_CountExpandedNodes = 0;
+
+	void Reset(unsigned countNodes);
+
+public:
+
+	// Computes the field for the given source nodes. Sources that are not reachable from the target
+	// are ignored.
+	void Compute(const PathFindingContext& context, unsigned targetNodeIndex,
+		const Core::IndexVectorU& sourceNodeIndices);
+
+	// Returns false if the source node was not reached by the last computation.
+	bool GetPath(unsigned sourceNodeIndex, Core::IndexVectorU& nodeIndices) const;
+
+	unsigned GetTargetNodeIndex() const;
+
+	// Returns the number of nodes taken from the open set in the last computation.
+	unsigned GetCountExpandedNodes() const;
+};
@@ -0,0 +1,95 @@
+// Timeborne/InGame/Model/GameObjects/PathFinding/PathCache.cpp
+
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/PathCache.h>
+
+#include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
+
+#include <iterator>
+#include <tuple>
+
+bool PathCache::Key::operator<(const Key& other) const
+{
+	auto& p = DistanceParameters;
+	auto& op = other.DistanceParameters;
+	return std::tie(StartNodeIndex, EndNodeIndex, HasDistanceParameters,
+		p.BaseDistance, p.HeightDistanceFactor, p.HeightDistanceMin, p.HeightDistanceMax)
+		< std::tie(other.StartNodeIndex, other.EndNodeIndex, other.HasDistanceParameters,
+			op.BaseDistance, op.HeightDistanceFactor, op.HeightDistanceMin, op.HeightDistanceMax);
+}
+
+PathCache::Key PathCache::CreateKey(unsigned startNodeIndex, unsigned endNodeIndex,
+	const HeightDependentDistanceParameters* distanceParameters)
+{
+	Key key;
+	key.StartNodeIndex = startNodeIndex;
+	key.EndNodeIndex = endNodeIndex;
+	key.HasDistanceParameters = (distanceParameters != nullptr);
+	key.DistanceParameters = (distanceParameters != nullptr)
+		? *distanceParameters : HeightDependentDistanceParameters();
+	return key;
+}
+
+void PathCache::Validate(const TerrainTree& terrainTree)
+{
+	auto changeStamp = terrainTree.GetChangeStamp();
+	if (m_TerrainTreeChangeStamp != changeStamp)
+	{
+		Clear();
+		m_TerrainTreeChangeStamp = changeStamp;
+	}
+}
+
+void PathCache::Clear()
+{
+	m_Entries.clear();
+	m_EntryMap.clear();
+}
+
+bool PathCache::Find(unsigned startNodeIndex, unsigned endNodeIndex,
+	const HeightDependentDistanceParameters* distanceParameters, Core::IndexVectorU& nodeIndices)
+{
+	auto eIt = m_EntryMap.find(CreateKey(startNodeIndex, endNodeIndex, distanceParameters));
+	if (eIt == m_EntryMap.end())
+	{
+		m_Statistics.CountMisses++;
+		return false;
+	}
+
+	auto entryIt = eIt->second;
+	m_Entries.splice(m_Entries.begin(), m_Entries, entryIt);
+
+	nodeIndices.Clear();
+	nodeIndices.PushBack(entryIt->NodeIndices);
+
+	m_Statistics.CountHits++;
+	return true;
+}
+
+void PathCache::Add(unsigned startNodeIndex, unsigned endNodeIndex,
+	const HeightDependentDistanceParameters* distanceParameters, const Core::IndexVectorU& nodeIndices)
+{
+	auto key = CreateKey(startNodeIndex, endNodeIndex, distanceParameters);
+	if (m_EntryMap.find(key) != m_EntryMap.end()) return;
+
+	if (m_Entries.size() < c_Capacity)
+	{
+		m_Entries.emplace_front();
+	}
+	else
+	{
+		// Reusing the least recently used entry.
+		m_EntryMap.erase(m_Entries.back().EntryKey);
+		m_Entries.splice(m_Entries.begin(), m_Entries, std::prev(m_Entries.end()));
+	}
+
+	auto& entry = m_Entries.front();
+	entry.EntryKey = key;
+	entry.NodeIndices.Clear();
+	entry.NodeIndices.PushBack(nodeIndices);
+	m_EntryMap[key] = m_Entries.begin();
+}
+
+const PathCache::Statistics& PathCache::GetStatistics() const
+{
+	return m_Statistics;
+}
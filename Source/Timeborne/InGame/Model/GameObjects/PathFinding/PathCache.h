@@ -0,0 +1,74 @@
+// Timeborne/InGame/Model/GameObjects/PathFinding/PathCache.h
+
+#pragma once
+
+#include <Timeborne/InGame/Model/GameObjects/HeightDependentDistanceParameters.h>
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+
+#include <cstdint>
+#include <list>
+#include <map>
+
+class TerrainTree;
+
+// LRU cache of the terrain tree node paths. The key is the exact query: the start and end nodes and the distance
+// parameters. Since the path finding is a pure function of the terrain tree and the query, a hit returns the same
+// path as a new search, so the cache doesn't affect the game state. The cache is cleared whenever the terrain tree
+// changes.
+class PathCache
+{
+public:
+
+	static constexpr unsigned c_Capacity = 256;
+
+	struct Statistics
+	{
+		uint64_t CountHits = 0;
+		uint64_t CountMisses = 0;
+	};
+
+private:
+
+	struct Key
+	{
+		unsigned StartNodeIndex;
+		unsigned EndNodeIndex;
+		bool HasDistanceParameters;
+		HeightDependentDistanceParameters DistanceParameters;
+
+		bool operator<(const Key& other) const;
+	};
+
+	struct Entry
+	{
+		Key EntryKey;
+		Core::IndexVectorU NodeIndices;
+	};
+
+	// The most recently used entry is the first one.
+	std::list<Entry> m_Entries;
+	std::map<Key, std::list<Entry>::iterator> m_EntryMap;
+
+	uint64_t m_TerrainTreeChangeStamp = 0;
+
+	Statistics m_Statistics;
+
+	static Key CreateKey(unsigned startNodeIndex, unsigned endNodeIndex,
+		const HeightDependentDistanceParameters* distanceParameters);
+
+public:
+
+	// Clears the cache if the terrain tree has changed since the last validation.
+	void Validate(const TerrainTree& terrainTree);
+	void Clear();
+
+	bool Find(unsigned startNodeIndex, unsigned endNodeIndex,
+		const HeightDependentDistanceParameters* distanceParameters,
+		Core::IndexVectorU& nodeIndices);
+	void Add(unsigned startNodeIndex, unsigned endNodeIndex,
+		const HeightDependentDistanceParameters* distanceParameters,
+		const Core::IndexVectorU& nodeIndices);
+
+	const Statistics& GetStatistics() const;
+};
@@ -4,19 +4,34 @@
 
 #include <Timeborne/InGame/Model/GameObjects/GameObject.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectPose.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObjectRoute.h>
 #include <Timeborne/InGame/Model/GameObjects/Prototype/GameObjectPrototype.h>
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
 #include <Timeborne/InGame/GameState/ServerGameState.h>
 #include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/Profiler.h>
 
 #include <Core/Constants.h>
+#include <Core/System/ThreadPool.h>
 
 PathFinder::PathFinder(const Level& level, const GameObjectData& gameObjectData)
 	: m_Level(level)
 	, m_GameObjectData(gameObjectData)
+	, m_Workspaces(1)
 {
 }
 
+glm::ivec2 PathFinder::GetSourceField(GameObjectId objectId) const
+{
+	assert(m_GameObjectData.ClientModelGameState != nullptr);
+	const auto& gameObjectsMap = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
+
+	auto slotIndex = gameObjectsMap.GetSlotIndex(objectId);
+	assert(slotIndex != Core::c_InvalidIndexU);
+
+	return gameObjectsMap.GetPoses()[slotIndex].GetTerrainFieldIndex();
+}
+
 float PathFinder::GetPathFindingHeight(const glm::ivec2& fieldIndex) const
 {	
 	// Must be consistent with the formula in A-star.
@@ -34,9 +49,38 @@ float PathFinder::GetPathFindingHeight(const GameObjectPose& pose) const
 
 bool PathFinder::FindPath(GameObjectId objectId, const glm::ivec2& targetField,
 	const HeightDependentDistanceParameters* distanceParameters, GameObjectPath& result)
+{
+	ProfilerZone zone("FindPath");
+
+	bool searchNeeded;
+	if (!PrepareQuery(objectId, targetField, distanceParameters, result, searchNeeded)) return false;
+	if (!searchNeeded) return true;
+
+	PathFindingContext context{ m_GameObjectData, m_Level, *m_Level.GetTerrainTree() };
+	auto& terrainTree = context.TerrainTree;
+
+	auto searchStartNode = terrainTree.GetNodeIndexForField(result.SourceField);
+	auto searchEndNode = terrainTree.GetNodeIndexForField(result.TargetField);
+
+	if (!FindCachedPath(searchStartNode, searchEndNode, distanceParameters, m_TempIndices))
+	{
+		Solve(context, m_Algorithm, m_Workspaces[0], searchStartNode, searchEndNode, distanceParameters,
+			m_TempIndices);
+		m_PathCache.Add(searchStartNode, searchEndNode, distanceParameters, m_TempIndices);
+	}
+
+	SetPathFields(terrainTree, m_TempIndices, result);
+
+	return true;
+}
+
+bool PathFinder::PrepareQuery(GameObjectId objectId, const glm::ivec2& targetField,
+	const HeightDependentDistanceParameters* distanceParameters, GameObjectPath& result, bool& searchNeeded) const
 {
 	assert(m_Level.GetTerrainTree() != nullptr);
 
+	searchNeeded = false;
+
 	assert(m_GameObjectData.ClientModelGameState != nullptr);
 	const auto& gameObjectsMap = m_GameObjectData.ClientModelGameState->GetGameObjects().Get();
 
@@ -48,8 +92,6 @@ bool PathFinder::FindPath(GameObjectId objectId, const glm::ivec2& targetField,
 
 	auto sourceField = sourceObject.Data.Pose.GetTerrainFieldIndex();
 
-	PathFindingContext context{ m_GameObjectData, m_Level, *m_Level.GetTerrainTree() };
-
 	result.ObjectId = objectId;
 	result.SourceField = sourceField;
 	result.TargetField = targetField;
@@ -69,7 +111,7 @@ bool PathFinder::FindPath(GameObjectId objectId, const glm::ivec2& targetField,
 
 	// Checking whether the source/approaching and target nodes are on the same island.
 	{
-		auto& terrainTree = context.TerrainTree;
+		auto& terrainTree = *m_Level.GetTerrainTree();
 
 		auto startNodeIndex = terrainTree.GetNodeIndexForField(result.SourceField);
 		auto startIslandIndex = terrainTree.GetIslandIndex(startNodeIndex);
@@ -119,32 +161,208 @@ bool PathFinder::FindPath(GameObjectId objectId, const glm::ivec2& targetField,
 		}
 	}
 
-	switch (m_Algorithm)
-	{
-		case Algorithm::AStarOnly: SolveWithAStar(context, distanceParameters, result); break;
-		case Algorithm::SimpleHierarchicalPathFinder:
-			m_SimpleHierarchicalPathFinder.FindPath(context, distanceParameters, result); break;
-	}
-
+	searchNeeded = true;
 	return true;
 }
 
-void PathFinder::SolveWithAStar(const PathFindingContext& context,
-	const HeightDependentDistanceParameters* distanceParameters, GameObjectPath& result)
+bool PathFinder::FindCachedPath(unsigned startNodeIndex, unsigned endNodeIndex,
+	const HeightDependentDistanceParameters* distanceParameters, Core::IndexVectorU& nodeIndices)
 {
-	auto& terrainTree = context.TerrainTree;
+	m_PathCache.Validate(*m_Level.GetTerrainTree());
+	return m_PathCache.Find(startNodeIndex, endNodeIndex, distanceParameters, nodeIndices);
+}
 
-	auto searchStartNode = terrainTree.GetNodeIndexForField(result.SourceField);
-	auto searchEndNode = terrainTree.GetNodeIndexForField(result.TargetField);
+const PathCache::Statistics& PathFinder::GetPathCacheStatistics() const
+{
+	return m_PathCache.GetStatistics();
+}
 
-	m_AStar.FindPath(context, searchStartNode, searchEndNode, distanceParameters, m_TempIndices);
+void PathFinder::Solve(const PathFindingContext& context, Algorithm algorithm, Workspace& workspace,
+	unsigned startNodeIndex, unsigned endNodeIndex, const HeightDependentDistanceParameters* distanceParameters,
+	Core::IndexVectorU& nodeIndices) const
+{
+	switch (algorithm)
+	{
+		case Algorithm::AStarOnly:
+			workspace.AStarSearch.FindPath(context, startNodeIndex, endNodeIndex, distanceParameters, nodeIndices); break;
+		case Algorithm::SimpleHierarchicalPathFinder:
+			workspace.HierarchicalPathFinder.FindPath(context, workspace.AStarSearch, startNodeIndex, endNodeIndex,
+				distanceParameters, nodeIndices); break;
+	}
+}
 
-	auto countFieldsInPath = m_TempIndices.GetSize();
+void PathFinder::SetPathFields(const TerrainTree& terrainTree, const Core::IndexVectorU& nodeIndices,
+	GameObjectPath& result) const
+{
+	result.Fields.Clear();
+	auto countFieldsInPath = nodeIndices.GetSize();
 	for (unsigned i = 0; i < countFieldsInPath; i++)
 	{
-		auto nodeIndex = m_TempIndices[i];
+		auto nodeIndex = nodeIndices[i];
 		auto& fieldData = result.Fields.PushBackPlaceHolder();
 		fieldData.TerrainTreeNodeIndex = nodeIndex;
 		fieldData.FieldIndex = terrainTree.GetNode(nodeIndex).Start;
 	}
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void PathFinder::ComputeGroupPaths(const Core::SimpleTypeVectorU<GameObjectId>& objectIds,
+	const glm::ivec2& targetField)
+{
+	assert(m_Level.GetTerrainTree() != nullptr);
+	auto& terrainTree = *m_Level.GetTerrainTree();
+
+	PathFindingContext context{ m_GameObjectData, m_Level, terrainTree };
+
+	m_TempIndices.Clear();
+	auto countObjects = objectIds.GetSize();
+	for (unsigned i = 0; i < countObjects; i++)
+	{
+		m_TempIndices.PushBack(terrainTree.GetNodeIndexForField(GetSourceField(objectIds[i])));
+	}
+
+	m_GroupTargetField = targetField;
+	m_FlowField.Compute(context, terrainTree.GetNodeIndexForField(targetField), m_TempIndices);
+}
+
+bool PathFinder::FindGroupPath(GameObjectId objectId, GameObjectPath& result)
+{
+	assert(m_Level.GetTerrainTree() != nullptr);
+	auto& terrainTree = *m_Level.GetTerrainTree();
+
+	auto sourceField = GetSourceField(objectId);
+
+	result.ObjectId = objectId;
+	result.SourceField = sourceField;
+	result.TargetField = m_GroupTargetField;
+	result.Fields.Clear();
+
+	if (sourceField == m_GroupTargetField) return true;
+
+	// Objects that were not reached by the group search are handled individually.
+	if (!m_FlowField.GetPath(terrainTree.GetNodeIndexForField(sourceField), m_TempIndices))
+	{
+		return FindPath(objectId, m_GroupTargetField, nullptr, result);
+	}
+
+	SetPathFields(terrainTree, m_TempIndices, result);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool PathFinder::RequestPath(GameObjectId objectId, const glm::ivec2& targetField,
+	const HeightDependentDistanceParameters* distanceParameters, RouteAddReason addReason,
+	GameObjectPath& result, bool& pending)
+{
+	assert(m_PathRequestIndices.find(objectId) == m_PathRequestIndices.end());
+
+	pending = false;
+
+	bool searchNeeded;
+	if (!PrepareQuery(objectId, targetField, distanceParameters, result, searchNeeded)) return false;
+	if (!searchNeeded) return true;
+
+	auto& terrainTree = *m_Level.GetTerrainTree();
+
+	if (m_CountPathRequests == (unsigned)m_PathRequests.size()) m_PathRequests.emplace_back();
+	m_PathRequestIndices[objectId] = m_CountPathRequests;
+	auto& request = m_PathRequests[m_CountPathRequests++];
+	request.ObjectId = objectId;
+	request.StartNodeIndex = terrainTree.GetNodeIndexForField(result.SourceField);
+	request.EndNodeIndex = terrainTree.GetNodeIndexForField(result.TargetField);
+	request.HasDistanceParameters = (distanceParameters != nullptr);
+	request.Cancelled = false;
+	request.Cached = false;
+	request.DistanceParameters = (distanceParameters != nullptr)
+		? *distanceParameters : HeightDependentDistanceParameters();
+	request.AddReason = addReason;
+	request.NodeIndices.Clear();
+
+	pending = true;
+	return true;
+}
+
+bool PathFinder::CancelPathRequest(GameObjectId objectId)
+{
+	auto rIt = m_PathRequestIndices.find(objectId);
+	if (rIt == m_PathRequestIndices.end()) return false;
+
+	m_PathRequests[rIt->second].Cancelled = true;
+	m_PathRequestIndices.erase(rIt);
+	return true;
+}
+
+void PathFinder::SolvePathRequestsInThread(unsigned threadId,
+	unsigned startTaskIndex, unsigned endTaskIndex) const
+{
+	PathFindingContext context{ m_GameObjectData, m_Level, *m_Level.GetTerrainTree() };
+	auto& workspace = m_Workspaces[threadId];
+
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		auto& request = m_PathRequests[i];
+		if (request.Cancelled || request.Cached) continue;
+
+		ProfilerZone zone("PathQuery");
+		Solve(context, m_Algorithm, workspace, request.StartNodeIndex, request.EndNodeIndex,
+			request.HasDistanceParameters ? &request.DistanceParameters : nullptr, request.NodeIndices);
+	}
+}
+
+void PathFinder::SolvePathRequests(Core::ThreadPool* threadPool, GameObjectRouteList& routes,
+	std::vector<PathQuery>* recordedQueries)
+{
+	if (m_CountPathRequests == 0) return;
+
+	for (unsigned i = 0; i < m_CountPathRequests; i++)
+	{
+		auto& request = m_PathRequests[i];
+		if (request.Cancelled) continue;
+
+		request.Cached = FindCachedPath(request.StartNodeIndex, request.EndNodeIndex,
+			request.HasDistanceParameters ? &request.DistanceParameters : nullptr, request.NodeIndices);
+	}
+
+	// The searches are independent and only read the level and the terrain tree.
+	if (threadPool != nullptr && m_CountPathRequests > 1)
+	{
+		auto countThreads = threadPool->GetCountThreads();
+		if ((unsigned)m_Workspaces.size() < countThreads) m_Workspaces.resize(countThreads);
+		threadPool->ExecuteWithDynamicScheduling(m_CountPathRequests, &PathFinder::SolvePathRequestsInThread, this, 1);
+	}
+	else
+	{
+		SolvePathRequestsInThread(0, 0, m_CountPathRequests);
+	}
+
+	// Committing the results in request order, so that the game state is independent of the thread scheduling.
+	// The requests are no longer pending when the listeners are notified.
+	m_PathRequestIndices.clear();
+	auto& terrainTree = *m_Level.GetTerrainTree();
+	for (unsigned i = 0; i < m_CountPathRequests; i++)
+	{
+		auto& request = m_PathRequests[i];
+		if (request.Cancelled) continue;
+
+		auto& path = routes.AccessRoute(request.ObjectId).Path;
+		assert(path.ObjectId == request.ObjectId);
+		SetPathFields(terrainTree, request.NodeIndices, path);
+		routes.FinishAdd(request.ObjectId, request.AddReason);
+
+		if (recordedQueries != nullptr)
+		{
+			recordedQueries->push_back({ request.StartNodeIndex, request.EndNodeIndex, request.HasDistanceParameters,
+				request.DistanceParameters });
+		}
+
+		if (!request.Cached)
+		{
+			m_PathCache.Add(request.StartNodeIndex, request.EndNodeIndex,
+				request.HasDistanceParameters ? &request.DistanceParameters : nullptr, request.NodeIndices);
+		}
+	}
+
+	m_CountPathRequests = 0;
+}
@@ -4,7 +4,15 @@
 
 #include <Timeborne/InGame/Model/GameObjects/PathFinding/PathFinding.h>
 #include <Timeborne/InGame/Model/GameObjects/PathFinding/AStar.h>
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/FlowField.h>
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/PathCache.h>
 #include <Timeborne/InGame/Model/GameObjects/PathFinding/SimpleHierarchicalPathFinder.h>
+#include <Timeborne/InGame/Model/GameObjects/HeightDependentDistanceParameters.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObjectRoute.h>
+
+#include <Timeborne/Declarations/CoreDeclarations.h>
+
+#include <vector>
 
 struct GameObjectData;
 class GameObjectPose;
@@ -15,8 +23,24 @@ class PathFinder
 	const Level& m_Level;
 	const GameObjectData& m_GameObjectData;
 
-	AStar m_AStar;
-	SimpleHierarchicalPathFinder m_SimpleHierarchicalPathFinder;
+	// Search data for a thread. The first workspace is also used for the immediately solved queries.
+	struct Workspace
+	{
+		AStar AStarSearch;
+		SimpleHierarchicalPathFinder HierarchicalPathFinder;
+	};
+
+	mutable std::vector<Workspace> m_Workspaces;
+
+	// Only accessed on the calling thread.
+	PathCache m_PathCache;
+
+	bool FindCachedPath(unsigned startNodeIndex, unsigned endNodeIndex,
+		const HeightDependentDistanceParameters* distanceParameters, Core::IndexVectorU& nodeIndices);
+
+	// Group path requests.
+	FlowField m_FlowField;
+	glm::ivec2 m_GroupTargetField = glm::ivec2(-1);
 
 	Core::IndexVectorU m_TempIndices;
 
@@ -24,14 +48,47 @@ class PathFinder
 	{
 		AStarOnly,
 		SimpleHierarchicalPathFinder
-	} m_Algorithm = Algorithm::AStarOnly;
+	} m_Algorithm = Algorithm::SimpleHierarchicalPathFinder;
 
-	void SolveWithAStar(const PathFindingContext& context, 
-		const HeightDependentDistanceParameters* distanceParameters, 
-		GameObjectPath& result);
+	bool PrepareQuery(GameObjectId objectId, const glm::ivec2& targetField,
+		const HeightDependentDistanceParameters* distanceParameters,
+		GameObjectPath& result, bool& searchNeeded) const;
+
+	void Solve(const PathFindingContext& context, Algorithm algorithm, Workspace& workspace,
+		unsigned startNodeIndex, unsigned endNodeIndex,
+		const HeightDependentDistanceParameters* distanceParameters,
+		Core::IndexVectorU& nodeIndices) const;
+
+	void SetPathFields(const TerrainTree& terrainTree, const Core::IndexVectorU& nodeIndices,
+		GameObjectPath& result) const;
 
+	glm::ivec2 GetSourceField(GameObjectId objectId) const;
 	float GetPathFindingHeight(const glm::ivec2& fieldIndex) const;
 
+private: // Path request queue.
+
+	struct PathRequest
+	{
+		GameObjectId ObjectId;
+		unsigned StartNodeIndex;
+		unsigned EndNodeIndex;
+		bool HasDistanceParameters;
+		bool Cancelled;
+		bool Cached;
+		RouteAddReason AddReason;
+		HeightDependentDistanceParameters DistanceParameters;
+		Core::IndexVectorU NodeIndices;
+	};
+
+	// The request objects are reused, only the first 'm_CountPathRequests' are valid.
+	mutable std::vector<PathRequest> m_PathRequests;
+	unsigned m_CountPathRequests = 0;
+
+	// The pending request index of the objects. The requests are still solved and committed in request order.
+	Core::FastStdMap<GameObjectId, unsigned> m_PathRequestIndices;
+
+	void SolvePathRequestsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex) const;
+
 public:
 
 	PathFinder(const Level& level, const GameObjectData& gameObjectData);
@@ -39,5 +96,27 @@ public:
 		const HeightDependentDistanceParameters* distanceParameters,
 		GameObjectPath& result);
 
+	// Group path requests: a single search is executed for all objects that move to the same target,
+	// then the individual paths are extracted with 'FindGroupPath'.
+	void ComputeGroupPaths(const Core::SimpleTypeVectorU<GameObjectId>& objectIds, const glm::ivec2& targetField);
+	bool FindGroupPath(GameObjectId objectId, GameObjectPath& result);
+
+	// Path requests are only validated immediately. If a search is needed, 'pending' is set, the result path is empty
+	// and the route must not be published until 'SolvePathRequests'. An object can have a single pending request.
+	bool RequestPath(GameObjectId objectId, const glm::ivec2& targetField,
+		const HeightDependentDistanceParameters* distanceParameters, RouteAddReason addReason,
+		GameObjectPath& result, bool& pending);
+
+	// Returns whether the object had a pending request.
+	bool CancelPathRequest(GameObjectId objectId);
+
+	// Solves the queued requests in parallel, then sets the paths of the pending routes and publishes them in request
+	// order. The results are looked up in and added to the path cache on the calling thread.
+	// The thread pool can be null. If the recorded queries are not null, the solved queries are appended to them.
+	void SolvePathRequests(Core::ThreadPool* threadPool, GameObjectRouteList& routes,
+		std::vector<PathQuery>* recordedQueries);
+
 	float GetPathFindingHeight(const GameObjectPose& pose) const;
+
+	const PathCache::Statistics& GetPathCacheStatistics() const;
 };
\ No newline at end of file
@@ -38,6 +38,30 @@ void GameObjectPath::DeserializeSB(const unsigned char*& bytes)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void PathQuery::SerializeSB(Core::ByteVector& bytes) const
+{
+	Core::SerializeSB(bytes, StartNodeIndex);
+	Core::SerializeSB(bytes, EndNodeIndex);
+	Core::SerializeSB(bytes, HasDistanceParameters);
+	Core::SerializeSB(bytes, DistanceParameters.BaseDistance);
+	Core::SerializeSB(bytes, DistanceParameters.HeightDistanceFactor);
+	Core::SerializeSB(bytes, DistanceParameters.HeightDistanceMin);
+	Core::SerializeSB(bytes, DistanceParameters.HeightDistanceMax);
+}
+
+void PathQuery::DeserializeSB(const unsigned char*& bytes)
+{
+	Core::DeserializeSB(bytes, StartNodeIndex);
+	Core::DeserializeSB(bytes, EndNodeIndex);
+	Core::DeserializeSB(bytes, HasDistanceParameters);
+	Core::DeserializeSB(bytes, DistanceParameters.BaseDistance);
+	Core::DeserializeSB(bytes, DistanceParameters.HeightDistanceFactor);
+	Core::DeserializeSB(bytes, DistanceParameters.HeightDistanceMin);
+	Core::DeserializeSB(bytes, DistanceParameters.HeightDistanceMax);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 PathDistance GetPathFindingHeuristicGuess(const PathFindingContext& context,
 	unsigned startNodeIndex, unsigned endNodeIndex)
 {
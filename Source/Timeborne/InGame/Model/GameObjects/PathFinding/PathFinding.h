@@ -6,6 +6,7 @@
 #define CREATE_PATH_FINDING_STATISTICS 0
 
 #include <Timeborne/InGame/Model/GameObjects/GameObjectId.h>
+#include <Timeborne/InGame/Model/GameObjects/HeightDependentDistanceParameters.h>
 #include <Timeborne/Math/SqrtExtendedIntegerRing.hpp>
 
 #include <Core/DataStructures/ResourceUnorderedVector.hpp>
@@ -32,6 +33,18 @@ struct GameObjectPath
 	void DeserializeSB(const unsigned char*& bytes);
 };
 
+// A path finding query between terrain tree nodes. The queries can be recorded for benchmarking the algorithms.
+struct PathQuery
+{
+	unsigned StartNodeIndex;
+	unsigned EndNodeIndex;
+	bool HasDistanceParameters;
+	HeightDependentDistanceParameters DistanceParameters;
+
+	void SerializeSB(Core::ByteVector& bytes) const;
+	void DeserializeSB(const unsigned char*& bytes);
+};
+
 struct GameObjectData;
 class Level;
 class TerrainTree;
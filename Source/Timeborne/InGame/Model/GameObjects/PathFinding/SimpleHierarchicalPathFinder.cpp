@@ -2,21 +2,129 @@
 
 #include <Timeborne/InGame/Model/GameObjects/PathFinding/SimpleHierarchicalPathFinder.h>
 
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/AStar.h>
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
-#include <Timeborne/InGame/Model/Level.h>
 
-constexpr unsigned c_StartNodeSize = 16;
+#include <Core/Constants.h>
 
-void SimpleHierarchicalPathFinder::FindPath(PathFindingContext& context,
-	const HeightDependentDistanceParameters* distanceParameters, GameObjectPath& result)
+constexpr unsigned c_CountStartLevelsAboveLeafs = 4;
+constexpr unsigned c_StartNodeSize = 1 << c_CountStartLevelsAboveLeafs;
+
+// Routes shorter than this along both axes are found by the leaf-level A* directly.
+constexpr int c_MinHierarchicalRouteLength = 2 * c_StartNodeSize;
+
+// Returns the ancestor node with the start node size or an invalid index, if the terrain tree has no such node,
+// e.g. because the terrain's size is not divisible with it.
+inline unsigned GetStartLevelNodeIndex(const TerrainTree& terrainTree, unsigned leafNodeIndex)
+{
+	unsigned nodeIndex = leafNodeIndex;
+	for (unsigned i = 0; i < c_CountStartLevelsAboveLeafs && nodeIndex != Core::c_InvalidIndexU; i++)
+	{
+		nodeIndex = terrainTree.GetNode(nodeIndex).Parent;
+	}
+	if (nodeIndex == Core::c_InvalidIndexU) return nodeIndex;
+
+	auto size = terrainTree.GetNodeSize(nodeIndex);
+	return (size.x == (int)c_StartNodeSize && size.y == (int)c_StartNodeSize) ? nodeIndex : Core::c_InvalidIndexU;
+}
+
+void SimpleHierarchicalPathFinder::MarkCorridor(const PathFindingContext& context)
+{
+	auto& terrainTree = context.TerrainTree;
+
+	if (m_CorridorNodeMarks.GetSize() != terrainTree.GetCountNodes())
+	{
+		m_CorridorNodeMarks.Clear();
+		m_CorridorNodeMarks.PushBack(Core::c_InvalidIndexU, terrainTree.GetCountNodes());
+	}
+
+	auto markNode = [this](unsigned nodeIndex) {
+		if (nodeIndex != Core::c_InvalidIndexU && m_CorridorNodeMarks[nodeIndex] == Core::c_InvalidIndexU)
+		{
+			m_CorridorNodeMarks[nodeIndex] = m_CorridorNodeIndices.GetSize();
+			m_CorridorNodeIndices.PushBack(nodeIndex);
+		}
+	};
+
+	// The leaf path might leave the coarse path at the node borders, therefore the neighbors are also added.
+	m_CorridorNodeIndices.Clear();
+	auto countCoarseNodes = m_CoarseNodeIndices.GetSize();
+	for (unsigned i = 0; i < countCoarseNodes; i++)
+	{
+		auto nodeIndex = m_CoarseNodeIndices[i];
+		markNode(nodeIndex);
+
+		auto& node = terrainTree.GetNode(nodeIndex);
+		for (unsigned d = 0; d < 8; d++) markNode(node.Neighbors[d]);
+	}
+}
+
+void SimpleHierarchicalPathFinder::UnmarkCorridor()
+{
+	auto countCorridorNodes = m_CorridorNodeIndices.GetSize();
+	for (unsigned i = 0; i < countCorridorNodes; i++)
+	{
+		m_CorridorNodeMarks[m_CorridorNodeIndices[i]] = Core::c_InvalidIndexU;
+	}
+	m_CorridorNodeIndices.Clear();
+}
+
+unsigned SimpleHierarchicalPathFinder::GetCountExpandedNodes() const
+{
+	return m_CountExpandedNodes;
+}
+
+void SimpleHierarchicalPathFinder::FindPath(const PathFindingContext& context, AStar& aStar,
+	unsigned startNodeIndex, unsigned endNodeIndex,
+	const HeightDependentDistanceParameters* distanceParameters, Core::IndexVectorU& nodeIndices)
 {
-	auto& level = context.Level;
-	auto& terrain = level.GetTerrain();
 	auto& terrainTree = context.TerrainTree;
 
-	auto searchStartNode = terrainTree.GetNodeIndexForField(result.SourceField, c_StartNodeSize);
-	auto searchEndNode = terrainTree.GetNodeIndexForField(result.TargetField, c_StartNodeSize);
+	m_CountExpandedNodes = 0;
+
+	auto solveOnWholeTerrain = [&]() {
+		aStar.FindPath(context, startNodeIndex, endNodeIndex, distanceParameters, nodeIndices);
+		m_CountExpandedNodes += aStar.GetCountExpandedNodes();
+	};
+
+	auto routeOffset = glm::abs(terrainTree.GetNode(endNodeIndex).Start - terrainTree.GetNode(startNodeIndex).Start);
+	auto searchStartNode = GetStartLevelNodeIndex(terrainTree, startNodeIndex);
+	auto searchEndNode = GetStartLevelNodeIndex(terrainTree, endNodeIndex);
+
+	if (std::max(routeOffset.x, routeOffset.y) < c_MinHierarchicalRouteLength
+		|| searchStartNode == Core::c_InvalidIndexU || searchEndNode == Core::c_InvalidIndexU)
+	{
+		solveOnWholeTerrain();
+		return;
+	}
+
+	// Executing A* from 'searchStartNode' to 'searchEndNode' using the inner nodes' neighbors and connectivity
+	// information. The approaching criterion is only evaluated on the leaf level.
+	aStar.FindPath(context, searchStartNode, searchEndNode, nullptr, m_CoarseNodeIndices);
+	m_CountExpandedNodes += aStar.GetCountExpandedNodes();
+
+	if (m_CoarseNodeIndices.IsEmpty())
+	{
+		if (searchStartNode != searchEndNode)
+		{
+			// The target is not reachable even with the over-approximated connectivity. Since the islands
+			// were checked by the caller, this only happens with approaching paths, which can end outside
+			// of the target's coarse node.
+			solveOnWholeTerrain();
+			return;
+		}
+		m_CoarseNodeIndices.PushBack(searchStartNode);
+	}
+
+	// Refining in the corridor.
+	MarkCorridor(context);
+	AStarCorridor corridor{ &m_CorridorNodeMarks, c_CountStartLevelsAboveLeafs };
+	aStar.FindPath(context, startNodeIndex, endNodeIndex, distanceParameters, nodeIndices, &corridor);
+	m_CountExpandedNodes += aStar.GetCountExpandedNodes();
+	UnmarkCorridor();
 
-	// Execute A* from 'searchStartNode' to 'searchEndNode' using neighbors and connectivity information.
-	// ...
+	if (nodeIndices.IsEmpty())
+	{
+		solveOnWholeTerrain();
+	}
 }
@@ -4,12 +4,34 @@
 
 #include <Timeborne/InGame/Model/GameObjects/PathFinding/PathFinding.h>
 
+class AStar;
 struct HeightDependentDistanceParameters;
 
+// Executes A* on the terrain tree's inner nodes of a fixed size first, then refines the coarse path
+// with a leaf-level A* that is restricted to a corridor around the coarse nodes.
+//
+// The inner nodes' connectivity is an over-approximation of the leaf connectivity, therefore
+// the coarse path might not be refinable. In this case and also for short routes the leaf-level A*
+// is executed on the whole terrain.
 class SimpleHierarchicalPathFinder
 {
+	// Node index -> valid index for corridor nodes. SoA with the terrain tree's nodes.
+	Core::IndexVectorU m_CorridorNodeMarks;
+	Core::IndexVectorU m_CorridorNodeIndices;
+
+	Core::IndexVectorU m_CoarseNodeIndices;
+
+	unsigned m_CountExpandedNodes = 0;
+
+	void MarkCorridor(const PathFindingContext& context);
+	void UnmarkCorridor();
+
 public:
-	void FindPath(PathFindingContext& context,
+	void FindPath(const PathFindingContext& context, AStar& aStar,
+		unsigned startNodeIndex, unsigned endNodeIndex,
 		const HeightDependentDistanceParameters* distanceParameters,
-		GameObjectPath& result);
-};
\ No newline at end of file
+		Core::IndexVectorU& nodeIndices);
+
+	// Returns the number of nodes expanded on all levels in the last search.
+	unsigned GetCountExpandedNodes() const;
+};
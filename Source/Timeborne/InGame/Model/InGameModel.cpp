@@ -4,7 +4,10 @@
 
 #include <Timeborne/InGame/Model/GameObjects/GameObjectModel.h>
 #include <Timeborne/InGame/GameState/ClientGameState.h>
+#include <Timeborne/InGame/GameState/ServerGameState.h>
 #include <Timeborne/InGame/Model/CommandListProcessor.h>
+#include <Timeborne/InGame/Model/TickContext.h>
+#include <Timeborne/InGame/Model/TickTimings.h>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -31,6 +34,9 @@ InGameModel::InGameModel(const Level& level, ClientGameState& clientGameState,
 	{
 		// @todo: load commands.
 	}
+
+	// Notifying the change listeners about the objects of the level or the save file.
+	m_GameObjectData.ClientModelGameState->FlushChanges();
 }
 
 InGameModel::~InGameModel()
@@ -39,6 +45,21 @@ InGameModel::~InGameModel()
 
 void InGameModel::Tick(const TickContext& context)
 {
-	m_CommandListProcessor->Tick(context);
+	{
+		TickStageTimer timer(context.Timings, TickTimings::Stage::CommandList);
+		m_CommandListProcessor->Tick(context);
+	}
 	m_GameObjectModel->Tick(context);
+
+	m_GameObjectData.ClientModelGameState->FlushChanges();
+}
+
+const CommandListProcessor& InGameModel::GetCommandListProcessor() const
+{
+	return *m_CommandListProcessor;
+}
+
+const GameObjectModel& InGameModel::GetGameObjectModel() const
+{
+	return *m_GameObjectModel;
 }
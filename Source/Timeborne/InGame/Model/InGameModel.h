@@ -31,4 +31,7 @@ public:
 	~InGameModel();
 
 	void Tick(const TickContext& context);
+
+	const CommandListProcessor& GetCommandListProcessor() const;
+	const GameObjectModel& GetGameObjectModel() const;
 };
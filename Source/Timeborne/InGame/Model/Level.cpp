@@ -3,22 +3,34 @@
 #include <Timeborne/InGame/Model/Level.h>
 
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
+#include <Timeborne/Misc/MappedFile.h>
 
 #include <Core/SimpleBinarySerialization.hpp>
 #include <Core/System/SimpleIO.h>
 #include <EngineBuildingBlocks/PathHandler.h>
 
+#include <cstring>
+#include <stdexcept>
+
 using namespace EngineBuildingBlocks;
 
+// Level file format: magic, version, name, terrain, terrain tree, game objects.
+// The large terrain and terrain tree arrays are stored aligned, so that they can be used directly from the mapped file.
+// The files of the earlier versions start with the name. Before version 2 a field height quad tree was stored
+// after the terrain. Before version 3 the terrain tree had no surface height bounds, and in version 2 its node heights
+// were the surface height bounds instead of the field corner heights.
+constexpr uint32_t c_LevelFileMagic = 0x564c4254; // "TBLV"
+constexpr uint32_t c_LevelFileVersion = 3;
+constexpr uint32_t c_LevelFileVersion_SurfaceNodeHeights = 2;
+constexpr uint32_t c_LevelFileVersion_FieldHeightQuadTree = 1;
+
 Level::Level()
-	: m_FieldHeightQuadtree(&m_Terrain)
 {
 }
 
 Level::Level(const LevelSetupData& data)
 	: m_Name(data.Name)
 	, m_Terrain(data.Size)
-	, m_FieldHeightQuadtree(&m_Terrain)
 {
 }
 
@@ -46,16 +58,6 @@ Terrain& Level::GetTerrain()
 	return m_Terrain;
 }
 
-FieldHeightQuadTree& Level::GetFieldHeightQuadtree()
-{
-	return m_FieldHeightQuadtree;
-}
-
-const FieldHeightQuadTree& Level::GetFieldHeightQuadtree() const
-{
-	return m_FieldHeightQuadtree;
-}
-
 TerrainTree* Level::GetTerrainTree()
 {
 	return m_TerrainTree.get();
@@ -81,20 +83,34 @@ std::string Level::GetPath(const PathHandler& pathHandler, const std::string& fi
 	return pathHandler.GetPathFromResourcesDirectory("Levels/" + fileName + ".lvl");
 }
 
-void Level::Load(const PathHandler& pathHandler, const std::string& fileName, bool forceRecomputations)
+void Level::Load(const PathHandler& pathHandler, const std::string& fileName, bool forceRecomputations,
+	Core::ThreadPool* threadPool)
 {
-	auto bytes = Core::ReadAllBytes(GetPath(pathHandler, fileName));
-	auto byteArray = (const unsigned char*)bytes.GetArray();
-	DeserializeSB(byteArray, forceRecomputations);
+	Load(GetPath(pathHandler, fileName), forceRecomputations, threadPool);
 }
 
-void Level::CreateTerrainTree(const MainApplication* application)
+void Level::Load(const std::string& filePath, bool forceRecomputations, Core::ThreadPool* threadPool)
 {
-	m_TerrainTree = std::make_unique<TerrainTree>(m_Terrain, application);
+	// The terrain and terrain tree arrays are views into the mapped file and keep the mapping alive.
+	auto file = std::make_shared<const MappedFile>(filePath);
+	auto bytes = file->GetData();
+	if (file->GetSize() < sizeof(uint32_t))
+	{
+		throw std::runtime_error("Invalid level file: '" + filePath + "'.");
+	}
+	DeserializeSB(bytes, MappableDataSource{ bytes, file }, forceRecomputations, threadPool);
 }
 
-void Level::Save(const PathHandler& pathHandler, const std::string& fileName) const
+void Level::CreateTerrainTree(Core::ThreadPool* threadPool)
 {
+	m_TerrainTree = std::make_unique<TerrainTree>(m_Terrain, threadPool);
+}
+
+void Level::Save(const PathHandler& pathHandler, const std::string& fileName)
+{
+	m_Terrain.CopyMappedData();
+	if (m_TerrainTree != nullptr) m_TerrainTree->CopyMappedData();
+
 	Core::WriteAllBytes(GetPath(pathHandler, fileName), Core::StartSerializeSB(*this));
 }
 
@@ -103,9 +119,10 @@ void Level::SerializeSB(Core::ByteVector& bytes) const
 	// The terrain tree must be created.
 	assert(m_TerrainTree != nullptr);
 
+	Core::SerializeSB(bytes, c_LevelFileMagic);
+	Core::SerializeSB(bytes, c_LevelFileVersion);
 	Core::SerializeSB(bytes, m_Name);
 	Core::SerializeSB(bytes, m_Terrain);
-	Core::SerializeSB(bytes, m_FieldHeightQuadtree);
 	Core::SerializeSB(bytes, *m_TerrainTree);
 
 	// Converting to simple type vector.
@@ -114,23 +131,67 @@ void Level::SerializeSB(Core::ByteVector& bytes) const
 	Core::SerializeSB(bytes, gameObjects);
 }
 
-void Level::DeserializeSB(const unsigned char*& bytes, bool forceRecomputations)
+void Level::DeserializeSB(const unsigned char*& bytes, bool forceRecomputations, Core::ThreadPool* threadPool)
 {
-	Core::DeserializeSB(bytes, m_Name);
-	m_Terrain.DeserializeSB(bytes, forceRecomputations);
+	DeserializeSB(bytes, MappableDataSource{ bytes, nullptr }, forceRecomputations, threadPool);
+}
 
-	// The field height quad tree must be deserialized, but we will overwrite it if the recomputations are forced.
-	Core::DeserializeSB(bytes, m_FieldHeightQuadtree);
+inline void SkipFieldHeightQuadTreeSB(const unsigned char*& bytes)
+{
+	unsigned countNodes;
+	Core::DeserializeSB(bytes, countNodes);
+	for (unsigned i = 0; i < countNodes; i++)
+	{
+		unsigned parent, children[4];
+		float minHeight, maxHeight;
+		Core::DeserializeSB(bytes, parent);
+		Core::DeserializeSB(bytes, children);
+		Core::DeserializeSB(bytes, minHeight);
+		Core::DeserializeSB(bytes, maxHeight);
+	}
+}
 
-	if (forceRecomputations)
+void Level::DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source, bool forceRecomputations,
+	Core::ThreadPool* threadPool)
+{
+	uint32_t magic;
+	std::memcpy(&magic, bytes, sizeof(uint32_t));
+	bool isLegacyFormat = (magic != c_LevelFileMagic);
+	uint32_t version = 0;
+	if (!isLegacyFormat)
 	{
-		m_FieldHeightQuadtree = FieldHeightQuadTree(&m_Terrain);
+		bytes += sizeof(uint32_t);
+		Core::DeserializeSB(bytes, version);
+		if (version != c_LevelFileVersion && version != c_LevelFileVersion_SurfaceNodeHeights
+			&& version != c_LevelFileVersion_FieldHeightQuadTree)
+		{
+			throw std::runtime_error("Unsupported level file version: " + std::to_string(version) + ".");
+		}
 	}
 
+	Core::DeserializeSB(bytes, m_Name);
+	if (isLegacyFormat) m_Terrain.DeserializeLegacySB(bytes, forceRecomputations, threadPool);
+	else m_Terrain.DeserializeSB(bytes, source, forceRecomputations, threadPool);
+
+	bool hasFieldHeightQuadTree = (version < c_LevelFileVersion_SurfaceNodeHeights);
+	if (hasFieldHeightQuadTree) SkipFieldHeightQuadTreeSB(bytes);
+
+	bool hasSurfaceHeightBounds = (version == c_LevelFileVersion);
 	auto terrainTree = new TerrainTree(m_Terrain);
-	Core::DeserializeSB(bytes, *terrainTree);
+	if (isLegacyFormat) terrainTree->DeserializeLegacySB(bytes);
+	else terrainTree->DeserializeSB(bytes, source, hasSurfaceHeightBounds);
 	m_TerrainTree.reset(terrainTree);
 
+	// The node heights of version 2 have to be recomputed. The earlier versions only miss the surface height bounds.
+	if (forceRecomputations || version == c_LevelFileVersion_SurfaceNodeHeights)
+	{
+		CreateTerrainTree(threadPool);
+	}
+	else if (!hasSurfaceHeightBounds)
+	{
+		terrainTree->ComputeSurfaceHeightBounds(threadPool);
+	}
+
 	// Converting from simple type vector.
 	Core::SimpleTypeVectorU<GameObjectLevelData> gameObjects;
 	Core::DeserializeSB(bytes, gameObjects);
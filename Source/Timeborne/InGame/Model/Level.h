@@ -2,16 +2,15 @@
 
 #pragma once
 
+#include <Timeborne/Declarations/CoreDeclarations.h>
 #include <Timeborne/Declarations/EngineBuildingBlocksDeclarations.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObject.h>
 #include <Timeborne/InGame/Model/Terrain/Terrain.h>
-#include <Timeborne/InGame/Model/Terrain/FieldHeightQuadTree.h>
 
 #include <memory>
 #include <string>
 
 class TerrainTree;
-class MainApplication;
 
 struct LevelSetupData
 {
@@ -25,13 +24,13 @@ class Level
 
 	Terrain m_Terrain;
 
-	// @todo: this will be replaced with the terrain tree.
-	FieldHeightQuadTree m_FieldHeightQuadtree;
-
 	std::unique_ptr<TerrainTree> m_TerrainTree;
 
 	Core::SimpleTypeUnorderedVectorU<GameObjectLevelData> m_GameObjects;
 
+	void DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source, bool forceRecomputations,
+		Core::ThreadPool* threadPool);
+
 public:
 
 	Level();
@@ -43,21 +42,23 @@ public:
 
 	const Terrain& GetTerrain() const;
 	Terrain& GetTerrain();
-	FieldHeightQuadTree& GetFieldHeightQuadtree();
-	const FieldHeightQuadTree& GetFieldHeightQuadtree() const;
 	TerrainTree* GetTerrainTree();
 	const TerrainTree* GetTerrainTree() const;
 	Core::SimpleTypeUnorderedVectorU<GameObjectLevelData>& GetGameObjects();
 	const Core::SimpleTypeUnorderedVectorU<GameObjectLevelData>& GetGameObjects() const;
 
-	void CreateTerrainTree(const MainApplication* application);
+	void CreateTerrainTree(Core::ThreadPool* threadPool);
 
+	// The thread pool is only used for the forced recomputations and it is optional.
 	void Load(const EngineBuildingBlocks::PathHandler& pathHandler, const std::string& fileName,
-		bool forceRecomputations);
-	void Save(const EngineBuildingBlocks::PathHandler& pathHandler, const std::string& fileName) const;
+		bool forceRecomputations, Core::ThreadPool* threadPool);
+	void Load(const std::string& filePath, bool forceRecomputations, Core::ThreadPool* threadPool);
+
+	// The mapped data of the loaded level is copied before writing, since the level file might be overwritten.
+	void Save(const EngineBuildingBlocks::PathHandler& pathHandler, const std::string& fileName);
 
 	void SerializeSB(Core::ByteVector& bytes) const;
-	void DeserializeSB(const unsigned char*& bytes, bool forceRecomputations);
+	void DeserializeSB(const unsigned char*& bytes, bool forceRecomputations, Core::ThreadPool* threadPool);
 
 	static std::string GetPath(const EngineBuildingBlocks::PathHandler& pathHandler,
 		const std::string& levelName);
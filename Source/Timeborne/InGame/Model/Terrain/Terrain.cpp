@@ -4,7 +4,13 @@
 
 #include <Timeborne/InGame/Model/Terrain/TerrainCommon.h>
 
+#include <Core/Comparison.h>
 #include <Core/SimpleBinarySerialization.hpp>
+#include <Core/System/ThreadPool.h>
+
+#include <algorithm>
+
+#include <xmmintrin.h>
 
 Terrain::Terrain()
 	: m_CountFields(0)
@@ -26,6 +32,13 @@ Terrain::Terrain(const glm::uvec2& countFields)
 void Terrain::CreateSurfaceData()
 {
 	auto countFields1d = m_CountFields.x * m_CountFields.y;
+
+	// Clearing first, so that the mapped data is not copied.
+	m_SurfaceCoefficients.Clear();
+	m_DX.Clear();
+	m_DY.Clear();
+	m_DXY.Clear();
+
 	m_SurfaceCoefficients.Resize(countFields1d);
 	m_SurfaceCoefficients.SetByte(0);
 	m_DX.Resize(countFields1d);
@@ -91,7 +104,7 @@ glm::vec3 Terrain::GetNormal(const glm::ivec2& fieldIndex, float xInField, float
 		-EvaluateBicubicFunctionDerivativeZ(dzm, xInField, zInField)));
 }
 
-const Core::SimpleTypeVectorU<glm::mat4>& Terrain::GetSurfaceCoefficients() const
+const MappableVector<glm::mat4>& Terrain::GetSurfaceCoefficients() const
 {
 	return m_SurfaceCoefficients;
 }
@@ -130,24 +143,54 @@ void Terrain::SerializeSB(Core::ByteVector& bytes) const
 	Core::SerializeSB(bytes, m_SurfaceCoefficients);
 }
 
-void Terrain::DeserializeSB(const unsigned char*& bytes, bool forceRecomputations)
+void Terrain::DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source, bool forceRecomputations,
+	Core::ThreadPool* threadPool)
+{
+	Core::DeserializeSB(bytes, Core::ToPlaceHolder(m_CountFields));
+	m_Fields.DeserializeSB(bytes, source);
+
+	// All data must be deserialized, but they will be overwritten if the recomputations are forced.
+	m_DX.DeserializeSB(bytes, source);
+	m_DY.DeserializeSB(bytes, source);
+	m_DXY.DeserializeSB(bytes, source);
+	m_SurfaceCoefficients.DeserializeSB(bytes, source);
+
+	if (forceRecomputations)
+	{
+		CreateSurfaceData();
+		UpdateSurfaceData(glm::ivec2(0, 0), glm::ivec2(m_CountFields.x - 1, m_CountFields.y - 1),
+			threadPool);
+	}
+}
+
+void Terrain::DeserializeLegacySB(const unsigned char*& bytes, bool forceRecomputations, Core::ThreadPool* threadPool)
 {
 	Core::DeserializeSB(bytes, Core::ToPlaceHolder(m_CountFields));
-	Core::DeserializeSB(bytes, m_Fields);
+	m_Fields.DeserializeLegacySB(bytes);
 
 	// All data must be deserialized, but they will be overwritten if the recomputations are forced.
-	Core::DeserializeSB(bytes, m_DX);
-	Core::DeserializeSB(bytes, m_DY);
-	Core::DeserializeSB(bytes, m_DXY);
-	Core::DeserializeSB(bytes, m_SurfaceCoefficients);
+	m_DX.DeserializeLegacySB(bytes);
+	m_DY.DeserializeLegacySB(bytes);
+	m_DXY.DeserializeLegacySB(bytes);
+	m_SurfaceCoefficients.DeserializeLegacySB(bytes);
 
 	if (forceRecomputations)
 	{
 		CreateSurfaceData();
-		UpdateSurfaceData(glm::ivec2(0, 0), glm::ivec2(m_CountFields.x - 1, m_CountFields.y - 1));
+		UpdateSurfaceData(glm::ivec2(0, 0), glm::ivec2(m_CountFields.x - 1, m_CountFields.y - 1),
+			threadPool);
 	}
 }
 
+void Terrain::CopyMappedData()
+{
+	m_Fields.CopyMappedData();
+	m_DX.CopyMappedData();
+	m_DY.CopyMappedData();
+	m_DXY.CopyMappedData();
+	m_SurfaceCoefficients.CopyMappedData();
+}
+
 void Terrain::GetFlippedLimits(const glm::ivec2& start, const glm::ivec2& end, glm::ivec2* pStart, glm::ivec2* pEnd)
 {
 	if (start.x <= end.x) { pStart->x = start.x; pEnd->x = end.x; }
@@ -323,9 +366,351 @@ inline glm::mat4 GetCoeffMatrix(FieldData* fields, const glm::uvec2& countFields
 	return mLeft * mFValues * mRight;
 }
 
-void Terrain::UpdateSurfaceData(const glm::ivec2& changeStart, const glm::ivec2& changeEnd)
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Vectorized surface data computation.
+//
+// The kernels process 4 consecutive fields of a row: the field data is transposed into SSE registers, so that each lane
+// holds a field and the branches of the scalar functions become selections. The kernels read the direct neighbors
+// without bounds checking, therefore they are only executed for fields which are not on the border of the terrain.
+// The operations are executed in the same order as in the scalar functions, therefore the results are equal.
+
+constexpr int c_SurfaceVectorWidth = 4;
+
+// Loads 4 vectors and transposes them: the result i contains the component i of the vectors.
+inline void LoadTransposed(const float* p0, const float* p1, const float* p2, const float* p3, __m128* r)
+{
+	r[0] = _mm_loadu_ps(p0);
+	r[1] = _mm_loadu_ps(p1);
+	r[2] = _mm_loadu_ps(p2);
+	r[3] = _mm_loadu_ps(p3);
+	_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+}
+
+inline void LoadTransposed(const float* p, unsigned stride, __m128* r)
+{
+	LoadTransposed(p, p + stride, p + 2 * stride, p + 3 * stride, r);
+}
+
+inline void StoreTransposed(float* p, unsigned stride, __m128 r0, __m128 r1, __m128 r2, __m128 r3)
+{
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_storeu_ps(p, r0);
+	_mm_storeu_ps(p + stride, r1);
+	_mm_storeu_ps(p + 2 * stride, r2);
+	_mm_storeu_ps(p + 3 * stride, r3);
+}
+
+inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline void UpdateDerivativesVectorized(const FieldData* fields, const glm::uvec2& countFields, int x, int z,
+	glm::vec4* dxs, glm::vec4* dys, glm::vec4* dxys)
+{
+	auto index = z * countFields.x + x;
+	auto GetFieldPointer = [fields, &countFields](int fieldX, int fieldZ) {
+		return &fields[fieldZ * countFields.x + fieldX].Heights.x;
+	};
+
+	__m128 f[5][4];
+	LoadTransposed(GetFieldPointer(x, z), 4, f[0]);
+	LoadTransposed(GetFieldPointer(x, z + 1), 4, f[1]);
+	LoadTransposed(GetFieldPointer(x + 1, z), 4, f[2]);
+	LoadTransposed(GetFieldPointer(x, z - 1), 4, f[3]);
+	LoadTransposed(GetFieldPointer(x - 1, z), 4, f[4]);
+
+	auto derivativeScalerL = _mm_set1_ps(0.5f);
+	auto GetDerivative = [derivativeScalerL](__m128 f0, __m128 fN, __m128 centralA, __m128 centralB,
+		__m128 oneSidedA, __m128 oneSidedB) {
+		return Select(_mm_cmpeq_ps(f0, fN),
+			_mm_mul_ps(_mm_sub_ps(centralA, centralB), derivativeScalerL),
+			_mm_sub_ps(oneSidedA, oneSidedB));
+	};
+
+	__m128 dx[4], dy[4], dxy[4];
+	dx[0] = GetDerivative(f[0][0], f[4][1], f[0][1], f[4][0], f[0][1], f[0][0]);
+	dy[0] = GetDerivative(f[0][0], f[1][3], f[1][0], f[0][3], f[0][0], f[0][3]);
+	dx[1] = GetDerivative(f[0][1], f[2][0], f[2][1], f[0][0], f[0][1], f[0][0]);
+	dy[1] = GetDerivative(f[0][1], f[1][2], f[1][1], f[0][2], f[0][1], f[0][2]);
+	dx[2] = GetDerivative(f[0][2], f[2][3], f[2][2], f[0][3], f[0][2], f[0][3]);
+	dy[2] = GetDerivative(f[0][2], f[3][1], f[0][1], f[3][2], f[0][1], f[0][2]);
+	dx[3] = GetDerivative(f[0][3], f[4][2], f[0][2], f[4][3], f[0][2], f[0][3]);
+	dy[3] = GetDerivative(f[0][3], f[3][0], f[0][0], f[3][3], f[0][0], f[0][3]);
+
+	auto GetCrossDerivative = [derivativeScalerL](__m128 dxA, __m128 dxB, __m128 dyA, __m128 dyB) {
+		return _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_sub_ps(dxA, dxB), dyA), dyB), derivativeScalerL);
+	};
+
+	dxy[0] = GetCrossDerivative(dx[0], dx[3], dy[1], dy[0]);
+	dxy[1] = GetCrossDerivative(dx[1], dx[2], dy[1], dy[0]);
+	dxy[2] = GetCrossDerivative(dx[1], dx[2], dy[2], dy[3]);
+	dxy[3] = GetCrossDerivative(dx[0], dx[3], dy[2], dy[3]);
+
+	StoreTransposed(&dxs[index].x, 4, dx[0], dx[1], dx[2], dx[3]);
+	StoreTransposed(&dys[index].x, 4, dy[0], dy[1], dy[2], dy[3]);
+	StoreTransposed(&dxys[index].x, 4, dxy[0], dxy[1], dxy[2], dxy[3]);
+}
+
+// Computes the column vector (a, c, -3a + 3b - 2c - d, 2a - 2b + c + d): the product with the constant matrices of the
+// bicubic interpolation, skipping the zero terms.
+inline void MultiplyWithBasis(__m128 a, __m128 b, __m128 c, __m128 d, __m128* r)
+{
+	auto two = _mm_set1_ps(2.0f);
+	auto three = _mm_set1_ps(3.0f);
+	auto twoC = _mm_mul_ps(two, c);
+	r[0] = a;
+	r[1] = c;
+	r[2] = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(three, b), _mm_mul_ps(three, a)), twoC), d);
+	r[3] = _mm_add_ps(_mm_add_ps(_mm_sub_ps(_mm_mul_ps(two, a), _mm_mul_ps(two, b)), c), d);
+}
+
+inline void UpdateCoeffMatricesVectorized(const FieldData* fields, const glm::uvec2& countFields, int x, int z,
+	const glm::vec4* dxs, const glm::vec4* dys, const glm::vec4* dxys, glm::mat4* coeffs)
+{
+	// Same neighbor order as in 'GetCoeffMatrix'.
+	const int c_NeighborOffsets[9][2] = { { 0, 0 }, { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 }, { -1, 1 }, { 1, 1 },
+		{ 1, -1 }, { -1, -1 } };
+
+	// The neighbor index and the corner index of the same-position corners for each corner.
+	const int c_SamePositionCorners[4][3][2] = {
+		{ { 1, 3 }, { 4, 1 }, { 5, 2 } },
+		{ { 1, 2 }, { 2, 0 }, { 6, 3 } },
+		{ { 2, 3 }, { 3, 1 }, { 7, 0 } },
+		{ { 4, 2 }, { 3, 0 }, { 8, 1 } } };
+
+	__m128 f[9][4], dxv[9][4], dyv[9][4], dxyv[9][4];
+	for (int i = 0; i < 9; i++)
+	{
+		auto index = (z + c_NeighborOffsets[i][1]) * countFields.x + x + c_NeighborOffsets[i][0];
+		LoadTransposed(&fields[index].Heights.x, 4, f[i]);
+		LoadTransposed(&dxs[index].x, 4, dxv[i]);
+		LoadTransposed(&dys[index].x, 4, dyv[i]);
+		LoadTransposed(&dxys[index].x, 4, dxyv[i]);
+	}
+
+	// Averaging dx, dy and dxy values on same-height corners.
+	auto one = _mm_set1_ps(1.0f);
+	__m128 dx[4], dy[4], dxy[4];
+	for (int c = 0; c < 4; c++)
+	{
+		dx[c] = dxv[0][c];
+		dy[c] = dyv[0][c];
+		dxy[c] = dxyv[0][c];
+		auto countValues = one;
+		for (int i = 0; i < 3; i++)
+		{
+			int n = c_SamePositionCorners[c][i][0];
+			int nc = c_SamePositionCorners[c][i][1];
+			auto mask = _mm_cmpeq_ps(f[0][c], f[n][nc]);
+			dx[c] = _mm_add_ps(dx[c], _mm_and_ps(mask, dxv[n][nc]));
+			dy[c] = _mm_add_ps(dy[c], _mm_and_ps(mask, dyv[n][nc]));
+			dxy[c] = _mm_add_ps(dxy[c], _mm_and_ps(mask, dxyv[n][nc]));
+			countValues = _mm_add_ps(countValues, _mm_and_ps(mask, one));
+		}
+		dx[c] = _mm_div_ps(dx[c], countValues);
+		dy[c] = _mm_div_ps(dy[c], countValues);
+		dxy[c] = _mm_div_ps(dxy[c], countValues);
+	}
+
+	// Computing mLeft * mFValues * mRight of 'GetCoeffMatrix' in column vectors, the transpose of mLeft is mRight.
+	__m128 m[4][4], result[4][4];
+	MultiplyWithBasis(f[0][3], f[0][2], dx[3], dx[2], m[0]);
+	MultiplyWithBasis(f[0][0], f[0][1], dx[0], dx[1], m[1]);
+	MultiplyWithBasis(dy[3], dy[2], dxy[3], dxy[2], m[2]);
+	MultiplyWithBasis(dy[0], dy[1], dxy[0], dxy[1], m[3]);
+	for (int i = 0; i < 4; i++)
+	{
+		__m128 row[4];
+		MultiplyWithBasis(m[0][i], m[1][i], m[2][i], m[3][i], row);
+		for (int j = 0; j < 4; j++) result[j][i] = row[j];
+	}
+
+	auto pCoeffs = &coeffs[z * countFields.x + x][0].x;
+	for (int j = 0; j < 4; j++)
+	{
+		StoreTransposed(pCoeffs + 4 * j, 16, result[j][0], result[j][1], result[j][2], result[j][3]);
+	}
+}
+
+// Processes a row of fields with the vectorized function where the neighbors are available.
+template <typename TScalarFunction, typename TVectorFunction>
+inline void ProcessSurfaceRow(const glm::uvec2& countFields, int z, int startX, int endX,
+	TScalarFunction&& scalarFunction, TVectorFunction&& vectorFunction)
+{
+	int x = startX;
+	if (z > 0 && z + 1 < (int)countFields.y)
+	{
+		for (; x <= endX && x < 1; x++) scalarFunction(x);
+		int vectorEndX = std::min(endX, (int)countFields.x - 2);
+		for (; x + c_SurfaceVectorWidth - 1 <= vectorEndX; x += c_SurfaceVectorWidth) vectorFunction(x);
+	}
+	for (; x <= endX; x++) scalarFunction(x);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Evaluates the bicubic functions of 4 samples. The operations are executed in the same order as in the scalar functions
+// of 'TerrainCommon.h', therefore the results are equal to the ones of 'GetHeight' and 'GetNormal'.
+inline void GetHeightsAndNormalsVectorized(const glm::mat4* coeffs, const glm::uvec2& countFields,
+	const Terrain::SurfaceSample* samples, float* heights, glm::vec3* normals)
+{
+	const float* pCoeffs[4];
+	for (int i = 0; i < 4; i++)
+	{
+		auto& fieldIndex = samples[i].FieldIndex;
+		pCoeffs[i] = &coeffs[fieldIndex.y * countFields.x + fieldIndex.x][0].x;
+	}
+
+	// Component k of column j.
+	__m128 c[4][4];
+	for (int j = 0; j < 4; j++)
+	{
+		LoadTransposed(pCoeffs[0] + 4 * j, pCoeffs[1] + 4 * j, pCoeffs[2] + 4 * j, pCoeffs[3] + 4 * j, c[j]);
+	}
+
+	auto x = _mm_setr_ps(samples[0].XInField, samples[1].XInField, samples[2].XInField, samples[3].XInField);
+	auto z = _mm_setr_ps(samples[0].ZInField, samples[1].ZInField, samples[2].ZInField, samples[3].ZInField);
+	auto x2 = _mm_mul_ps(x, x);
+	auto x3 = _mm_mul_ps(x, x2);
+	auto z2 = _mm_mul_ps(z, z);
+	auto z3 = _mm_mul_ps(z, z2);
+	auto two = _mm_set1_ps(2.0f);
+	auto three = _mm_set1_ps(3.0f);
+
+	auto Dot3 = [](__m128 a, __m128 b, __m128 c, __m128 xs1, __m128 xs2) {
+		return _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(b, xs1)), _mm_mul_ps(c, xs2));
+	};
+	auto Dot4 = [](__m128 a, __m128 b, __m128 c, __m128 d, __m128 xs1, __m128 xs2, __m128 xs3) {
+		return _mm_add_ps(_mm_add_ps(_mm_add_ps(a, _mm_mul_ps(b, xs1)), _mm_mul_ps(c, xs2)), _mm_mul_ps(d, xs3));
+	};
+	auto PairwiseDot4 = [](__m128 a, __m128 b, __m128 c, __m128 d, __m128 xs1, __m128 xs2, __m128 xs3) {
+		return _mm_add_ps(_mm_add_ps(a, _mm_mul_ps(b, xs1)), _mm_add_ps(_mm_mul_ps(c, xs2), _mm_mul_ps(d, xs3)));
+	};
+
+	// Value.
+	__m128 r[4];
+	for (int j = 0; j < 4; j++) r[j] = Dot4(c[j][0], c[j][1], c[j][2], c[j][3], x, x2, x3);
+	auto height = PairwiseDot4(r[0], r[1], r[2], r[3], z, z2, z3);
+
+	// Derivative along X.
+	for (int j = 0; j < 4; j++) r[j] = Dot3(c[j][1], _mm_mul_ps(c[j][2], two), _mm_mul_ps(c[j][3], three), x, x2);
+	auto dX = PairwiseDot4(r[0], r[1], r[2], r[3], z, z2, z3);
+
+	// Derivative along Z.
+	for (int j = 0; j < 3; j++)
+	{
+		auto scaler = _mm_set1_ps(j + 1.0f);
+		r[j] = Dot4(_mm_mul_ps(c[j + 1][0], scaler), _mm_mul_ps(c[j + 1][1], scaler),
+			_mm_mul_ps(c[j + 1][2], scaler), _mm_mul_ps(c[j + 1][3], scaler), x, x2, x3);
+	}
+	auto dZ = Dot3(r[0], r[1], r[2], z, z2);
+
+	// Normalizing (-dX, 1, -dZ).
+	auto one = _mm_set1_ps(1.0f);
+	auto lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dX, dX), one), _mm_mul_ps(dZ, dZ));
+	auto inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+	auto signMask = _mm_set1_ps(-0.0f);
+	auto normalX = _mm_xor_ps(_mm_mul_ps(dX, inverseLength), signMask);
+	auto normalZ = _mm_xor_ps(_mm_mul_ps(dZ, inverseLength), signMask);
+
+	float results[16];
+	StoreTransposed(results, 4, normalX, inverseLength, normalZ, height);
+	for (int i = 0; i < 4; i++)
+	{
+		normals[i] = glm::vec3(results[4 * i], results[4 * i + 1], results[4 * i + 2]);
+		heights[i] = results[4 * i + 3];
+	}
+}
+
+void Terrain::GetHeightsAndNormals(const SurfaceSample* samples, unsigned countSamples,
+	float* heights, glm::vec3* normals) const
+{
+	auto coeffs = m_SurfaceCoefficients.GetArray();
+	unsigned i = 0;
+	for (; i + 4 <= countSamples; i += 4)
+	{
+		GetHeightsAndNormalsVectorized(coeffs, m_CountFields, samples + i, heights + i, normals + i);
+	}
+
+	// The remaining samples are padded, so that all samples are evaluated with the same code independently
+	// of the batch sizes.
+	if (i < countSamples)
+	{
+		SurfaceSample paddedSamples[4];
+		float paddedHeights[4];
+		glm::vec3 paddedNormals[4];
+		unsigned countRest = countSamples - i;
+		for (unsigned j = 0; j < 4; j++) paddedSamples[j] = samples[i + std::min(j, countRest - 1)];
+		GetHeightsAndNormalsVectorized(coeffs, m_CountFields, paddedSamples, paddedHeights, paddedNormals);
+		std::copy(paddedHeights, paddedHeights + countRest, heights + i);
+		std::copy(paddedNormals, paddedNormals + countRest, normals + i);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+constexpr unsigned c_MinCountParallelSurfaceFields = 4096;
+constexpr unsigned c_SurfaceRowPackageSize = 4;
+
+void Terrain::UpdateDerivativesInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
 {
 	auto fields = m_Fields.GetArray();
+	auto dxs = m_DX.GetArray();
+	auto dys = m_DY.GetArray();
+	auto dxys = m_DXY.GetArray();
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		int z = m_SurfaceUpdateStart.y + (int)i;
+		ProcessSurfaceRow(m_CountFields, z, m_SurfaceUpdateStart.x, m_SurfaceUpdateEnd.x,
+			[&](int x) { UpdateDerivatives(fields, m_CountFields, x, z, dxs, dys, dxys); },
+			[&](int x) { UpdateDerivativesVectorized(fields, m_CountFields, x, z, dxs, dys, dxys); });
+	}
+}
+
+void Terrain::UpdateCoefficientsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	auto fields = m_Fields.GetArray();
+	auto dxs = m_DX.GetArray();
+	auto dys = m_DY.GetArray();
+	auto dxys = m_DXY.GetArray();
+	auto coeffs = m_SurfaceCoefficients.GetArray();
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		int z = m_SurfaceUpdateStart.y + (int)i;
+		ProcessSurfaceRow(m_CountFields, z, m_SurfaceUpdateStart.x, m_SurfaceUpdateEnd.x,
+			[&](int x) { coeffs[z * m_CountFields.x + x] = GetCoeffMatrix(fields, m_CountFields, x, z, dxs, dys, dxys); },
+			[&](int x) { UpdateCoeffMatricesVectorized(fields, m_CountFields, x, z, dxs, dys, dxys, coeffs); });
+	}
+}
+
+void Terrain::ExecuteSurfaceUpdateFunction(Core::ThreadPool* threadPool, const glm::ivec2& start, const glm::ivec2& end,
+	SurfaceUpdateFunction function)
+{
+	m_SurfaceUpdateStart = start;
+	m_SurfaceUpdateEnd = end;
+	auto size = end - start + 1;
+	if (size.x <= 0 || size.y <= 0) return;
+
+	if (threadPool != nullptr && (unsigned)(size.x * size.y) >= c_MinCountParallelSurfaceFields)
+	{
+		threadPool->ExecuteWithDynamicScheduling((unsigned)size.y, function, this, c_SurfaceRowPackageSize);
+	}
+	else
+	{
+		(this->*function)(0, 0, size.y);
+	}
+}
+
+void Terrain::UpdateSurfaceData(const glm::ivec2& changeStart, const glm::ivec2& changeEnd, Core::ThreadPool* threadPool)
+{
+	// Making sure that the mapped data is copied before the parallel writes.
+	m_Fields.GetArray();
+	m_DX.GetArray();
+	m_DY.GetArray();
+	m_DXY.GetArray();
+	m_SurfaceCoefficients.GetArray();
 
 	int sX1 = std::max(changeStart.x - 1, 0);
 	int sY1 = std::max(changeStart.y - 1, 0);
@@ -335,22 +720,263 @@ void Terrain::UpdateSurfaceData(const glm::ivec2& changeStart, const glm::ivec2&
 	int sY2 = std::max(changeStart.y - 2, 0);
 	int eX2 = std::min(changeEnd.x + 2, (int)m_CountFields.x - 1);
 	int eY2 = std::min(changeEnd.y + 2, (int)m_CountFields.y - 1);
-	auto dxs = m_DX.GetArray();
-	auto dys = m_DY.GetArray();
-	auto dxys = m_DXY.GetArray();
-	for (int y = sY1; y <= eY1; y++)
+
+	// The coefficients read the derivatives of the neighbors, therefore the passes are executed one after the other.
+	ExecuteSurfaceUpdateFunction(threadPool, glm::ivec2(sX1, sY1), glm::ivec2(eX1, eY1), &Terrain::UpdateDerivativesInThread);
+	ExecuteSurfaceUpdateFunction(threadPool, glm::ivec2(sX2, sY2), glm::ivec2(eX2, eY2), &Terrain::UpdateCoefficientsInThread);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline float GetConstantFunctionValue(const glm::mat4& coeffs)
+{
+	return coeffs[0][0];
+}
+
+inline float EvaluateBilinearFunctionValue(const glm::mat4& coeffs, float x, float z)
+{
+	return coeffs[0][0] + coeffs[0][1] * x + (coeffs[1][0] + coeffs[1][1] * x) * z;
+}
+
+inline bool IsFunctionConstant(const glm::mat4& coeffs)
+{
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			if (std::fabsf(coeffs[i][j]) > 1e-5f && (i > 0 || j > 0)) return false;
+	return true;
+}
+
+inline bool IsFunctionBilinear(const glm::mat4& coeffs)
+{
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			if (std::fabsf(coeffs[i][j]) > 1e-5f && (i > 1 || j > 1)) return false;
+	return true;
+}
+
+inline glm::vec2 GetConstantFunctionMinMax(const glm::mat4& coeffs)
+{
+	auto c = GetConstantFunctionValue(coeffs);
+	return glm::vec2(c, c);
+}
+
+inline glm::vec2 GetBilinearFunctionMinMax(const glm::mat4& coeffs)
+{
+	float v0 = coeffs[1][0];
+	float v1 = coeffs[0][1] + coeffs[1][0] + coeffs[1][1];
+	float v2 = coeffs[0][1];
+	const float v3 = 0.0f;
+	return glm::vec2(
+		std::min(std::min(std::min(v0, v1), v2), v3),
+		std::max(std::max(std::max(v0, v1), v2), v3)) + coeffs[0][0];
+}
+
+inline glm::mat4x2 GetBicubicFunctionDXXMatrix(const glm::mat4& coeffs)
+{
+	glm::mat4x2 m(glm::uninitialize);
+	for (int c = 0; c < 4; c++) m[c] = glm::vec2(coeffs[c][2] * 2.0f, coeffs[c][3] * 6.0f);
+	return m;
+}
+
+inline float EvaluateBicubicFunctionDerivativeXX(const glm::mat4x2& dxxm, float x, float z)
+{
+	float z2 = z * z;
+	glm::vec2 xs(1.0f, x);
+	glm::vec4 zs(1.0f, z, z2, z * z2);
+	return glm::dot(xs * dxxm, zs);
+}
+
+inline glm::mat2x4 GetBicubicFunctionDZZMatrix(const glm::mat4& coeffs)
+{
+	glm::mat2x4 m(glm::uninitialize);
+	m[0] = coeffs[2] * 2.0f;
+	m[1] = coeffs[3] * 6.0f;
+	return m;
+}
+
+inline float EvaluateBicubicFunctionDerivativeZZ(const glm::mat2x4& dzzm, float x, float z)
+{
+	float x2 = x * x;
+	glm::vec4 xs(1.0f, x, x2, x * x2);
+	glm::vec2 zs(1.0f, z);
+	return glm::dot(xs * dzzm, zs);
+}
+
+inline glm::mat3 GetBicubicFunctionDXZMatrix(const glm::mat4& coeffs)
+{
+	glm::mat3 m(glm::uninitialize);
+	for (int i = 0; i < 3; i++) for (int j = 0; j < 3; j++) m[i][j] = coeffs[i + 1][j + 1] * i * j;
+	return m;
+}
+
+inline float EvaluateBicubicFunctionDerivativeXZ(const glm::mat3& dxzm, float x, float z)
+{
+	glm::vec3 xs(1.0f, x, x * x);
+	glm::vec3 zs(1.0f, z, z * z);
+	return glm::dot(xs * dxzm, zs);
+}
+
+inline glm::vec2 EvaluateBicubicFunctionGradient(const glm::mat4x3& dxm, const glm::mat3x4& dzm, float x, float z)
+{
+	return {
+		EvaluateBicubicFunctionDerivativeX(dxm, x, z),
+		EvaluateBicubicFunctionDerivativeZ(dzm, x, z) };
+}
+
+inline glm::mat2 EvaluateBicubicFunctionHessianMatrix(const glm::mat4x2& dxxm, const glm::mat2x4& dzzm, const glm::mat3& dxzm,
+	float x, float z)
+{
+	auto dxx = EvaluateBicubicFunctionDerivativeXX(dxxm, x, z);
+	auto dzz = EvaluateBicubicFunctionDerivativeZZ(dzzm, x, z);
+	auto dxz = EvaluateBicubicFunctionDerivativeXZ(dxzm, x, z);
+	return { dxx, dxz, dxz, dzz };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline float GetCubicFunctionValue3(float a, float b, float c, float x)
+{
+	return ((a * x + b) * x + c) * x;
+}
+
+// Returns the minimum and the maximum of the function: a * x^3 + b * x^2 + c * x + const on the [0, 1] interval.
+inline glm::vec2 GetCubicFunctionMinimumAndMaximumArg(float a, float b, float c)
+{
+	struct SortS { float X, Y; bool operator<(const SortS& other) const { NumericalLessCompareBlock(Y); return X < other.X; } };
+	SortS points[4];
+	points[0] = { 0.0f, 0.0f };
+	points[1] = { 1.0f, a + b + c };
+	int countPoints = 2;
+
+	float qb = 2.0f * b;
+
+	if (std::fabsf(a) < 1e-5f)
+	{
+		if (std::fabsf(b) >= 1e-5f)
+		{
+			float x = -c / qb;
+			if (x >= 0.0f && x <= 1.0f) points[countPoints++] = { x, GetCubicFunctionValue3(a, b, c, x) };
+		}
+	}
+	else
 	{
-		for (int x = sX1; x <= eX1; x++)
+		float qa = 3.0f * a;
+		float d = qb * qb - 4.0f * qa * c;
+		if (d >= 0.0f)
 		{
-			UpdateDerivatives(fields, m_CountFields, x, y, dxs, dys, dxys);
+			float dr = std::sqrtf(d);
+			float div = 0.5f / qa;
+			float x0 = (-qb + dr) * div;
+			float x1 = (-qb - dr) * div;
+			if (x0 >= 0.0f && x0 <= 1.0f) points[countPoints++] = { x0, GetCubicFunctionValue3(a, b, c, x0) };
+			if (x1 >= 0.0f && x1 <= 1.0f) points[countPoints++] = { x1, GetCubicFunctionValue3(a, b, c, x1) };
 		}
 	}
-	for (int y = sY2; y <= eY2; y++)
+
+	std::sort(points, points + countPoints);
+
+	return { points[0].X, points[countPoints - 1].X };
+}
+
+inline void LimitStep(float x, float step, float* pT)
+{
+	if (x + step < 0.0f)* pT = std::min(*pT, -x / step);
+	else if (x + step > 1.0f)* pT = std::min(*pT, (1.0f - x) / step);
+	assert(*pT >= 0.0f);
+}
+
+inline glm::vec2 GetLocalExtremaArg(bool isMaximum, const glm::vec2& start, const glm::mat4& coeffs, const glm::mat4x3& dxm, const glm::mat3x4& dzm,
+	const glm::mat4x2& dxxm, const glm::mat2x4& dzzm, const glm::mat3& dxzm)
+{
+	const glm::vec2 limitMin = glm::vec2(0.0f);
+	const glm::vec2 limitMax = glm::vec2(1.0f);
+	const float gamma = 1.0f;
+
+	auto x = start;
+
+	// We use Newton's method with a modification: we aim to step toward the smaller or greater values (depending on whether we
+	// minimize or maximize) and not towards f'(x) = 0. If the nearest stationary point happens to change the function in the desired
+	// direction the modification makes no difference, otherwise we step in the opposite direction.
+	const int maxIterations = 16;
+	for (int i = 0; i < maxIterations; i++)
 	{
-		for (int x = sX2; x <= eX2; x++)
+		auto gradient = EvaluateBicubicFunctionGradient(dxm, dzm, x.x, x.y);
+		auto hessian = EvaluateBicubicFunctionHessianMatrix(dxxm, dzzm, dxzm, x.x, x.y);
+		auto invHessian = (std::fabsf(glm::determinant(hessian)) < 1e-5f ? glm::mat2() : glm::inverse(hessian));
+
+		auto step = gamma * invHessian * gradient;
+
+		if (glm::length(step) < 1e-6f) break;
+
+		// Computing step sign.
+		auto epsStepped = x + glm::normalize(step) * 1e-4f;
+		bool newSmaller = (EvaluateBicubicFunctionValue(coeffs, epsStepped.x, epsStepped.y) < EvaluateBicubicFunctionValue(coeffs, x.x, x.y));
+		if (newSmaller == isMaximum)
 		{
-			auto fieldIndex = y * m_CountFields.x + x;
-			m_SurfaceCoefficients[fieldIndex] = GetCoeffMatrix(fields, m_CountFields, x, y, dxs, dys, dxys);
+			step *= -1.0f;
 		}
+
+		float t = 1.0f;
+		LimitStep(x.x, step.x, &t);
+		LimitStep(x.y, step.y, &t);
+		step *= t;
+
+		if (glm::length(step) < 1e-6f) break;
+
+		x = glm::clamp(x + step, limitMin, limitMax);
 	}
+
+	return x;
+}
+
+glm::vec2 Terrain::GetFieldSurfaceHeightMinMax(const glm::mat4& coeffs)
+{
+	if (IsFunctionConstant(coeffs)) return GetConstantFunctionMinMax(coeffs);
+	if (IsFunctionBilinear(coeffs)) return GetBilinearFunctionMinMax(coeffs);
+
+	auto dxm = GetBicubicFunctionDXMatrix(coeffs);
+	auto dzm = GetBicubicFunctionDZMatrix(coeffs);
+	auto dxxm = GetBicubicFunctionDXXMatrix(coeffs);
+	auto dzzm = GetBicubicFunctionDZZMatrix(coeffs);
+	auto dxzm = GetBicubicFunctionDXZMatrix(coeffs);
+
+	glm::vec2 mm0 = GetCubicFunctionMinimumAndMaximumArg(coeffs[0][3], coeffs[0][2], coeffs[0][1]); // z = 0
+	glm::vec2 mm1 = GetCubicFunctionMinimumAndMaximumArg(coeffs[3][0], coeffs[2][0], coeffs[1][0]); // x = 0
+	glm::vec2 mm2 = GetCubicFunctionMinimumAndMaximumArg(
+		coeffs[0][3] + coeffs[1][3] + coeffs[2][3] + coeffs[3][3],
+		coeffs[0][2] + coeffs[1][2] + coeffs[2][2] + coeffs[3][2],
+		coeffs[0][1] + coeffs[1][1] + coeffs[2][1] + coeffs[3][1]); // z = 1
+	glm::vec2 mm3 = GetCubicFunctionMinimumAndMaximumArg(
+		coeffs[3][0] + coeffs[3][1] + coeffs[3][2] + coeffs[3][3],
+		coeffs[2][0] + coeffs[2][1] + coeffs[2][2] + coeffs[2][3],
+		coeffs[1][0] + coeffs[1][1] + coeffs[1][2] + coeffs[1][3]); // x = 1
+
+	glm::vec2 mins[5], maxs[5];
+	mins[0] = GetLocalExtremaArg(false, glm::vec2(mm0.x, 0.0f), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	maxs[0] = GetLocalExtremaArg(true, glm::vec2(mm0.y, 0.0f), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	mins[1] = GetLocalExtremaArg(false, glm::vec2(0.0f, mm1.x), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	maxs[1] = GetLocalExtremaArg(true, glm::vec2(0.0f, mm1.y), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	mins[2] = GetLocalExtremaArg(false, glm::vec2(mm2.x, 1.0f), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	maxs[2] = GetLocalExtremaArg(true, glm::vec2(mm2.y, 1.0f), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	mins[3] = GetLocalExtremaArg(false, glm::vec2(1.0f, mm3.x), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	maxs[3] = GetLocalExtremaArg(true, glm::vec2(1.0f, mm3.y), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	mins[4] = GetLocalExtremaArg(false, glm::vec2(0.5f, 0.5f), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+	maxs[4] = GetLocalExtremaArg(true, glm::vec2(0.5f, 0.5f), coeffs, dxm, dzm, dxxm, dzzm, dxzm);
+
+	struct SortS {
+		float X, Y, Z;
+		bool operator<(const SortS& other) const { NumericalLessCompareBlock(Y); NumericalLessCompareBlock(X); return Z < other.Z; }
+	};
+	SortS points[5];
+	glm::vec2 result;
+
+	for (int c = 0; c < 5; c++) points[c] = { mins[c].x, EvaluateBicubicFunctionValue(coeffs, mins[c].x, mins[c].y), mins[c].y };
+	std::sort(points, points + 5);
+	result.x = points[0].Y;
+
+	for (int c = 0; c < 5; c++) points[c] = { maxs[c].x, EvaluateBicubicFunctionValue(coeffs, maxs[c].x, maxs[c].y), maxs[c].y };
+	std::sort(points, points + 5);
+	result.y = points[4].Y;
+
+	return result;
 }
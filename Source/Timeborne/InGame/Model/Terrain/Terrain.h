@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <Timeborne/DataStructures/MappableVector.h>
+#include <Timeborne/Declarations/CoreDeclarations.h>
+
 #include <Core/DataStructures/SimpleTypeVector.hpp>
 #include <Core/DataStructures/SimpleTypeUnorderedVector.hpp>
 #include <EngineBuildingBlocks/Math/GLM.h>
@@ -31,16 +34,28 @@ class Terrain
 	glm::uvec2 m_CountFields;
 
 	// Edit view of the terrain: 4 corner editable height values per field.
-	Core::SimpleTypeVectorU<FieldData> m_Fields;
+	MappableVector<FieldData> m_Fields;
 
 	// Render and compute view of the terrain: per-field derivatives and 4x4 matrix coefficients.
 	// They represent a per-field bicubic spline, where derivatives are synchronized between same-position
 	// corners.
-	Core::SimpleTypeVectorU<glm::vec4> m_DX, m_DY, m_DXY;
-	Core::SimpleTypeVectorU<glm::mat4> m_SurfaceCoefficients;
+	MappableVector<glm::vec4> m_DX, m_DY, m_DXY;
+	MappableVector<glm::mat4> m_SurfaceCoefficients;
 
 	void CreateSurfaceData();
 
+private: // Surface data update.
+
+	// The rows of the fields are processed in parallel, the tasks are the rows of the current rectangle.
+	glm::ivec2 m_SurfaceUpdateStart, m_SurfaceUpdateEnd;
+
+	using SurfaceUpdateFunction = void (Terrain::*)(unsigned, unsigned, unsigned);
+
+	void ExecuteSurfaceUpdateFunction(Core::ThreadPool* threadPool, const glm::ivec2& start, const glm::ivec2& end,
+		SurfaceUpdateFunction function);
+	void UpdateDerivativesInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void UpdateCoefficientsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+
 public:
 
 	Terrain();
@@ -60,16 +75,37 @@ public:
 	glm::vec3 GetMiddlePosition(const glm::ivec2& fieldIndex) const;
 	glm::vec3 GetNormal(const glm::ivec2& fieldIndex, float xInField, float zInField) const;
 
-	const Core::SimpleTypeVectorU<glm::mat4>& GetSurfaceCoefficients() const;
+	struct SurfaceSample
+	{
+		glm::ivec2 FieldIndex;
+		float XInField, ZInField;
+	};
 
-	void UpdateSurfaceData(const glm::ivec2& changeStart, const glm::ivec2& changeEnd);
+	// Evaluates the heights and the normals of the samples in a single vectorized pass.
+	// The results are equal to the ones of 'GetHeight' and 'GetNormal'.
+	void GetHeightsAndNormals(const SurfaceSample* samples, unsigned countSamples,
+		float* heights, glm::vec3* normals) const;
+
+	const MappableVector<glm::mat4>& GetSurfaceCoefficients() const;
+
+	// Recomputes the surface data that depends on the heights in the given rectangle.
+	// The thread pool is optional.
+	void UpdateSurfaceData(const glm::ivec2& changeStart, const glm::ivec2& changeEnd, Core::ThreadPool* threadPool);
 
 	static const float* GetFieldHeights(const FieldData* fields, const glm::uvec2& countFields, int x, int z);
 	static glm::vec2 GetFieldHeightMinMax(const FieldData* fields, const glm::uvec2& countFields, int x, int z);
 	static float GetFieldHeight(const FieldData* fields, const glm::uvec2& countFields, int x, int z, int fId);
 
+	// Returns the minimum and the maximum of the bicubic surface of a field.
+	static glm::vec2 GetFieldSurfaceHeightMinMax(const glm::mat4& coeffs);
+
 	void SerializeSB(Core::ByteVector& bytes) const;
-	void DeserializeSB(const unsigned char*& bytes, bool forceRecomputations);
+	void DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source, bool forceRecomputations,
+		Core::ThreadPool* threadPool);
+	void DeserializeLegacySB(const unsigned char*& bytes, bool forceRecomputations, Core::ThreadPool* threadPool);
+
+	// Copies the data that is mapped from a level file.
+	void CopyMappedData();
 
 	static void GetFlippedLimits(const glm::ivec2& start, const glm::ivec2& end,
 		glm::ivec2* pStart, glm::ivec2* pEnd);
@@ -0,0 +1,76 @@
+// Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.cpp
+
+#include <Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h>
+
+#include <Timeborne/InGame/Model/Terrain/Terrain.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
+#include <Timeborne/InputHandling.h>
+
+#include <Core/Constants.h>
+#include <EngineBuildingBlocks/Graphics/Camera/Camera.h>
+#include <EngineBuildingBlocks/Math/Intersection.h>
+
+using namespace EngineBuildingBlocks::Graphics;
+using namespace EngineBuildingBlocks::Math;
+
+inline void SetIntersectionToGrid(int blockSize, int size, float& worldIntersection, int& start, int& end)
+{
+	int hBlockSize = blockSize >> 1;
+	if ((blockSize & 1) == 0)
+	{
+		int indexIntersection = (int)glm::round(worldIntersection);
+		worldIntersection = (float)indexIntersection;
+		start = std::max((int)indexIntersection - (int)hBlockSize, 0);
+		end = std::min((int)indexIntersection + (int)hBlockSize - 1, size - 1);
+	}
+	else
+	{
+		int indexIntersection = (int)glm::floor(worldIntersection);
+		worldIntersection = (float)indexIntersection;
+		start = std::max((int)indexIntersection - (int)hBlockSize, 0);
+		end = std::min((int)indexIntersection + (int)hBlockSize, size - 1);
+	}
+}
+
+TerrainBlockIntersection GetTerrainBlockIntersection(Camera* camera,
+	const glm::uvec2& windowsSize, const glm::uvec2& contentSize,
+	const TerrainTree& terrainTree, const glm::ivec2& blockSize,
+	const glm::vec2& cursorPositionInScreen)
+{
+	assert(camera != nullptr);
+
+	glm::vec3 rayOrigin, rayDirection;
+	bool rayValid;
+	GetContentCursorRayInWorldCs(windowsSize, contentSize, *camera, false, rayOrigin, rayDirection, rayValid,
+		cursorPositionInScreen);
+
+	TerrainBlockIntersection result;
+
+	// Intersecting the terrain tree.
+	auto t = terrainTree.IntersectRay(rayOrigin, rayDirection);
+	if (t == c_InvalidIntersectionT) result.HasIntersection = false;
+	else
+	{
+		auto countFields = terrainTree.GetTerrain().GetCountFields();
+
+		auto worldIntersection = rayOrigin + rayDirection * t;
+		auto originalWorldIntersection = worldIntersection;
+		SetIntersectionToGrid(blockSize.x, countFields.x, worldIntersection.x, result.Start.x, result.End.x);
+		SetIntersectionToGrid(blockSize.y, countFields.y, worldIntersection.z, result.Start.y, result.End.y);
+		result.HasIntersection = (result.Start.x < (int)countFields.x && result.Start.y < (int)countFields.y
+			&& result.End.x >= 0 && result.End.y >= 0);
+
+		result.CornerIndex = Core::c_InvalidIndexU;
+		if (blockSize.x == 1 && blockSize.y == 1)
+		{
+			auto x = std::fmod(originalWorldIntersection.x, 1.0f);
+			auto z = std::fmod(originalWorldIntersection.z, 1.0f);
+			if (x + z < 0.5f) result.CornerIndex = 3;
+			else if (x + z > 1.5f) result.CornerIndex = 1;
+			else if (z - x > 0.5f) result.CornerIndex = 0;
+			else if (x - z > 0.5f) result.CornerIndex = 2;
+		}
+	}
+
+	return result;
+}
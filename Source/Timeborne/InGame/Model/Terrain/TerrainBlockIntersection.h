@@ -0,0 +1,22 @@
+// Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h
+
+#pragma once
+
+#include <Timeborne/Declarations/EngineBuildingBlocksDeclarations.h>
+
+#include <EngineBuildingBlocks/Math/GLM.h>
+
+class TerrainTree;
+
+struct TerrainBlockIntersection
+{
+	bool HasIntersection;
+	glm::ivec2 Start, End;
+	unsigned CornerIndex;
+};
+
+TerrainBlockIntersection GetTerrainBlockIntersection(
+	EngineBuildingBlocks::Graphics::Camera* camera, const glm::uvec2& windowsSize,
+	const glm::uvec2& contentSize,
+	const TerrainTree& terrainTree, const glm::ivec2& blockSize,
+	const glm::vec2& cursorPositionInScreen);
@@ -3,14 +3,15 @@
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
 
 #include <Timeborne/InGame/Model/Terrain/Terrain.h>
-#include <Timeborne/MainApplication.h>
 
-#include <Core/System/Filesystem.h>
-#include <Core/System/SimpleIO.h>
 #include <Core/System/ThreadPool.h>
 #include <Core/Constants.h>
 #include <Core/SimpleBinarySerialization.hpp>
 #include <EngineBuildingBlocks/Graphics/Camera/Camera.h>
+#include <EngineBuildingBlocks/Math/Intersection.h>
+#include <EngineBuildingBlocks/Math/IntervalArithmetic.h>
+
+#include <unordered_map>
 
 using namespace EngineBuildingBlocks;
 using namespace EngineBuildingBlocks::Graphics;
@@ -39,17 +40,123 @@ CORE_FORCEINLINE bool isValidField(const glm::ivec2& fieldIndex, const glm::uvec
 		&& fieldIndex.y >= 0 && fieldIndex.y < (int)countFields.y;
 };
 
+// Indexing is consistent with the direction flags.
+const glm::ivec2 c_DirectionOffsets[8] = {
+	{ 0, -1 }, { 1, -1 }, { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 } };
+
+constexpr unsigned c_MinCountParallelBuildTasks = 1024;
+constexpr unsigned c_BuildTaskPackageSize = 256;
+
+// Returns whether the field is connected with its neighbor in the North, NorthEast, East or SouthEast direction.
+inline bool IsLeafConnected(const FieldData* fields, const glm::uvec2& countFields, const glm::ivec2& fieldIndex,
+	unsigned direction)
+{
+	auto getHeights = [fields, &countFields](const glm::ivec2& fieldIndex) {
+		return Terrain::GetFieldHeights(fields, countFields, fieldIndex.x, fieldIndex.y);
+	};
+	glm::ivec2 lastFieldIndex = glm::ivec2(countFields) - 1;
+	auto heights = getHeights(fieldIndex);
+
+	switch (direction)
+	{
+		case 0:
+		{
+			if (fieldIndex.y == 0) return false;
+			auto neighborHeights = getHeights(fieldIndex + glm::ivec2(0, -1));
+			return (heights[3] == neighborHeights[0] && heights[2] == neighborHeights[1]);
+		}
+		case 1:
+		{
+			if (fieldIndex.x == lastFieldIndex.x || fieldIndex.y == 0) return false;
+			float height = heights[2];
+			auto diagHeights = getHeights(fieldIndex + glm::ivec2(1, -1));
+			auto northHeights = getHeights(fieldIndex + glm::ivec2(0, -1));
+			auto eastHeights = getHeights(fieldIndex + glm::ivec2(1, 0));
+			return (diagHeights[0] == height && northHeights[1] == height && eastHeights[3] == height);
+		}
+		case 2:
+		{
+			if (fieldIndex.x == lastFieldIndex.x) return false;
+			auto neighborHeights = getHeights(fieldIndex + glm::ivec2(1, 0));
+			return (heights[1] == neighborHeights[0] && heights[2] == neighborHeights[3]);
+		}
+		case 3:
+		{
+			if (fieldIndex.x == lastFieldIndex.x || fieldIndex.y == lastFieldIndex.y) return false;
+			float height = heights[1];
+			auto diagHeights = getHeights(fieldIndex + glm::ivec2(1, 1));
+			auto southHeights = getHeights(fieldIndex + glm::ivec2(0, 1));
+			auto eastHeights = getHeights(fieldIndex + glm::ivec2(1, 0));
+			return (diagHeights[3] == height && southHeights[2] == height && eastHeights[0] == height);
+		}
+		default: assert(false); return false;
+	}
+}
+
+// Only the field's own connections are checked in the North, NorthEast, East and SouthEast directions.
+// The opposite directions are checked from the neighbor, so that the flags are symmetric.
+inline TerrainTree::NodeFlags ComputeLeafFlags(const FieldData* fields, const glm::uvec2& countFields,
+	const glm::ivec2& fieldIndex)
+{
+	using NodeFlags = TerrainTree::NodeFlags;
+	auto flags = NodeFlags::None;
+	for (unsigned d = 0; d < 4; d++)
+	{
+		if (IsLeafConnected(fields, countFields, fieldIndex, d))
+		{
+			flags |= (NodeFlags)(1 << d);
+		}
+		auto neighborFieldIndex = fieldIndex + c_DirectionOffsets[d + 4];
+		if (isValidField(neighborFieldIndex, countFields)
+			&& IsLeafConnected(fields, countFields, neighborFieldIndex, d))
+		{
+			flags |= (NodeFlags)(1 << (d + 4));
+		}
+	}
+	return flags;
+}
+
+// Lock-free union-find. The parents only change from roots to lower indices, so the path halving only stores
+// ancestors, even if it's executed concurrently.
+inline unsigned FindIslandRoot(std::atomic<unsigned>* parents, unsigned index)
+{
+	while (true)
+	{
+		unsigned parent = parents[index].load(std::memory_order_relaxed);
+		if (parent == index) return index;
+		unsigned grandParent = parents[parent].load(std::memory_order_relaxed);
+		if (grandParent != parent) parents[index].store(grandParent, std::memory_order_relaxed);
+		index = grandParent;
+	}
+}
+
+inline void UniteIslands(std::atomic<unsigned>* parents, unsigned index0, unsigned index1)
+{
+	while (true)
+	{
+		index0 = FindIslandRoot(parents, index0);
+		index1 = FindIslandRoot(parents, index1);
+		if (index0 == index1) return;
+
+		// Linking the higher root to the lower one.
+		if (index0 < index1) std::swap(index0, index1);
+		unsigned expected = index0;
+		if (parents[index0].compare_exchange_weak(expected, index1)) return;
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 TerrainTree::TerrainTree(const Terrain& terrain)
 	: m_Terrain(terrain)
 {
+	UpdateChangeStamp();
 }
 
-TerrainTree::TerrainTree(const Terrain& terrain, const MainApplication* application)
+TerrainTree::TerrainTree(const Terrain& terrain, Core::ThreadPool* threadPool)
 	: m_Terrain(terrain)
 {
-	BuildTree(application);
+	BuildTree(threadPool);
 }
 
 inline void Subdivide(const glm::ivec2& start, const glm::ivec2& end, int& countChildren, glm::ivec2* starts, glm::ivec2* ends)
@@ -75,378 +182,716 @@ inline void Subdivide(const glm::ivec2& start, const glm::ivec2& end, int& count
 	}
 }
 
-void TerrainTree::BuildTree(const MainApplication* application)
+void TerrainTree::InitializeLevels()
 {
 	auto countFields = m_Terrain.GetCountFields();
-	char dataPath[256];
-	std::snprintf(dataPath, 256, "TerrainTree_%dx%d.bin", countFields.x, countFields.y);
-	auto constantDataPath = application->GetPathHandler()->GetPathFromBuiltResourcesDirectory(dataPath);
-	bool constantDataExists = Core::FileExists(constantDataPath);
-
-	ConstantData constantData;
-	if (constantDataExists) LoadConstantData(constantData, constantDataPath);
 
-	LocationHashToIndexMap locationHashToIndexMap;
-	CreateNodes(constantDataExists, locationHashToIndexMap);
-	ComputeNeighbors(constantDataExists, locationHashToIndexMap, constantData);
-	ComputeLeafConnectivity();
-	ComputeInnerNodeData();
+	m_Levels.clear();
+	m_LeafOffsetsX.Clear();
+	m_LeafOffsetsZ.Clear();
+	if (countFields.x == 0 || countFields.y == 0) return;
 
-	InitializeIslandIndices();
-	ComputeLeafIslands();
+	// The implicit indexing requires the complete tree.
+	assert((countFields.x & (countFields.x - 1)) == 0 && (countFields.y & (countFields.y - 1)) == 0);
 
-	if (!constantDataExists) SaveConstantData(constantData, constantDataPath);
-}
+	glm::ivec2 nodeSize(countFields);
+	unsigned countBits = 0;
+	// The offset shift is set to the count of bits in the level's offsets until all levels are created.
+	m_Levels.push_back({ 0, 1, 0, 0, nodeSize });
+	while (nodeSize.x > 1 || nodeSize.y > 1)
+	{
+		bool isSplittingX = (nodeSize.x >= nodeSize.y && nodeSize.x > 1);
+		bool isSplittingZ = (nodeSize.y >= nodeSize.x && nodeSize.y > 1);
+		unsigned countLevelBits = (isSplittingX ? 1 : 0) + (isSplittingZ ? 1 : 0);
+		if (isSplittingX) nodeSize.x /= 2;
+		if (isSplittingZ) nodeSize.y /= 2;
+		countBits += countLevelBits;
+
+		auto& parentLevel = m_Levels.back();
+		parentLevel.CountChildren = 1 << countLevelBits;
+		m_Levels.push_back({ parentLevel.StartNodeIndex + parentLevel.CountNodes, 1U << countBits, 0, countBits,
+			nodeSize });
+	}
 
-void TerrainTree::ConstantData::SerializeSB(Core::ByteVector& bytes) const
-{
-	Core::SerializeSB(bytes, NeighborIndices);
-}
+	// Computing the leaf offsets. The child index is: Z bit * 2 + X bit for quadtree subdivision,
+	// and the X or Z bit otherwise.
+	m_LeafOffsetsX.PushBack(0, countFields.x);
+	m_LeafOffsetsZ.PushBack(0, countFields.y);
+	unsigned countLevels = (unsigned)m_Levels.size();
+	for (unsigned i = 1; i < countLevels; i++)
+	{
+		auto& level = m_Levels[i];
+		auto& parentLevel = m_Levels[i - 1];
+		level.OffsetShift = countBits - level.OffsetShift;
 
-void TerrainTree::ConstantData::DeserializeSB(const unsigned char*& bytes)
-{
-	Core::DeserializeSB(bytes, NeighborIndices);
+		unsigned bitIndex = level.OffsetShift;
+		if (level.NodeSize.x != parentLevel.NodeSize.x)
+		{
+			for (unsigned x = 0; x < countFields.x; x++)
+			{
+				m_LeafOffsetsX[x] |= ((x / (unsigned)level.NodeSize.x) & 1) << bitIndex;
+			}
+			bitIndex++;
+		}
+		if (level.NodeSize.y != parentLevel.NodeSize.y)
+		{
+			for (unsigned z = 0; z < countFields.y; z++)
+			{
+				m_LeafOffsetsZ[z] |= ((z / (unsigned)level.NodeSize.y) & 1) << bitIndex;
+			}
+		}
+	}
 }
 
-void TerrainTree::LoadConstantData(ConstantData& constantData, const std::string& filePath)
+unsigned TerrainTree::GetNodeIndex(unsigned levelIndex, const glm::ivec2& startFieldIndex) const
 {
-	Core::ByteVector bytes;
-	Core::ReadAllBytes(filePath, bytes);
-	Core::StartDeserializeSB(bytes, constantData);
+	if (!isValidField(startFieldIndex, m_Terrain.GetCountFields())) return Core::c_InvalidIndexU;
+	auto& level = m_Levels[levelIndex];
+	return level.StartNodeIndex
+		+ ((m_LeafOffsetsX[startFieldIndex.x] | m_LeafOffsetsZ[startFieldIndex.y]) >> level.OffsetShift);
 }
 
-void TerrainTree::SaveConstantData(const ConstantData& constantData, const std::string& filePath)
+void TerrainTree::ExecuteBuildFunction(Core::ThreadPool* threadPool, unsigned countTasks, BuildFunction function)
 {
-	Core::ByteVector bytes;
-	Core::StartSerializeSB(bytes, constantData);
-	Core::WriteAllBytes(filePath, bytes);
+	if (threadPool != nullptr && countTasks >= c_MinCountParallelBuildTasks)
+	{
+		threadPool->ExecuteWithDynamicScheduling(countTasks, function, this, c_BuildTaskPackageSize);
+	}
+	else
+	{
+		(this->*function)(0, 0, countTasks);
+	}
 }
 
-void TerrainTree::CreateNodes(bool constantDataExists, LocationHashToIndexMap& locationHashToIndexMap)
+void TerrainTree::BuildTree(Core::ThreadPool* threadPool)
 {
-	auto fields = m_Terrain.GetFields();
 	auto countFields = m_Terrain.GetCountFields();
-
 	m_CountLeafs = countFields.x * countFields.y;
 
-	m_TerrainFieldToNodeIndex.Resize(m_CountLeafs);
+	InitializeLevels();
+
+	auto& leafLevel = m_Levels.back();
+	unsigned countNodes = leafLevel.StartNodeIndex + leafLevel.CountNodes;
+	assert(leafLevel.CountNodes == m_CountLeafs);
 
 	m_Nodes.Clear();
-	Node rootNode;
-	rootNode.Parent = Core::c_InvalidIndexU;
-	std::fill(rootNode.Children, rootNode.Children + 4, Core::c_InvalidIndexU);
-	rootNode.Start = { 0, 0 };
-	rootNode.End = { glm::ivec2(countFields) - 1 };
-	rootNode.MinHeight = 0.0f;
-	rootNode.MaxHeight = 0.0f;
-	rootNode.Flags = NodeFlags::None;
-	std::fill(rootNode.Neighbors, rootNode.Neighbors + 8, Core::c_InvalidIndexU);
-	m_Nodes.PushBack(rootNode);
-	if (!constantDataExists)
+	m_Nodes.Resize(countNodes);
+	m_SurfaceHeightBounds.Clear();
+	m_SurfaceHeightBounds.Resize(countNodes);
+	m_TerrainFieldToNodeIndex.Clear();
+	m_TerrainFieldToNodeIndex.Resize(m_CountLeafs);
+
+	// The root node. The other nodes are created level by level: each node creates its children in the next level.
+	InitializeNode(m_Nodes[0], Core::c_InvalidIndexU, glm::ivec2(0), glm::ivec2(countFields) - 1);
+	unsigned countLevels = (unsigned)m_Levels.size();
+	for (m_BuildLevelIndex = 0; m_BuildLevelIndex + 1 < countLevels; m_BuildLevelIndex++)
 	{
-		locationHashToIndexMap.insert(std::make_pair(GetNodeLocationHash(rootNode.Start, countFields), 0U));
+		ExecuteBuildFunction(threadPool, m_Levels[m_BuildLevelIndex].CountNodes, &TerrainTree::CreateChildNodesInThread);
 	}
+	if (countLevels == 1) SetLeafData(m_Nodes[0], 0);
+
+	ExecuteBuildFunction(threadPool, m_CountLeafs, &TerrainTree::ComputeLeafConnectivityInThread);
 
-	std::queue<unsigned> nodesToProcess;
-	if (countFields.x > 1 || countFields.y > 1)
+	// The inner node data is computed bottom-up.
+	for (m_BuildLevelIndex = countLevels - 1; m_BuildLevelIndex-- > 0;)
 	{
-		nodesToProcess.push(0);
+		ExecuteBuildFunction(threadPool, m_Levels[m_BuildLevelIndex].CountNodes,
+			&TerrainTree::ComputeInnerNodeDataInThread);
 	}
 
-	while (!nodesToProcess.empty())
+	InitializeIslandIndices();
+	ComputeLeafIslands(threadPool);
+
+	UpdateChangeStamp();
+}
+
+void TerrainTree::InitializeNode(Node& node, unsigned parentIndex, const glm::ivec2& start, const glm::ivec2& end)
+{
+	node.Parent = parentIndex;
+	std::fill(node.Children, node.Children + 4, Core::c_InvalidIndexU);
+	std::fill(node.Neighbors, node.Neighbors + 8, Core::c_InvalidIndexU);
+	node.Start = start;
+	node.End = end;
+	node.MinHeight = 0.0f;
+	node.MaxHeight = 0.0f;
+	node.Flags = NodeFlags::None;
+}
+
+void TerrainTree::SetLeafData(Node& node, unsigned nodeIndex)
+{
+	auto heightMinMax = Terrain::GetFieldHeightMinMax(m_Terrain.GetFields(), m_Terrain.GetCountFields(),
+		node.Start.x, node.Start.y);
+	node.MinHeight = heightMinMax.x;
+	node.MaxHeight = heightMinMax.y;
+	GetNodeIndexForFieldRef(node.Start) = nodeIndex;
+	SetLeafSurfaceHeightBounds(nodeIndex);
+}
+
+void TerrainTree::CreateChildNodesInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	auto& level = m_Levels[m_BuildLevelIndex];
+	unsigned childLevelIndex = m_BuildLevelIndex + 1;
+	auto& childLevel = m_Levels[childLevelIndex];
+	bool isChildLevelLeaf = (childLevelIndex + 1 == (unsigned)m_Levels.size());
+	auto childSize = childLevel.NodeSize;
+
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
 	{
-		auto nodeIndex = nodesToProcess.front();
-		nodesToProcess.pop();
+		unsigned nodeIndex = level.StartNodeIndex + i;
+		auto& node = m_Nodes[nodeIndex];
 
-		// Creating children.
 		int countChildren;
 		glm::ivec2 starts[4];
 		glm::ivec2 ends[4];
-		Subdivide(m_Nodes[nodeIndex].Start, m_Nodes[nodeIndex].End, countChildren, starts, ends);
+		Subdivide(node.Start, node.End, countChildren, starts, ends);
+		assert((unsigned)countChildren == level.CountChildren);
 
-		for (int i = 0; i < countChildren; i++)
+		unsigned firstChildNodeIndex = childLevel.StartNodeIndex + i * level.CountChildren;
+		for (int c = 0; c < countChildren; c++)
 		{
-			// The storage guarentees indices, therefore reaccess is necessary.
-			auto& node = m_Nodes[nodeIndex];
+			unsigned childNodeIndex = firstChildNodeIndex + c;
+			auto& childNode = m_Nodes[childNodeIndex];
+			InitializeNode(childNode, nodeIndex, starts[c], ends[c]);
 
-			unsigned childNodeIndex = m_Nodes.GetSize();
+			auto start = childNode.Start;
+			for (unsigned d = 0; d < 8; d++)
+			{
+				childNode.Neighbors[d] = GetNodeIndex(childLevelIndex, start + c_DirectionOffsets[d] * childSize);
+			}
 
-			// Creating child node.
-			Node childNode;
-			childNode.Parent = nodeIndex;
-			std::fill(childNode.Children, childNode.Children + 4, Core::c_InvalidIndexU);
-			childNode.Start = starts[i];
-			childNode.End = ends[i];
-			childNode.Flags = NodeFlags::None;
-			std::fill(childNode.Neighbors, childNode.Neighbors + 8, Core::c_InvalidIndexU);
+			if (isChildLevelLeaf) SetLeafData(childNode, childNodeIndex);
 
-			bool isLeaf = (childNode.Start == childNode.End);
+			node.Children[c] = childNodeIndex;
+		}
+	}
+}
 
-			glm::vec2 heightMinMax;
-			if (isLeaf)
-			{
-				heightMinMax = Terrain::GetFieldHeightMinMax(fields, countFields, childNode.Start.x, childNode.Start.y);
+void TerrainTree::ComputeLeafConnectivityInThread(unsigned threadId, unsigned startTaskIndex,
+	unsigned endTaskIndex)
+{
+	auto fields = m_Terrain.GetFields();
+	auto countFields = m_Terrain.GetCountFields();
+	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
 
-				GetNodeIndexForFieldRef(childNode.Start) = childNodeIndex;
-			}
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		auto& node = m_Nodes[countInnerNodes + i];
+		node.Flags = ComputeLeafFlags(fields, countFields, node.Start);
+	}
+}
 
-			childNode.MinHeight = heightMinMax.x;
-			childNode.MaxHeight = heightMinMax.y;
+void TerrainTree::InitializeIslandIndices()
+{
+	m_IslandIndices.Clear();
+	m_IslandIndices.PushBack(Core::c_InvalidIndexU, m_Nodes.GetSize());
+}
 
-			// Setting the child for the parent.
-			node.Children[i] = childNodeIndex;
+void TerrainTree::ComputeLeafIslands(Core::ThreadPool* threadPool)
+{
+	// Union-find over the leafs, where the root of an island is always its leaf with the lowest index.
+	// The island indices are assigned in the order of the roots, which results the same indices
+	// as searching the islands from the leafs in order.
+	m_IslandParents = std::vector<std::atomic<unsigned>>(m_CountLeafs);
+	ExecuteBuildFunction(threadPool, m_CountLeafs, &TerrainTree::InitializeIslandParentsInThread);
+	ExecuteBuildFunction(threadPool, m_CountLeafs, &TerrainTree::UniteLeafIslandsInThread);
+	ExecuteBuildFunction(threadPool, m_CountLeafs, &TerrainTree::FindIslandRootsInThread);
 
-			if (!constantDataExists)
-			{
-				locationHashToIndexMap.insert(std::make_pair(
-					GetNodeLocationHash(childNode.Start, ::GetNodeSize(childNode)),
-					m_Nodes.GetSize()));
-			}
-			m_Nodes.PushBack(childNode);
+	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
+	unsigned islandIndex = 0;
+	for (unsigned i = 0; i < m_CountLeafs; i++)
+	{
+		unsigned root = m_IslandParents[i].load(std::memory_order_relaxed);
+		m_IslandIndices[countInnerNodes + i] = (root == i) ? islandIndex++ : m_IslandIndices[countInnerNodes + root];
+	}
+
+	m_IslandParents = std::vector<std::atomic<unsigned>>();
+}
+
+void TerrainTree::InitializeIslandParentsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		m_IslandParents[i].store(i, std::memory_order_relaxed);
+	}
+}
+
+void TerrainTree::UniteLeafIslandsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	auto parents = m_IslandParents.data();
+	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
 
-			if (!isLeaf)
+	// The connectivity is symmetric, so it's enough to unite along the half of the directions.
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		auto& node = m_Nodes[countInnerNodes + i];
+		for (unsigned d = 0; d < 4; d++)
+		{
+			if (HasDirection(node.Flags, d))
 			{
-				nodesToProcess.push(childNodeIndex);
+				UniteIslands(parents, i, node.Neighbors[d] - countInnerNodes);
 			}
 		}
 	}
+}
 
-	assert(constantDataExists || (unsigned)locationHashToIndexMap.size() == m_Nodes.GetSize());
+void TerrainTree::FindIslandRootsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
+{
+	auto parents = m_IslandParents.data();
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		parents[i].store(FindIslandRoot(parents, i), std::memory_order_relaxed);
+	}
 }
 
-void TerrainTree::ComputeNeighbors(bool constantDataExists, const LocationHashToIndexMap& locationHashToIndexMap,
-	ConstantData& constantData)
+void TerrainTree::ComputeInnerNodeDataInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex)
 {
-	unsigned countNodes = m_Nodes.GetSize();
+	auto& level = m_Levels[m_BuildLevelIndex];
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		ComputeInnerNodeData(level.StartNodeIndex + i);
+	}
+}
+
+void TerrainTree::ComputeInnerNodeData(unsigned nodeIndex)
+{
+	constexpr NodeFlags West0 = NodeFlags::West | NodeFlags::SouthWest;
+	constexpr NodeFlags North0 = NodeFlags::North | NodeFlags::NorthEast;
+	constexpr NodeFlags North1 = NodeFlags::North | NodeFlags::NorthWest;
+	constexpr NodeFlags East1 = NodeFlags::East | NodeFlags::SouthEast;
+	constexpr NodeFlags East3 = NodeFlags::East | NodeFlags::NorthEast;
+	constexpr NodeFlags South3 = NodeFlags::South | NodeFlags::SouthWest;
+	constexpr NodeFlags South2 = NodeFlags::South | NodeFlags::SouthEast;
+	constexpr NodeFlags West2 = NodeFlags::West | NodeFlags::NorthWest;
 
-	auto copySize = sizeof(unsigned) * 8;
-	if (!constantDataExists) constantData.NeighborIndices.Resize(countNodes * 8);
-	auto constDataPtr = (uint8_t*)constantData.NeighborIndices.GetArray();
+	auto diagonalFlag = [](NodeFlags flags, NodeFlags target) {
+		return flags & target;
+	};
+	auto sideFlag = [](NodeFlags flags, NodeFlags mask, NodeFlags target) { 
+		return ((bool)(flags & mask) ? target : NodeFlags::None);
+	};
 
-	if (constantDataExists)
-	{	
-		for (unsigned i = 0; i < countNodes; i++, constDataPtr += copySize)
+	auto& node = m_Nodes[nodeIndex];
+	auto children = (const unsigned*)node.Children;
+
+	// Height data.
+	float minHeight = std::numeric_limits<float>::max();
+	float maxHeight = std::numeric_limits<float>::lowest();
+	for (int c = 0; c < 4; c++)
+	{
+		auto childNodeIndex = children[c];
+		if (childNodeIndex != Core::c_InvalidIndexU)
 		{
-			std::memcpy(m_Nodes[i].Neighbors, constDataPtr, copySize);
+			auto& childNode = m_Nodes[childNodeIndex];
+			if (childNode.MinHeight < minHeight) minHeight = childNode.MinHeight;
+			if (childNode.MaxHeight > maxHeight) maxHeight = childNode.MaxHeight;
+		}
+	}
+	node.MinHeight = minHeight;
+	node.MaxHeight = maxHeight;
+	ComputeInnerSurfaceHeightBounds(nodeIndex);
+
+	// Connectivity.
+	unsigned c0, c1, c2, c3;
+	auto nodeSize = ::GetNodeSize(node);
+	if (nodeSize.x != nodeSize.y)
+	{
+		if (nodeSize.x > nodeSize.y)
+		{
+			c0 = 0; c1 = 1; c2 = 0; c3 = 1;
+		}
+		else
+		{
+			c0 = 0; c1 = 0; c2 = 1; c3 = 1;
 		}
 	}
 	else
 	{
-		auto GetNodeIndexL = [this, &locationHashToIndexMap](const glm::ivec2& startIndex, const glm::ivec2& nodeSize) {
-			return GetNodeIndex(locationHashToIndexMap, startIndex, nodeSize);
-		};
+		c0 = 0; c1 = 1; c2 = 2; c3 = 3;
+	}
 
-		for (unsigned i = 0; i < countNodes; i++, constDataPtr += copySize)
-		{
-			auto& node = m_Nodes[i];
-			auto start = node.Start;
-			auto nodeSize = ::GetNodeSize(node);
-			node.Neighbors[0] = GetNodeIndexL(start + glm::ivec2(0, -nodeSize.y), nodeSize);
-			node.Neighbors[1] = GetNodeIndexL(start + glm::ivec2(nodeSize.x, -nodeSize.y), nodeSize);
-			node.Neighbors[2] = GetNodeIndexL(start + glm::ivec2(nodeSize.x, 0), nodeSize);
-			node.Neighbors[3] = GetNodeIndexL(start + glm::ivec2(nodeSize.x, nodeSize.y), nodeSize);
-			node.Neighbors[4] = GetNodeIndexL(start + glm::ivec2(0, nodeSize.y), nodeSize);
-			node.Neighbors[5] = GetNodeIndexL(start + glm::ivec2(-nodeSize.x, nodeSize.y), nodeSize);
-			node.Neighbors[6] = GetNodeIndexL(start + glm::ivec2(-nodeSize.x, 0), nodeSize);
-			node.Neighbors[7] = GetNodeIndexL(start + glm::ivec2(-nodeSize.x, -nodeSize.y), nodeSize);
+	auto flags0 = m_Nodes[children[c0]].Flags;
+	auto flags1 = m_Nodes[children[c1]].Flags;
+	auto flags2 = m_Nodes[children[c2]].Flags;
+	auto flags3 = m_Nodes[children[c3]].Flags;
+
+	node.Flags = sideFlag(flags0, West0, NodeFlags::West)
+		| diagonalFlag(flags0, NodeFlags::NorthWest)
+		| sideFlag(flags0, North0, NodeFlags::North)
+		| sideFlag(flags1, North1, NodeFlags::North)
+		| diagonalFlag(flags1, NodeFlags::NorthEast)
+		| sideFlag(flags1, East1, NodeFlags::East)
+		| sideFlag(flags3, East3, NodeFlags::East)
+		| diagonalFlag(flags3, NodeFlags::SouthEast)
+		| sideFlag(flags3, South3, NodeFlags::South)
+		| sideFlag(flags2, South2, NodeFlags::South)
+		| diagonalFlag(flags2, NodeFlags::SouthWest)
+		| sideFlag(flags2, West2, NodeFlags::West);
+}
 
-			std::memcpy(constDataPtr, m_Nodes[i].Neighbors, copySize);
+void TerrainTree::SetLeafSurfaceHeightBounds(unsigned nodeIndex)
+{
+	auto& start = GetNode(nodeIndex).Start;
+	auto& countFields = m_Terrain.GetCountFields();
+	auto& coeffs = m_Terrain.GetSurfaceCoefficients()[start.y * countFields.x + start.x];
+	m_SurfaceHeightBounds[nodeIndex] = Terrain::GetFieldSurfaceHeightMinMax(coeffs);
+}
+
+void TerrainTree::ComputeInnerSurfaceHeightBounds(unsigned nodeIndex)
+{
+	glm::vec2 bounds(std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest());
+	auto& node = GetNode(nodeIndex);
+	for (int c = 0; c < 4; c++)
+	{
+		auto childNodeIndex = node.Children[c];
+		if (childNodeIndex != Core::c_InvalidIndexU)
+		{
+			auto& childBounds = m_SurfaceHeightBounds[childNodeIndex];
+			bounds.x = std::min(bounds.x, childBounds.x);
+			bounds.y = std::max(bounds.y, childBounds.y);
 		}
 	}
+	m_SurfaceHeightBounds[nodeIndex] = bounds;
 }
 
-void TerrainTree::ComputeLeafConnectivity()
+void TerrainTree::ComputeLeafSurfaceHeightBoundsInThread(unsigned threadId, unsigned startTaskIndex,
+	unsigned endTaskIndex)
 {
-	auto fields = m_Terrain.GetFields();
-	auto countFields = m_Terrain.GetCountFields();
-	auto getHeights = [fields, &countFields](const glm::ivec2& fieldIndex) {
-		return Terrain::GetFieldHeights(fields, countFields, fieldIndex.x, fieldIndex.y);
-	};
-	glm::ivec2 lastFieldIndex = glm::ivec2(countFields) - 1;
+	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		SetLeafSurfaceHeightBounds(countInnerNodes + i);
+	}
+}
 
-	auto addFlagToNeighbor = [this](const Node& node, unsigned nIndex, NodeFlags flag) {
-		auto nNodeIndex = node.Neighbors[nIndex];
-		if (nNodeIndex != Core::c_InvalidIndexU) m_Nodes[nNodeIndex].Flags |= flag;
-	};
+void TerrainTree::ComputeInnerSurfaceHeightBoundsInThread(unsigned threadId, unsigned startTaskIndex,
+	unsigned endTaskIndex)
+{
+	auto& level = m_Levels[m_BuildLevelIndex];
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		ComputeInnerSurfaceHeightBounds(level.StartNodeIndex + i);
+	}
+}
+
+void TerrainTree::ComputeSurfaceHeightBounds(Core::ThreadPool* threadPool)
+{
+	m_SurfaceHeightBounds.Clear();
+	m_SurfaceHeightBounds.Resize(m_Nodes.GetSize());
+	if (m_Levels.empty()) return;
 
-	unsigned countNodes = m_Nodes.GetSize();
-	unsigned countInnerNodes = countNodes - m_CountLeafs;
-	for (unsigned i = countInnerNodes; i < countNodes; i++)
+	ExecuteBuildFunction(threadPool, m_CountLeafs, &TerrainTree::ComputeLeafSurfaceHeightBoundsInThread);
+	for (m_BuildLevelIndex = (unsigned)m_Levels.size() - 1; m_BuildLevelIndex-- > 0;)
 	{
-		auto& node = m_Nodes[i];
-		auto fieldIndex = node.Start;
-		auto heights = getHeights(fieldIndex);
+		ExecuteBuildFunction(threadPool, m_Levels[m_BuildLevelIndex].CountNodes,
+			&TerrainTree::ComputeInnerSurfaceHeightBoundsInThread);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TerrainTree::UpdateTerrainHeights(const glm::ivec2& changeStart, const glm::ivec2& changeEnd)
+{
+	if (m_Levels.empty()) return;
 
-		if (fieldIndex.y > 0)
+	auto fields = m_Terrain.GetFields();
+	auto countFields = m_Terrain.GetCountFields();
+
+	// The connectivity of a leaf depends on the heights of its neighbors, while the surface of a field
+	// depends on the heights in the 2-neighborhood.
+	auto lastFieldIndex = glm::ivec2(countFields) - 1;
+	m_UpdateStart = glm::clamp(changeStart - 1, glm::ivec2(0), lastFieldIndex);
+	m_UpdateEnd = glm::clamp(changeEnd + 1, glm::ivec2(0), lastFieldIndex);
+	auto updateSize = m_UpdateEnd - m_UpdateStart + 1;
+	auto heightUpdateStart = glm::clamp(changeStart - 2, glm::ivec2(0), lastFieldIndex);
+	auto heightUpdateEnd = glm::clamp(changeEnd + 2, glm::ivec2(0), lastFieldIndex);
+
+	unsigned leafLevelIndex = (unsigned)m_Levels.size() - 1;
+	for (int z = heightUpdateStart.y; z <= heightUpdateEnd.y; z++)
+	{
+		for (int x = heightUpdateStart.x; x <= heightUpdateEnd.x; x++)
 		{
-			auto neighborHeights = getHeights(fieldIndex + glm::ivec2(0, -1));
-			if (heights[3] == neighborHeights[0] && heights[2] == neighborHeights[1])
-			{
-				node.Flags |= NodeFlags::North;
-				addFlagToNeighbor(node, 0, NodeFlags::South);
-			}
+			SetLeafSurfaceHeightBounds(GetNodeIndex(leafLevelIndex, { x, z }));
 		}
-		if (fieldIndex.x < lastFieldIndex.x && fieldIndex.y > 0)
+	}
+
+	m_PreviousLeafFlags.resize(updateSize.x * updateSize.y);
+	for (int z = m_UpdateStart.y, i = 0; z <= m_UpdateEnd.y; z++)
+	{
+		for (int x = m_UpdateStart.x; x <= m_UpdateEnd.x; x++, i++)
 		{
-			float height = heights[2];
-			auto diagHeights = getHeights(fieldIndex + glm::ivec2(1, -1));
-			auto northHeights = getHeights(fieldIndex + glm::ivec2(0, -1));
-			auto eastHeights = getHeights(fieldIndex + glm::ivec2(1, 0));
-			if (diagHeights[0] == height && northHeights[1] == height && eastHeights[3] == height)
-			{
-				node.Flags |= NodeFlags::NorthEast;
-				addFlagToNeighbor(node, 1, NodeFlags::SouthWest);
-			}
+			glm::ivec2 fieldIndex(x, z);
+			auto& node = m_Nodes[GetNodeIndex(leafLevelIndex, fieldIndex)];
+			auto heightMinMax = Terrain::GetFieldHeightMinMax(fields, countFields, x, z);
+			node.MinHeight = heightMinMax.x;
+			node.MaxHeight = heightMinMax.y;
+			m_PreviousLeafFlags[i] = node.Flags;
+			node.Flags = ComputeLeafFlags(fields, countFields, fieldIndex);
 		}
-		if (fieldIndex.x < lastFieldIndex.x)
+	}
+
+	// Propagating the height and connectivity data to the ancestors level by level.
+	for (unsigned levelIndex = leafLevelIndex; levelIndex-- > 0;)
+	{
+		auto nodeSize = m_Levels[levelIndex].NodeSize;
+		auto start = (heightUpdateStart / nodeSize) * nodeSize;
+		for (int z = start.y; z <= heightUpdateEnd.y; z += nodeSize.y)
 		{
-			auto neighborHeights = getHeights(fieldIndex + glm::ivec2(1, 0));
-			if (heights[1] == neighborHeights[0] && heights[2] == neighborHeights[3])
+			for (int x = start.x; x <= heightUpdateEnd.x; x += nodeSize.x)
 			{
-				node.Flags |= NodeFlags::East;
-				addFlagToNeighbor(node, 2, NodeFlags::West);
+				ComputeInnerNodeData(GetNodeIndex(levelIndex, { x, z }));
 			}
 		}
-		if (fieldIndex.x < lastFieldIndex.x && fieldIndex.y < lastFieldIndex.y)
+	}
+
+	UpdateIslands();
+	UpdateChangeStamp();
+}
+
+void TerrainTree::UpdateChangeStamp()
+{
+	static std::atomic<uint64_t> s_LastChangeStamp(0);
+	m_ChangeStamp = ++s_LastChangeStamp;
+}
+
+uint64_t TerrainTree::GetChangeStamp() const
+{
+	return m_ChangeStamp;
+}
+
+bool TerrainTree::IsInUpdateRegion(const glm::ivec2& fieldIndex) const
+{
+	return fieldIndex.x >= m_UpdateStart.x && fieldIndex.x <= m_UpdateEnd.x
+		&& fieldIndex.y >= m_UpdateStart.y && fieldIndex.y <= m_UpdateEnd.y;
+}
+
+bool TerrainTree::HadConnection(const glm::ivec2& fieldIndex, unsigned direction) const
+{
+	assert(IsInUpdateRegion(fieldIndex));
+	auto offset = fieldIndex - m_UpdateStart;
+	int updateWidth = m_UpdateEnd.x - m_UpdateStart.x + 1;
+	return HasDirection(m_PreviousLeafFlags[offset.y * updateWidth + offset.x], direction);
+}
+
+bool TerrainTree::HasKeptConnection(unsigned nodeIndex, unsigned direction) const
+{
+	auto& node = m_Nodes[nodeIndex];
+	if (!HasDirection(node.Flags, direction)) return false;
+
+	// Only the connections between the leafs of the update region can change: the connections that cross
+	// its border only depend on unchanged fields.
+	auto& fieldIndex = node.Start;
+	auto neighborFieldIndex = fieldIndex + c_DirectionOffsets[direction];
+	if (!IsInUpdateRegion(fieldIndex) || !IsInUpdateRegion(neighborFieldIndex)) return true;
+	return HadConnection(fieldIndex, direction);
+}
+
+void TerrainTree::InitializeIslandUpdate()
+{
+	if (m_IslandSearchMarks.GetSize() == m_CountLeafs) return;
+
+	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
+	m_IslandSizes.Clear();
+	m_FreeIslandIndices.Clear();
+	for (unsigned i = 0; i < m_CountLeafs; i++)
+	{
+		unsigned islandIndex = m_IslandIndices[countInnerNodes + i];
+		if (islandIndex >= m_IslandSizes.GetSize())
 		{
-			auto height = heights[1];
-			auto diagHeights = getHeights(fieldIndex + glm::ivec2(1, 1));
-			auto southHeights = getHeights(fieldIndex + glm::ivec2(0, 1));
-			auto eastHeights = getHeights(fieldIndex + glm::ivec2(1, 0));
-			if (diagHeights[3] == height && southHeights[2] == height && eastHeights[0] == height)
-			{
-				node.Flags |= NodeFlags::SouthEast;
-				addFlagToNeighbor(node, 3, NodeFlags::NorthWest);
-			}
+			m_IslandSizes.PushBack(0, islandIndex + 1 - m_IslandSizes.GetSize());
 		}
+		m_IslandSizes[islandIndex]++;
 	}
+	for (unsigned i = 0; i < m_IslandSizes.GetSize(); i++)
+	{
+		if (m_IslandSizes[i] == 0) m_FreeIslandIndices.PushBack(i);
+	}
+
+	m_IslandSearchMarks.Clear();
+	m_IslandSearchMarks.PushBack(0, m_CountLeafs);
+	m_IslandSearchStamp = 0;
 }
 
-void TerrainTree::InitializeIslandIndices()
+unsigned TerrainTree::CreateIslandIndex()
 {
-	m_IslandIndices.Clear();
-	m_IslandIndices.PushBack(Core::c_InvalidIndexU, m_Nodes.GetSize());
+	if (m_FreeIslandIndices.GetSize() > 0)
+	{
+		unsigned islandIndex = m_FreeIslandIndices.GetLastElement();
+		m_FreeIslandIndices.PopBack();
+		return islandIndex;
+	}
+	m_IslandSizes.PushBack(0);
+	return m_IslandSizes.GetSize() - 1;
 }
 
-void TerrainTree::ComputeLeafIslands()
+void TerrainTree::RelabelIsland(const Core::IndexVectorU& nodeIndices, unsigned islandIndex)
 {
-	unsigned islandIndex = 0;
+	unsigned countNodes = nodeIndices.GetSize();
+	unsigned previousIslandIndex = m_IslandIndices[nodeIndices[0]];
+	for (unsigned i = 0; i < countNodes; i++)
+	{
+		assert(m_IslandIndices[nodeIndices[i]] == previousIslandIndex);
+		m_IslandIndices[nodeIndices[i]] = islandIndex;
+	}
+
+	assert(m_IslandSizes[previousIslandIndex] >= countNodes);
+	m_IslandSizes[islandIndex] += countNodes;
+	m_IslandSizes[previousIslandIndex] -= countNodes;
+	if (m_IslandSizes[previousIslandIndex] == 0) m_FreeIslandIndices.PushBack(previousIslandIndex);
+}
 
-	unsigned countNodes = m_Nodes.GetSize();
-	unsigned countInnerNodes = countNodes - m_CountLeafs;
-	for (unsigned startNodeIndex = countInnerNodes; startNodeIndex < countNodes; startNodeIndex++)
+bool TerrainTree::SeparateIslands(unsigned nodeIndex0, unsigned nodeIndex1)
+{
+	// The two nodes are searched alternately on the kept connections. If the searches meet, the nodes are still
+	// connected. Otherwise the search that runs out of nodes first has found a complete island, which gets a new
+	// index. This way the cost is proportional to the smaller island, not to the one that is split.
+
+	if (m_IslandSearchStamp >= std::numeric_limits<unsigned>::max() - 2)
 	{
-		if (m_IslandIndices[startNodeIndex] == Core::c_InvalidIndexU)
-		{
-			m_IslandIndices[startNodeIndex] = islandIndex;
+		std::fill(m_IslandSearchMarks.GetArray(), m_IslandSearchMarks.GetEndPointer(), 0);
+		m_IslandSearchStamp = 0;
+	}
+	m_IslandSearchStamp += 2;
+	const unsigned stamps[2] = { m_IslandSearchStamp - 1, m_IslandSearchStamp };
 
-			assert(m_NodeIndexQueue.empty());
-			m_NodeIndexQueue.push_back(startNodeIndex);
+	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
+	const unsigned startNodeIndices[2] = { nodeIndex0, nodeIndex1 };
+	unsigned nextIndices[2] = { 0, 0 };
+	for (unsigned s = 0; s < 2; s++)
+	{
+		m_IslandSearchNodeIndices[s].Clear();
+		m_IslandSearchNodeIndices[s].PushBack(startNodeIndices[s]);
+		m_IslandSearchMarks[startNodeIndices[s] - countInnerNodes] = stamps[s];
+	}
 
-			while (!m_NodeIndexQueue.empty())
+	while (true)
+	{
+		for (unsigned s = 0; s < 2; s++)
+		{
+			// The visited nodes are also the queue of the search.
+			auto& nodeIndices = m_IslandSearchNodeIndices[s];
+			if (nextIndices[s] == nodeIndices.GetSize())
 			{
-				unsigned nodeIndex = m_NodeIndexQueue.front();
-				m_NodeIndexQueue.pop_front();
+				RelabelIsland(nodeIndices, CreateIslandIndex());
+				return true;
+			}
 
-				auto& nodeData = m_Nodes[nodeIndex];
-				auto nodeFlags = nodeData.Flags;
-				const unsigned* neighbours = nodeData.Neighbors;
+			unsigned nodeIndex = nodeIndices[nextIndices[s]++];
+			for (unsigned d = 0; d < 8; d++)
+			{
+				if (!HasKeptConnection(nodeIndex, d)) continue;
 
-				for (unsigned d = 0; d < 8; d++)
+				unsigned neighborNodeIndex = m_Nodes[nodeIndex].Neighbors[d];
+				auto& mark = m_IslandSearchMarks[neighborNodeIndex - countInnerNodes];
+				if (mark == stamps[1 - s]) return false;
+				if (mark != stamps[s])
 				{
-					if (HasDirection(nodeFlags, d))
-					{
-						unsigned neighborNodeIndex = neighbours[d];
-						if (m_IslandIndices[neighborNodeIndex] == Core::c_InvalidIndexU)
-						{
-							m_IslandIndices[neighborNodeIndex] = islandIndex;
-							m_NodeIndexQueue.push_back(neighborNodeIndex);
-						}
-					}
+					mark = stamps[s];
+					nodeIndices.PushBack(neighborNodeIndex);
 				}
 			}
-
-			islandIndex++;
 		}
 	}
 }
 
-void TerrainTree::ComputeInnerNodeData()
+void TerrainTree::MergeIslands(unsigned nodeIndex0, unsigned nodeIndex1)
 {
-	constexpr NodeFlags West0 = NodeFlags::West | NodeFlags::SouthWest;
-	constexpr NodeFlags North0 = NodeFlags::North | NodeFlags::NorthEast;
-	constexpr NodeFlags North1 = NodeFlags::North | NodeFlags::NorthWest;
-	constexpr NodeFlags East1 = NodeFlags::East | NodeFlags::SouthEast;
-	constexpr NodeFlags East3 = NodeFlags::East | NodeFlags::NorthEast;
-	constexpr NodeFlags South3 = NodeFlags::South | NodeFlags::SouthWest;
-	constexpr NodeFlags South2 = NodeFlags::South | NodeFlags::SouthEast;
-	constexpr NodeFlags West2 = NodeFlags::West | NodeFlags::NorthWest;
+	unsigned islandIndex0 = m_IslandIndices[nodeIndex0];
+	unsigned islandIndex1 = m_IslandIndices[nodeIndex1];
+	if (islandIndex0 == islandIndex1) return;
 
-	auto diagonalFlag = [](NodeFlags flags, NodeFlags target) {
-		return flags & target;
-	};
-	auto sideFlag = [](NodeFlags flags, NodeFlags mask, NodeFlags target) { 
-		return ((bool)(flags & mask) ? target : NodeFlags::None);
-	};
-
-	unsigned countInnerNodes = m_Nodes.GetSize() - m_CountLeafs;
-	for (int i = countInnerNodes - 1; i >= 0; i--)
+	// The smaller island is relabeled.
+	if (m_IslandSizes[islandIndex0] < m_IslandSizes[islandIndex1])
 	{
-		auto& node = m_Nodes[i];
-		auto children = (const unsigned*)node.Children;
+		std::swap(nodeIndex0, nodeIndex1);
+		std::swap(islandIndex0, islandIndex1);
+	}
 
-		// Height data.
-		float minHeight = std::numeric_limits<float>::max();
-		float maxHeight = std::numeric_limits<float>::lowest();
-		for (int c = 0; c < 4; c++)
+	auto& nodeIndices = m_IslandSearchNodeIndices[0];
+	nodeIndices.Clear();
+	nodeIndices.PushBack(nodeIndex1);
+	m_IslandIndices[nodeIndex1] = islandIndex0;
+	for (unsigned i = 0; i < nodeIndices.GetSize(); i++)
+	{
+		auto& node = m_Nodes[nodeIndices[i]];
+		for (unsigned d = 0; d < 8; d++)
 		{
-			auto childNodeIndex = children[c];
-			if (childNodeIndex != Core::c_InvalidIndexU)
+			if (!HasDirection(node.Flags, d)) continue;
+
+			unsigned neighborNodeIndex = node.Neighbors[d];
+			if (m_IslandIndices[neighborNodeIndex] == islandIndex1)
 			{
-				auto& childNode = m_Nodes[childNodeIndex];
-				if (childNode.MinHeight < minHeight) minHeight = childNode.MinHeight;
-				if (childNode.MaxHeight > maxHeight) maxHeight = childNode.MaxHeight;
+				m_IslandIndices[neighborNodeIndex] = islandIndex0;
+				nodeIndices.PushBack(neighborNodeIndex);
 			}
 		}
-		node.MinHeight = minHeight;
-		node.MaxHeight = maxHeight;
+	}
 
-		// Connectivity.
-		unsigned c0, c1, c2, c3;
-		auto nodeSize = ::GetNodeSize(node);
-		if (nodeSize.x != nodeSize.y)
+	assert(nodeIndices.GetSize() == m_IslandSizes[islandIndex1]);
+	m_IslandSizes[islandIndex0] += m_IslandSizes[islandIndex1];
+	m_IslandSizes[islandIndex1] = 0;
+	m_FreeIslandIndices.PushBack(islandIndex1);
+}
+
+void TerrainTree::UpdateIslands()
+{
+	InitializeIslandUpdate();
+
+	// The removed connections are processed first on the graph of the kept connections. An endpoint of a removed
+	// connection is compared with the representative of its island: if they are separated, both become the
+	// representatives of their islands. After that each island of the kept connections has a unique index.
+	// Then the added connections merge the islands.
+
+	unsigned leafLevelIndex = (unsigned)m_Levels.size() - 1;
+	std::unordered_map<unsigned, unsigned> representatives;
+	auto separateFromRepresentative = [this, &representatives](unsigned nodeIndex) {
+		auto it = representatives.find(m_IslandIndices[nodeIndex]);
+		if (it == representatives.end())
 		{
-			if (nodeSize.x > nodeSize.y)
-			{
-				c0 = 0; c1 = 1; c2 = 0; c3 = 1;
-			}
-			else
+			representatives[m_IslandIndices[nodeIndex]] = nodeIndex;
+		}
+		else if (it->second != nodeIndex)
+		{
+			unsigned representativeNodeIndex = it->second;
+			if (SeparateIslands(representativeNodeIndex, nodeIndex))
 			{
-				c0 = 0; c1 = 0; c2 = 1; c3 = 1;
+				representatives[m_IslandIndices[representativeNodeIndex]] = representativeNodeIndex;
+				representatives[m_IslandIndices[nodeIndex]] = nodeIndex;
 			}
 		}
-		else
+	};
+
+	// The connectivity is symmetric, so it's enough to check the half of the directions.
+	for (unsigned pass = 0; pass < 2; pass++)
+	{
+		bool isProcessingRemovals = (pass == 0);
+		for (int z = m_UpdateStart.y; z <= m_UpdateEnd.y; z++)
 		{
-			c0 = 0; c1 = 1; c2 = 2; c3 = 3;
-		}
+			for (int x = m_UpdateStart.x; x <= m_UpdateEnd.x; x++)
+			{
+				glm::ivec2 fieldIndex(x, z);
+				unsigned nodeIndex = GetNodeIndex(leafLevelIndex, fieldIndex);
+				auto flags = m_Nodes[nodeIndex].Flags;
+				for (unsigned d = 0; d < 4; d++)
+				{
+					if (!IsInUpdateRegion(fieldIndex + c_DirectionOffsets[d])) continue;
 
-		auto flags0 = m_Nodes[children[c0]].Flags;
-		auto flags1 = m_Nodes[children[c1]].Flags;
-		auto flags2 = m_Nodes[children[c2]].Flags;
-		auto flags3 = m_Nodes[children[c3]].Flags;
+					bool hadConnection = HadConnection(fieldIndex, d);
+					bool hasConnection = HasDirection(flags, d);
+					if (hadConnection == hasConnection || hadConnection != isProcessingRemovals) continue;
 
-		node.Flags |= sideFlag(flags0, West0, NodeFlags::West)
-			| diagonalFlag(flags0, NodeFlags::NorthWest)
-			| sideFlag(flags0, North0, NodeFlags::North)
-			| sideFlag(flags1, North1, NodeFlags::North)
-			| diagonalFlag(flags1, NodeFlags::NorthEast)
-			| sideFlag(flags1, East1, NodeFlags::East)
-			| sideFlag(flags3, East3, NodeFlags::East)
-			| diagonalFlag(flags3, NodeFlags::SouthEast)
-			| sideFlag(flags3, South3, NodeFlags::South)
-			| sideFlag(flags2, South2, NodeFlags::South)
-			| diagonalFlag(flags2, NodeFlags::SouthWest)
-			| sideFlag(flags2, West2, NodeFlags::West);
+					unsigned neighborNodeIndex = m_Nodes[nodeIndex].Neighbors[d];
+					if (isProcessingRemovals)
+					{
+						separateFromRepresentative(nodeIndex);
+						separateFromRepresentative(neighborNodeIndex);
+					}
+					else
+					{
+						MergeIslands(nodeIndex, neighborNodeIndex);
+					}
+				}
+			}
+		}
 	}
 }
 
@@ -713,6 +1158,238 @@ void TerrainTree::CullInThread(unsigned threadId, unsigned startTaskIndex, unsig
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+constexpr unsigned c_RayTaskPackageSize = 16;
+
+struct RayIntersectionConstants
+{
+	glm::vec3 RayOrigin;
+	glm::vec3 RayDir;
+	glm::uvec2 CountFields;
+	const glm::mat4* SurfaceCoeffs;
+	const glm::vec2* SurfaceHeightBounds;
+};
+
+inline float GetNodeMaxPlaneIntersection(const TerrainTree::Node& node, unsigned nodeIndex,
+	const RayIntersectionConstants& rc)
+{
+	return GetRayAABBIntersection_PositiveT(
+		glm::vec3(node.Start.x, std::numeric_limits<float>::lowest(), node.Start.y),
+		glm::vec3((node.End.x + 1), rc.SurfaceHeightBounds[nodeIndex].y, (node.End.y + 1)),
+		rc.RayOrigin, rc.RayDir);
+}
+
+inline void CheckRayIntersectionBounds(const RayIntersectionConstants& rc, float* pT)
+{
+	auto fMin = std::numeric_limits<float>::lowest();
+	auto fMax = std::numeric_limits<float>::max();
+
+	auto xEnd = rc.CountFields.x;
+	auto zEnd = rc.CountFields.y;
+
+	auto t = *pT;
+	t = std::min(t, GetRayAABBIntersection_PositiveT(glm::vec3(fMin, fMin, fMin), glm::vec3(fMax, 0.0f, 0.0f), rc.RayOrigin, rc.RayDir));
+	t = std::min(t, GetRayAABBIntersection_PositiveT(glm::vec3(fMin, fMin, zEnd), glm::vec3(fMax, 0.0f, fMax), rc.RayOrigin, rc.RayDir));
+	t = std::min(t, GetRayAABBIntersection_PositiveT(glm::vec3(fMin, fMin, fMin), glm::vec3(0.0f, 0.0f, fMax), rc.RayOrigin, rc.RayDir));
+	t = std::min(t, GetRayAABBIntersection_PositiveT(glm::vec3(xEnd, fMin, fMin), glm::vec3(fMax, 0.0f, fMax), rc.RayOrigin, rc.RayDir));
+	*pT = t;
+}
+
+inline bool IsIntersectionConsistenWithField(const glm::ivec2& start, const glm::ivec2& end, const RayIntersectionConstants& rc, float t)
+{
+	auto x = rc.RayOrigin + rc.RayDir * t;
+	return (x.x >= start.x && x.x < (end.x + 1)
+		&& x.z >= start.y && x.z < (end.y + 1));
+}
+
+inline bool IsIntersectionConsistenWithFieldEdgeAllowed(const glm::ivec2& start, const glm::ivec2& end, const RayIntersectionConstants& rc, float t)
+{
+	auto x = rc.RayOrigin + rc.RayDir * t;
+	return (x.x >= start.x && x.x <= (end.x + 1)
+		&& x.z >= start.y && x.z <= (end.y + 1));
+}
+
+inline void AdjustIntersectionToField(const glm::ivec2& start, const glm::ivec2& end, const RayIntersectionConstants& rc, float* pT)
+{
+	// This simple algorithm ensures, that the computed world intersection is consistent with the field.
+	// Therefore we have to compute it using the ray origin, direction and parameter t.
+	float t = *pT;
+	if (IsIntersectionConsistenWithField(start, end, rc, t)) return;
+	float xzSize = glm::length(glm::vec2(rc.RayDir.x, rc.RayDir.z));
+	if (xzSize < 1e-5f) return;
+	float stepBase = 1.0f / xzSize;
+	float step = stepBase * 1e-6f;
+	float stepLimit = stepBase * 1e-3f;
+	for (; step <= stepLimit; step *= 1.5f)
+	{
+		float t0 = t - step;
+		float t1 = t + step;
+		if (IsIntersectionConsistenWithField(start, end, rc, t0)) { *pT = t0; return; }
+		if (IsIntersectionConsistenWithField(start, end, rc, t1)) { *pT = t1; return; }
+	}
+
+	// We must have intersected exactly the edge. This is fine, because the intersection search only returns the
+	// parameter t.
+	assert(IsIntersectionConsistenWithFieldEdgeAllowed(start, end, rc, t));
+}
+
+inline bool IsRayGoingUnderSurface(const glm::mat4& coeffs, const glm::vec3& rayOriginL, const glm::vec3& rayDirL, const IntervalF& t)
+{
+	auto x = rayOriginL.x + rayDirL.x * t;
+	auto y = rayOriginL.y + rayDirL.y * t;
+	auto z = rayOriginL.z + rayDirL.z * t;
+	auto x2 = x * x;
+	auto x3 = x * x2;
+	auto z2 = z * z;
+	auto z3 = z * z2;
+	auto value = y
+		- (coeffs[0][0] + coeffs[0][1] * x + coeffs[0][2] * x2 + coeffs[0][3] * x3)
+		- (coeffs[1][0] + coeffs[1][1] * x + coeffs[1][2] * x2 + coeffs[1][3] * x3) * z
+		- (coeffs[2][0] + coeffs[2][1] * x + coeffs[2][2] * x2 + coeffs[2][3] * x3) * z2
+		- (coeffs[3][0] + coeffs[3][1] * x + coeffs[3][2] * x2 + coeffs[3][3] * x3) * z3;
+	return (value.Min <= 0.0f);
+}
+
+inline float GetFieldIntersectionY(const glm::mat4& coeffs, const glm::vec3& rayOriginL, const glm::vec3& rayDirL, const IntervalF& t)
+{
+	assert(t.Max >= t.Min);
+	if (!IsRayGoingUnderSurface(coeffs, rayOriginL, rayDirL, t)) return c_InvalidIntersectionT;
+	if (t.Max - t.Min <= 1e-5f) return t.GetMiddle();
+
+	IntervalF first, second;
+	t.Split(&first, &second);
+	if(first.IsLengthZero() || second.IsLengthZero()) return t.GetMiddle();
+
+	auto res0 = GetFieldIntersectionY(coeffs, rayOriginL, rayDirL, first);
+	if (res0 != c_InvalidIntersectionT) return res0;
+	return GetFieldIntersectionY(coeffs, rayOriginL, rayDirL, second);
+}
+
+inline float GetFieldIntersection(const glm::ivec2& start, const glm::mat4& coeffs, const RayIntersectionConstants& rc)
+{
+	auto rayOriginL = rc.RayOrigin - glm::vec3(start.x, 0.0f, start.y);
+	auto rayDirL = glm::normalize(rc.RayDir);
+
+	// Intersecting with field X-Z interval.
+	IntervalF t;
+	GetRayAABBIntersection(
+		glm::vec3(0.0f, c_FloatMin, 0.0f),
+		glm::vec3(1.0f, c_FloatMax, 1.0f),
+		rayOriginL, rayDirL, &t.Min, &t.Max);
+	if (t.Min == c_InvalidIntersectionT || t.Max < 0.0f) return c_InvalidIntersectionT;
+	t.Min = std::max(t.Min, 0.0f);
+
+	// Calling recursive Y-intersection method.
+	auto tLocal = GetFieldIntersectionY(coeffs, rayOriginL, rayDirL, t);
+	if (tLocal == c_InvalidIntersectionT) return c_InvalidIntersectionT;
+	assert(tLocal >= 0.0f);
+	return tLocal / glm::length(rc.RayDir);
+}
+
+inline float IntersectRayInnerTerrain(const TerrainTree::Node* nodes, const RayIntersectionConstants& rc)
+{
+	// Depth-first traversal, where the children are visited in the order of their entry points. Since the X-Z
+	// footprints of the children are disjoint, the first intersected leaf contains the nearest intersection.
+	constexpr unsigned c_MaxStackSize = 256;
+	unsigned stack[c_MaxStackSize];
+	unsigned stackSize = 0;
+	if (GetNodeMaxPlaneIntersection(nodes[0], 0, rc) != c_InvalidIntersectionT) stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		auto nodeIndex = stack[--stackSize];
+		auto& node = nodes[nodeIndex];
+		auto& surfaceHeightBounds = rc.SurfaceHeightBounds[nodeIndex];
+		if (node.Children[0] == Core::c_InvalidIndexU)
+		{
+			auto& coeffs = rc.SurfaceCoeffs[node.Start.y * rc.CountFields.x + node.Start.x];
+			auto t = GetFieldIntersection(node.Start, coeffs, rc);
+			if (t != c_InvalidIntersectionT)
+			{
+				AdjustIntersectionToField(node.Start, node.End, rc, &t);
+				return t;
+			}
+		}
+		else if (surfaceHeightBounds.x == surfaceHeightBounds.y)
+		{
+			// The surface is flat in the whole node.
+			auto t = GetNodeMaxPlaneIntersection(node, nodeIndex, rc);
+			assert(t != c_InvalidIntersectionT);
+			AdjustIntersectionToField(node.Start, node.End, rc, &t);
+			return t;
+		}
+		else
+		{
+			// Pushing the intersected children in the reverse order of their entry points.
+			struct TSort {
+				float T; unsigned Index; bool operator<(const TSort& o) const {
+					if (T != o.T) { return T > o.T; } return (Index > o.Index);
+				}
+			};
+			TSort ts[4];
+			unsigned countIntersectedChildren = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				auto childNodeIndex = node.Children[c];
+				if (childNodeIndex == Core::c_InvalidIndexU) continue;
+				auto t = GetNodeMaxPlaneIntersection(nodes[childNodeIndex], childNodeIndex, rc);
+				if (t != c_InvalidIntersectionT) ts[countIntersectedChildren++] = { t, childNodeIndex };
+			}
+			std::sort(ts, ts + countIntersectedChildren);
+
+			assert(stackSize + countIntersectedChildren <= c_MaxStackSize);
+			for (unsigned i = 0; i < countIntersectedChildren; i++)
+			{
+				stack[stackSize++] = ts[i].Index;
+			}
+		}
+	}
+
+	return c_InvalidIntersectionT;
+}
+
+float TerrainTree::IntersectRay(const glm::vec3& rayOrigin, const glm::vec3& rayDir) const
+{
+	RayIntersectionConstants rc{ rayOrigin, rayDir, m_Terrain.GetCountFields(),
+		m_Terrain.GetSurfaceCoefficients().GetArray(), m_SurfaceHeightBounds.GetArray() };
+	auto t = (m_Nodes.GetSize() > 0 ? IntersectRayInnerTerrain(m_Nodes.GetArray(), rc) : c_InvalidIntersectionT);
+	CheckRayIntersectionBounds(rc, &t);
+	return t;
+}
+
+float TerrainTree::IntersectSegment(const glm::vec3& start, const glm::vec3& end) const
+{
+	auto t = IntersectRay(start, end - start);
+	return (t <= 1.0f ? t : c_InvalidIntersectionT);
+}
+
+void TerrainTree::IntersectRays(Core::ThreadPool& threadPool, const glm::vec3* rayOrigins, const glm::vec3* rayDirs,
+	unsigned countRays, float* ts) const
+{
+	m_RayOrigins = rayOrigins;
+	m_RayDirs = rayDirs;
+	m_RayTs = ts;
+
+	if (countRays < c_RayTaskPackageSize)
+	{
+		IntersectRaysInThread(0, 0, countRays);
+	}
+	else
+	{
+		threadPool.ExecuteWithDynamicScheduling(countRays, &TerrainTree::IntersectRaysInThread, this,
+			c_RayTaskPackageSize);
+	}
+}
+
+void TerrainTree::IntersectRaysInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex) const
+{
+	for (unsigned i = startTaskIndex; i < endTaskIndex; i++)
+	{
+		m_RayTs[i] = IntersectRay(m_RayOrigins[i], m_RayDirs[i]);
+	}
+}
+
 unsigned& TerrainTree::GetNodeIndexForFieldRef(const glm::ivec2& fieldIndex)
 {
 	auto& countFields = m_Terrain.GetCountFields();
@@ -779,26 +1456,6 @@ void TerrainTree::GetNodeIndices(const glm::ivec2& startIndex, const glm::ivec2&
 	}
 }
 
-uint64_t TerrainTree::GetNodeLocationHash(const glm::ivec2& startIndex, const glm::ivec2& size)
-{
-	auto pack = [](int value, unsigned _2_byteIndex) {
-		return (uint64_t)((unsigned)value & 0xffff) << (uint64_t)(_2_byteIndex << 4);
-	};
-	return pack(startIndex.x, 0) | pack(startIndex.y, 1) | pack(size.x, 2) | pack(size.y, 3);
-}
-
-unsigned TerrainTree::GetNodeIndex(const LocationHashToIndexMap& locationHashToIndexMap,
-	const glm::ivec2& startIndex, const glm::ivec2& size) const
-{
-	auto countFields = m_Terrain.GetCountFields();
-	auto lastIndex = startIndex + size - 1;
-	if (!isValidField(startIndex, countFields) || !isValidField(lastIndex, countFields)) return Core::c_InvalidIndexU;
-
-	uint64_t hash = GetNodeLocationHash(startIndex, size);
-	auto it = locationHashToIndexMap.find(hash);
-	return it == locationHashToIndexMap.end() ? Core::c_InvalidIndexU : it->second;
-}
-
 void TerrainTree::Node::SerializeSB(Core::ByteVector& bytes) const
 {
 	Core::SerializeSB(bytes, Parent);
@@ -829,12 +1486,37 @@ void TerrainTree::SerializeSB(Core::ByteVector& bytes) const
 	Core::SerializeSB(bytes, m_IslandIndices);
 	Core::SerializeSB(bytes, m_CountLeafs);
 	Core::SerializeSB(bytes, m_TerrainFieldToNodeIndex);
+	Core::SerializeSB(bytes, m_SurfaceHeightBounds);
+}
+
+void TerrainTree::DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source,
+	bool hasSurfaceHeightBounds)
+{
+	m_Nodes.DeserializeSB(bytes, source);
+	m_IslandIndices.DeserializeSB(bytes, source);
+	Core::DeserializeSB(bytes, m_CountLeafs);
+	m_TerrainFieldToNodeIndex.DeserializeSB(bytes, source);
+	if (hasSurfaceHeightBounds) m_SurfaceHeightBounds.DeserializeSB(bytes, source);
+
+	InitializeLevels();
+	UpdateChangeStamp();
 }
 
-void TerrainTree::DeserializeSB(const unsigned char*& bytes)
+void TerrainTree::DeserializeLegacySB(const unsigned char*& bytes)
 {
-	Core::DeserializeSB(bytes, m_Nodes);
-	Core::DeserializeSB(bytes, m_IslandIndices);
+	m_Nodes.DeserializeLegacySB(bytes);
+	m_IslandIndices.DeserializeLegacySB(bytes);
 	Core::DeserializeSB(bytes, m_CountLeafs);
-	Core::DeserializeSB(bytes, m_TerrainFieldToNodeIndex);
+	m_TerrainFieldToNodeIndex.DeserializeLegacySB(bytes);
+
+	InitializeLevels();
+	UpdateChangeStamp();
+}
+
+void TerrainTree::CopyMappedData()
+{
+	m_Nodes.CopyMappedData();
+	m_IslandIndices.CopyMappedData();
+	m_TerrainFieldToNodeIndex.CopyMappedData();
+	m_SurfaceHeightBounds.CopyMappedData();
 }
\ No newline at end of file
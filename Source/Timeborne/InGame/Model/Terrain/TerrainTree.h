@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <Timeborne/DataStructures/MappableVector.h>
 #include <Timeborne/Declarations/CoreDeclarations.h>
 #include <Timeborne/Declarations/EngineBuildingBlocksDeclarations.h>
 
@@ -9,13 +10,10 @@
 #include <Core/Platform.h>
 #include <EngineBuildingBlocks/Math/AABoundingBox.h>
 
+#include <atomic>
 #include <cstdint>
-#include <queue>
-#include <unordered_map>
-
-// Required for accessing the path handler to use cached computation data:
-// the neighbor indices.
-class MainApplication;
+#include <deque>
+#include <vector>
 
 class Terrain;
 
@@ -25,24 +23,13 @@ class TerrainTree
 {
 public:
 
-	// We start to use this class in the level editor as well. The following
-	// data members are NOT updated:
-	//
-	// - Height data: Node.MinHeight, Node.MaxHeight
-	// - Connectivity data: Node.Flags
-	// - Island index
-	//
-	// The first two could be updated, which would make the most sense
-	// if the ray intersection would be reimplemented here and
-	// 'FieldHeightQuadTree' would be deleted.
+	// In the level editor the tree is kept up to date with the terrain: after a height change
+	// 'UpdateTerrainHeights' recomputes the leafs in the dirty rectangle, propagates the height and
+	// connectivity data to the ancestors and repairs the island indices locally. Island indices
+	// that are maintained this way are not contiguous, they are only comparable for equality.
 	//
-	// @todo: reimplement the ray intersection with this class. This must be
-	// done BEFORE implementing functionality in the level editor that
-	// accesses the heights.
-	//
-	// The island indices are only used by the path finding, and it would
-	// be inefficient to always recompute them, since a small local change
-	// would lead to complete great changes in the island indices.
+	// The node heights bound the corner heights of the fields, which the path finding heights are derived from.
+	// The ray intersection uses the separate surface height bounds.
 
 	enum class NodeFlags : unsigned
 	{
@@ -96,19 +83,6 @@ public:
 		void DeserializeSB(const unsigned char*& bytes);
 	};
 
-private: // Constant data.
-
-	struct ConstantData
-	{
-		Core::IndexVectorU NeighborIndices;
-
-		void SerializeSB(Core::ByteVector& bytes) const;
-		void DeserializeSB(const unsigned char*& bytes);
-	};
-
-	static void LoadConstantData(ConstantData& constantData, const std::string& filePath);
-	static void SaveConstantData(const ConstantData& constantData, const std::string& filePath);
-
 private:
 	const Terrain& m_Terrain;
 
@@ -130,44 +104,107 @@ private:
 	// After the sizes along X and Z are the same 2-power, the usual quadtree subdivision
 	// is executed.
 	//
-	Core::SimpleTypeVectorU<Node> m_Nodes;
+	MappableVector<Node> m_Nodes;
 
 	// Islands are connected components. SoA with 'm_Nodes'.
 	// For inner nodes only set if all indices equal.
-	Core::IndexVectorU m_IslandIndices;
+	MappableVector<unsigned> m_IslandIndices;
+
+	// The height bounds of the bicubic terrain surface, which are used for the ray intersection. SoA with 'm_Nodes'.
+	MappableVector<glm::vec2> m_SurfaceHeightBounds;
 
 	unsigned m_CountLeafs;
 
-	Core::IndexVectorU m_TerrainFieldToNodeIndex;
+	// Set whenever the tree is built, deserialized or updated.
+	uint64_t m_ChangeStamp;
+	void UpdateChangeStamp();
+
+	MappableVector<unsigned> m_TerrainFieldToNodeIndex;
 
 	mutable std::deque<unsigned> m_NodeIndexQueue; // Temp for multiple functions.
 
-	using LocationHashToIndexMap = std::unordered_map<uint64_t, unsigned>;
+	unsigned& GetNodeIndexForFieldRef(const glm::ivec2& fieldIndex);
+
+private: // Implicit indexing.
+
+	// The nodes of a level have the same size. Since the children of a node are stored continuously in the next
+	// level, the index of a node in its level is the interleaving of the bits of its position: the child indices
+	// along the path from the root. The leaf offsets store these bits for the field coordinates, and the offset
+	// of a node is the leaf offset of its start field shifted by the level's shift.
+	struct LevelData
+	{
+		unsigned StartNodeIndex;
+		unsigned CountNodes;
+		unsigned CountChildren;
+		unsigned OffsetShift;
+		glm::ivec2 NodeSize;
+	};
+
+	std::vector<LevelData> m_Levels;
+	Core::IndexVectorU m_LeafOffsetsX, m_LeafOffsetsZ;
+
+	void InitializeLevels();
 
-	void BuildTree(const MainApplication* application);
-	void CreateNodes(bool constantDataExists, LocationHashToIndexMap& locationHashToIndexMap);
-	void ComputeNeighbors(bool constantDataExists, const LocationHashToIndexMap& locationHashToIndexMap,
-		ConstantData& constantData);
-	void ComputeLeafConnectivity();
-	void ComputeInnerNodeData();
+	// Returns an invalid index if the start field is outside of the terrain.
+	unsigned GetNodeIndex(unsigned levelIndex, const glm::ivec2& startFieldIndex) const;
+
+private: // Building.
+
+	unsigned m_BuildLevelIndex = 0;
+	std::vector<std::atomic<unsigned>> m_IslandParents; // Union-find over the leafs.
+
+	using BuildFunction = void (TerrainTree::*)(unsigned, unsigned, unsigned);
+
+	void BuildTree(Core::ThreadPool* threadPool);
+	void ExecuteBuildFunction(Core::ThreadPool* threadPool, unsigned countTasks, BuildFunction function);
+	void InitializeNode(Node& node, unsigned parentIndex, const glm::ivec2& start, const glm::ivec2& end);
+	void SetLeafData(Node& node, unsigned nodeIndex);
+	void CreateChildNodesInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void ComputeLeafConnectivityInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void ComputeInnerNodeDataInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void ComputeInnerNodeData(unsigned nodeIndex);
+
+	void SetLeafSurfaceHeightBounds(unsigned nodeIndex);
+	void ComputeInnerSurfaceHeightBounds(unsigned nodeIndex);
+	void ComputeLeafSurfaceHeightBoundsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void ComputeInnerSurfaceHeightBoundsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
 
 	void InitializeIslandIndices();
-	void ComputeLeafIslands();
+	void ComputeLeafIslands(Core::ThreadPool* threadPool);
+	void InitializeIslandParentsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void UniteLeafIslandsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
+	void FindIslandRootsInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex);
 
-	unsigned& GetNodeIndexForFieldRef(const glm::ivec2& fieldIndex);
+private: // Incremental update.
+
+	// The island sizes are only computed for the first update.
+	Core::IndexVectorU m_IslandSizes;
+	Core::IndexVectorU m_FreeIslandIndices;
+
+	// The search marks are stamped with the search index, the two sides of a search use consecutive stamps.
+	Core::IndexVectorU m_IslandSearchMarks;
+	unsigned m_IslandSearchStamp = 0;
+	Core::IndexVectorU m_IslandSearchNodeIndices[2];
 
-private: // Neighbor indices.
+	// The connectivity of the dirty leafs before the update.
+	glm::ivec2 m_UpdateStart, m_UpdateEnd;
+	std::vector<NodeFlags> m_PreviousLeafFlags;
 
-	static uint64_t GetNodeLocationHash(const glm::ivec2& startIndex,
-		const glm::ivec2& size);
+	bool IsInUpdateRegion(const glm::ivec2& fieldIndex) const;
+	bool HadConnection(const glm::ivec2& fieldIndex, unsigned direction) const;
+	bool HasKeptConnection(unsigned nodeIndex, unsigned direction) const;
 
-	unsigned GetNodeIndex(const LocationHashToIndexMap& locationHashToIndexMap,
-		const glm::ivec2& startIndex, const glm::ivec2& size) const;
+	void InitializeIslandUpdate();
+	unsigned CreateIslandIndex();
+	void RelabelIsland(const Core::IndexVectorU& nodeIndices, unsigned islandIndex);
+	bool SeparateIslands(unsigned nodeIndex0, unsigned nodeIndex1);
+	void MergeIslands(unsigned nodeIndex0, unsigned nodeIndex1);
+	void UpdateIslands();
 
 public:
 
 	explicit TerrainTree(const Terrain& terrain);
-	TerrainTree(const Terrain& terrain, const MainApplication* application);
+	TerrainTree(const Terrain& terrain, Core::ThreadPool* threadPool);
 
 	const Terrain& GetTerrain() const;
 
@@ -186,8 +223,45 @@ public:
 		const glm::ivec2& endIndex, unsigned nodeSize,
 		Core::IndexVectorU& nodeIndices) const;
 
+	// Updates the tree after the heights of the fields in the given rectangle have been changed.
+	void UpdateTerrainHeights(const glm::ivec2& changeStart, const glm::ivec2& changeEnd);
+
+	// The stamp is unique over all trees, so the data that is derived from a tree can be validated with it,
+	// even if the tree has been replaced.
+	uint64_t GetChangeStamp() const;
+
 	void SerializeSB(Core::ByteVector& bytes) const;
-	void DeserializeSB(const unsigned char*& bytes);
+	void DeserializeSB(const unsigned char*& bytes, const MappableDataSource& source, bool hasSurfaceHeightBounds);
+	void DeserializeLegacySB(const unsigned char*& bytes);
+
+	// Must be called after deserializing a tree without surface height bounds.
+	void ComputeSurfaceHeightBounds(Core::ThreadPool* threadPool);
+
+	// Copies the data that is mapped from a level file.
+	void CopyMappedData();
+
+public: // Ray intersection.
+
+	// Returns the smallest nonnegative ray parameter t, for which the ray is UNDER the surface.
+	// Note that for rays which starts from below the surface the result is (approximately) zero.
+	// Note that an intersection with the "outside terrain" is also considered.
+	float IntersectRay(const glm::vec3& rayOrigin, const glm::vec3& rayDir) const;
+
+	// Returns the parameter in [0, 1] of the first point of the segment that is under the surface or
+	// an invalid intersection if the segment is above the surface.
+	float IntersectSegment(const glm::vec3& start, const glm::vec3& end) const;
+
+	// Intersects the rays in parallel.
+	void IntersectRays(Core::ThreadPool& threadPool, const glm::vec3* rayOrigins, const glm::vec3* rayDirs,
+		unsigned countRays, float* ts) const;
+
+private:
+
+	mutable const glm::vec3* m_RayOrigins = nullptr;
+	mutable const glm::vec3* m_RayDirs = nullptr;
+	mutable float* m_RayTs = nullptr;
+
+	void IntersectRaysInThread(unsigned threadId, unsigned startTaskIndex, unsigned endTaskIndex) const;
 
 public: // Hierarchical culling.
 
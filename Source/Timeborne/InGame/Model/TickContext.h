@@ -2,10 +2,25 @@
 
 #pragma once
 
+#include <Timeborne/Declarations/CoreDeclarations.h>
+
 #include <cstdint>
+#include <vector>
+
+struct PathQuery;
+struct TickTimings;
 
 struct TickContext
 {
 	uint32_t UpdateIntervalInMillis;
 	uint32_t TickCount;
+
+	// Can be null, then all work is executed on the calling thread.
+	Core::ThreadPool* ThreadPool;
+
+	// Can be null, then the execution times are not measured.
+	TickTimings* Timings;
+
+	// Can be null, otherwise the solved path queries are recorded for benchmarking the path finding.
+	std::vector<PathQuery>* PathQueries;
 };
\ No newline at end of file
@@ -0,0 +1,38 @@
+// Timeborne/InGame/Model/TickTimings.cpp
+
+#include <Timeborne/InGame/Model/TickTimings.h>
+
+#include <cassert>
+
+TickTimings::TickTimings()
+{
+	Reset();
+}
+
+void TickTimings::Reset()
+{
+	for (uint32_t i = 0; i < c_CountStages; i++)
+	{
+		DurationsInSeconds[i] = 0.0;
+	}
+}
+
+void TickTimings::Add(Stage stage, Clock::time_point startTime, Clock::time_point endTime)
+{
+	assert(stage < Stage::COUNT);
+	DurationsInSeconds[(uint32_t)stage] += std::chrono::duration<double>(endTime - startTime).count();
+}
+
+const char* TickTimings::GetStageName(Stage stage)
+{
+	switch (stage)
+	{
+		case Stage::CommandList: return "CommandList";
+		case Stage::Commands: return "Commands";
+		case Stage::PathRequests: return "PathRequests";
+		case Stage::Movement: return "Movement";
+		case Stage::Fight: return "Fight";
+		case Stage::Work: return "Work";
+		default: return "Unknown";
+	}
+}
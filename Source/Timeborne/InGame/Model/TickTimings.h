@@ -0,0 +1,61 @@
+// Timeborne/InGame/Model/TickTimings.h
+
+#pragma once
+
+#include <Timeborne/Profiler.h>
+
+#include <chrono>
+#include <cstdint>
+
+// Execution times of the tick stages. The model only measures them if the tick context references an object.
+struct TickTimings
+{
+	enum class Stage : uint32_t
+	{
+		CommandList,
+		Commands,
+		PathRequests,
+		Movement,
+		Fight,
+		Work,
+		COUNT
+	};
+
+	static constexpr uint32_t c_CountStages = (uint32_t)Stage::COUNT;
+
+	using Clock = std::chrono::steady_clock;
+
+	double DurationsInSeconds[c_CountStages];
+
+	TickTimings();
+
+	void Reset();
+	void Add(Stage stage, Clock::time_point startTime, Clock::time_point endTime);
+
+	static const char* GetStageName(Stage stage);
+};
+
+// Measures the lifetime of the object as the execution time of the stage, if the timings are not null.
+// The stage is also recorded as a profiler zone.
+class TickStageTimer
+{
+	TickTimings* m_Timings;
+	TickTimings::Stage m_Stage;
+	TickTimings::Clock::time_point m_StartTime;
+	ProfilerZone m_ProfilerZone;
+
+public:
+
+	TickStageTimer(TickTimings* timings, TickTimings::Stage stage)
+		: m_Timings(timings)
+		, m_Stage(stage)
+		, m_ProfilerZone(TickTimings::GetStageName(stage))
+	{
+		if (m_Timings != nullptr) m_StartTime = TickTimings::Clock::now();
+	}
+
+	~TickStageTimer()
+	{
+		if (m_Timings != nullptr) m_Timings->Add(m_Stage, m_StartTime, TickTimings::Clock::now());
+	}
+};
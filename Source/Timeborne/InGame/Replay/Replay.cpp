@@ -0,0 +1,109 @@
+// Timeborne/InGame/Replay/Replay.cpp
+
+#include <Timeborne/InGame/Replay/Replay.h>
+
+#include <Timeborne/InGame/Controller/CommandList.h>
+#include <Timeborne/InGame/GameState/ServerGameState.h>
+#include <Timeborne/InGame/Model/CommandListProcessor.h>
+
+#include <Core/SimpleBinarySerialization.hpp>
+#include <Core/System/SimpleIO.h>
+
+#include <cassert>
+
+void Replay::SerializeSB(Core::ByteVector& bytes) const
+{
+	Core::SerializeSB(bytes, CreationData);
+	Core::SerializeSB(bytes, CountTicks);
+	Core::SerializeSB(bytes, ChecksumIntervalInTicks);
+
+	Core::SerializeSB(bytes, (uint32_t)Commands.size());
+	for (auto& command : Commands)
+	{
+		Core::SerializeSB(bytes, command.TickCount);
+		Core::SerializeSB(bytes, command.Command);
+	}
+
+	Core::SerializeSB(bytes, (uint32_t)Checksums.size());
+	for (auto& checksum : Checksums)
+	{
+		Core::SerializeSB(bytes, checksum.TickCount);
+		Core::SerializeSB(bytes, checksum.Checksum);
+	}
+}
+
+void Replay::DeserializeSB(const unsigned char*& bytes)
+{
+	Core::DeserializeSB(bytes, CreationData);
+	Core::DeserializeSB(bytes, CountTicks);
+	Core::DeserializeSB(bytes, ChecksumIntervalInTicks);
+
+	uint32_t countCommands;
+	Core::DeserializeSB(bytes, countCommands);
+	Commands.resize(countCommands);
+	for (auto& command : Commands)
+	{
+		Core::DeserializeSB(bytes, command.TickCount);
+		Core::DeserializeSB(bytes, command.Command);
+	}
+
+	uint32_t countChecksums;
+	Core::DeserializeSB(bytes, countChecksums);
+	Checksums.resize(countChecksums);
+	for (auto& checksum : Checksums)
+	{
+		Core::DeserializeSB(bytes, checksum.TickCount);
+		Core::DeserializeSB(bytes, checksum.Checksum);
+	}
+}
+
+void Replay::Save(const std::string& filePath) const
+{
+	Core::ByteVector bytes;
+	SerializeSB(bytes);
+	Core::WriteAllBytes(filePath, bytes);
+}
+
+void Replay::Load(const std::string& filePath)
+{
+	auto bytes = Core::ReadAllBytes(filePath);
+	auto byteArray = (const unsigned char*)bytes.GetArray();
+	DeserializeSB(byteArray);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+ReplayRecorder::ReplayRecorder(const GameCreationData& creationData, uint32_t checksumIntervalInTicks)
+{
+	assert(checksumIntervalInTicks > 0);
+	m_Replay.CreationData = creationData;
+	m_Replay.ChecksumIntervalInTicks = checksumIntervalInTicks;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+}
+
+void ReplayRecorder::RecordTick(uint32_t tickCount, const CommandList& commandList,
+	const CommandListProcessor& processor, const ServerGameState& modelGameState)
+{
+	assert(tickCount > m_Replay.CountTicks);
+	m_Replay.CountTicks = tickCount;
+
+	processor.GetAvailableCommands(CommandSource::GameObject, m_CommandIds);
+	auto countCommands = m_CommandIds.GetSize();
+	for (unsigned i = 0; i < countCommands; i++)
+	{
+		m_Replay.Commands.push_back({ tickCount, commandList.GetGameObjectCommand(m_CommandIds[i]) });
+	}
+
+	if (tickCount % m_Replay.ChecksumIntervalInTicks == 0)
+	{
+		m_Replay.Checksums.push_back({ tickCount, modelGameState.ComputeChecksum() });
+	}
+}
+
+const Replay& ReplayRecorder::GetReplay() const
+{
+	return m_Replay;
+}
@@ -0,0 +1,65 @@
+// Timeborne/InGame/Replay/Replay.h
+
+#pragma once
+
+#include <Timeborne/GameCreation/GameCreationData.h>
+#include <Timeborne/InGame/Controller/GameObjects/GameObjectCommand.h>
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CommandList;
+class CommandListProcessor;
+class ServerGameState;
+
+// The game creation data and the executed commands fully determine a game that has been started from a level.
+// The replay stores them with the game state checksums of every N-th tick in order to verify the re-simulation.
+
+struct ReplayCommand
+{
+	uint32_t TickCount; // The tick, in which the command has been executed.
+	GameObjectCommand Command;
+};
+
+struct ReplayChecksum
+{
+	uint32_t TickCount;
+	uint64_t Checksum;
+};
+
+struct Replay
+{
+	GameCreationData CreationData;
+	uint32_t CountTicks = 0;
+	uint32_t ChecksumIntervalInTicks = 0;
+
+	// Sorted by the tick count.
+	std::vector<ReplayCommand> Commands;
+	std::vector<ReplayChecksum> Checksums;
+
+	void SerializeSB(Core::ByteVector& bytes) const;
+	void DeserializeSB(const unsigned char*& bytes);
+
+	void Save(const std::string& filePath) const;
+	void Load(const std::string& filePath);
+};
+
+class ReplayRecorder
+{
+	Replay m_Replay;
+	Core::IndexVectorU m_CommandIds;
+
+public:
+
+	ReplayRecorder(const GameCreationData& creationData, uint32_t checksumIntervalInTicks);
+	~ReplayRecorder();
+
+	// Must be called after each tick of the model.
+	void RecordTick(uint32_t tickCount, const CommandList& commandList, const CommandListProcessor& processor,
+		const ServerGameState& modelGameState);
+
+	const Replay& GetReplay() const;
+};
@@ -0,0 +1,187 @@
+// Timeborne/InGame/Replay/ReplayRunner.cpp
+
+#include <Timeborne/InGame/Replay/ReplayRunner.h>
+
+#include <Timeborne/InGame/Controller/CommandList.h>
+#include <Timeborne/InGame/GameState/ClientGameState.h>
+#include <Timeborne/InGame/Model/InGameModel.h>
+#include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/TickContext.h>
+#include <Timeborne/InGame/InGame.h>
+
+#include <Core/System/ThreadPool.h>
+
+#include <cxxopts.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+constexpr unsigned c_ReplayUpdateIntervalInMillis = 10; // Same as in the game.
+
+ReplayRunner::ReplayRunner(const Settings& settings)
+	: m_Settings(settings)
+{
+}
+
+ReplayRunner::~ReplayRunner()
+{
+}
+
+void ReplayRunner::Initialize(Core::ThreadPool* threadPool)
+{
+	m_Replay.Load(m_Settings.ReplayFilePath);
+
+	m_Level = std::make_unique<Level>();
+	m_Level->Load(m_Settings.LevelFilePath, false, threadPool);
+	if (m_Level->GetName() != m_Replay.CreationData.LevelName)
+	{
+		throw std::runtime_error("The level of the replay is '" + m_Replay.CreationData.LevelName
+			+ "', but the level file contains '" + m_Level->GetName() + "'.");
+	}
+
+	InGame::RemapPlayerIndices(m_Replay.CreationData, *m_Level);
+
+	m_ClientGameState = std::make_unique<ClientGameState>();
+	m_ClientGameState->SetGameCreationData(m_Replay.CreationData);
+	m_ClientGameState->SetLockstep(m_Replay.CreationData.Players.IsMultiplayerGame());
+
+	m_CommandList = std::make_unique<CommandList>();
+	m_Model = std::make_unique<InGameModel>(*m_Level, *m_ClientGameState, *m_CommandList, false);
+
+	m_NextCommandIndex = 0;
+	m_NextChecksumIndex = 0;
+	m_FirstMismatchTickCount = Core::c_InvalidIndexU;
+}
+
+const Replay& ReplayRunner::GetReplay() const
+{
+	return m_Replay;
+}
+
+ClientGameState& ReplayRunner::GetClientGameState()
+{
+	assert(m_ClientGameState != nullptr);
+	return *m_ClientGameState;
+}
+
+uint32_t ReplayRunner::GetTickCount() const
+{
+	assert(m_ClientGameState != nullptr);
+	return m_ClientGameState->GetClientModelGameState().GetTickCount();
+}
+
+uint32_t ReplayRunner::GetFirstMismatchTickCount() const
+{
+	return m_FirstMismatchTickCount;
+}
+
+void ReplayRunner::Tick(Core::ThreadPool* threadPool)
+{
+	auto& modelGameState = m_ClientGameState->GetClientModelGameState();
+	modelGameState.IncreaseTickCount();
+	uint32_t tickCount = modelGameState.GetTickCount();
+
+	// The commands are added in the tick of their execution. The command list processor makes them available
+	// in the same tick, since the action points are the same as in the recorded game.
+	auto& commands = m_Replay.Commands;
+	for (; m_NextCommandIndex < commands.size() && commands[m_NextCommandIndex].TickCount == tickCount;
+		m_NextCommandIndex++)
+	{
+		m_CommandList->AddCommand(commands[m_NextCommandIndex].Command);
+	}
+
+	TickContext context;
+	context.UpdateIntervalInMillis = c_ReplayUpdateIntervalInMillis;
+	context.TickCount = tickCount;
+	context.ThreadPool = threadPool;
+	context.Timings = nullptr;
+	context.PathQueries = nullptr;
+
+	m_Model->Tick(context);
+
+	auto& checksums = m_Replay.Checksums;
+	if (m_NextChecksumIndex < checksums.size() && checksums[m_NextChecksumIndex].TickCount == tickCount)
+	{
+		// The replay files store the checksums. The incrementally maintained hash is verified at the same ticks.
+		assert(modelGameState.IsStateHashConsistent());
+
+		if (m_FirstMismatchTickCount == Core::c_InvalidIndexU
+			&& modelGameState.ComputeChecksum() != checksums[m_NextChecksumIndex].Checksum)
+		{
+			m_FirstMismatchTickCount = tickCount;
+		}
+		m_NextChecksumIndex++;
+	}
+}
+
+bool ReplayRunner::AdvanceToTick(uint32_t tickCount, Core::ThreadPool* threadPool)
+{
+	assert(m_Model != nullptr);
+	tickCount = std::min(tickCount, m_Replay.CountTicks);
+	while (GetTickCount() < tickCount)
+	{
+		Tick(threadPool);
+	}
+	return (m_FirstMismatchTickCount == Core::c_InvalidIndexU);
+}
+
+int ReplayRunner::Run()
+{
+	auto countThreads = (m_Settings.CountThreads > 0)
+		? m_Settings.CountThreads
+		: std::max(std::thread::hardware_concurrency(), 1U);
+	Core::ThreadPool threadPool(countThreads);
+
+	Initialize(&threadPool);
+
+	auto startTime = std::chrono::steady_clock::now();
+	bool matching = AdvanceToTick(m_Settings.EndTickCount, &threadPool);
+	auto duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	auto countTicks = GetTickCount();
+	printf("Replay: %s, level: %s\n", m_Settings.ReplayFilePath.c_str(), m_Replay.CreationData.LevelName.c_str());
+	printf("  ticks: %u / %u, commands: %u, threads: %u\n", countTicks, m_Replay.CountTicks,
+		(uint32_t)m_NextCommandIndex, countThreads);
+	printf("  ticks/s: %.1f, time: %.3f s\n", (duration > 0.0) ? (double)countTicks / duration : 0.0, duration);
+	if (matching)
+	{
+		printf("  checksums: %u verified\n", (uint32_t)m_NextChecksumIndex);
+		return 0;
+	}
+	printf("  checksums: MISMATCH, first at tick %u\n", m_FirstMismatchTickCount);
+	return 1;
+}
+
+bool ReplayRunner::ParseCommandLine(int argc, char* argv[], Settings& settings)
+{
+	// The game's own arguments are not known here, so the options are only parsed in the replay mode.
+	bool isRequested = false;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--replay") == 0) isRequested = true;
+	}
+	if (!isRequested) return false;
+
+	// Parsing a copy, since the options library may modify the argument list.
+	std::vector<char*> argvCopy(argv, argv + argc);
+	auto argcCopy = argc;
+	auto argvCopyPtr = argvCopy.data();
+
+	cxxopts::Options options("Timeborne");
+	options.add_options()("replay", "Replay file path", cxxopts::value<std::string>(settings.ReplayFilePath));
+	options.add_options()("level", "Level file path", cxxopts::value<std::string>(settings.LevelFilePath));
+	options.add_options()("ticks", "End tick count", cxxopts::value<uint32_t>(settings.EndTickCount));
+	options.add_options()("threads", "Count threads", cxxopts::value<uint32_t>(settings.CountThreads));
+	options.parse(argcCopy, argvCopyPtr);
+
+	if (settings.ReplayFilePath.empty() || settings.LevelFilePath.empty())
+	{
+		throw std::runtime_error("The replay requires a replay and a level file path.");
+	}
+	return true;
+}
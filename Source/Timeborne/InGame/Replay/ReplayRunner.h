@@ -0,0 +1,71 @@
+// Timeborne/InGame/Replay/ReplayRunner.h
+
+#pragma once
+
+#include <Timeborne/Declarations/CoreDeclarations.h>
+#include <Timeborne/InGame/Replay/Replay.h>
+
+#include <Core/Constants.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class ClientGameState;
+class CommandList;
+class InGameModel;
+class Level;
+
+// Re-simulates a replay as fast as possible, without the real time pacing of the game, and verifies the game state
+// checksums. Seeking is done by advancing to the target tick.
+//
+// Usage: Timeborne --replay <replay file path> --level <level file path> [--ticks N] [--threads N]
+class ReplayRunner
+{
+public:
+
+	struct Settings
+	{
+		std::string ReplayFilePath;
+		std::string LevelFilePath;
+		uint32_t EndTickCount = Core::c_InvalidIndexU; // Invalid: to the end of the replay.
+		uint32_t CountThreads = 0; // 0: using the hardware concurrency.
+	};
+
+private:
+
+	Settings m_Settings;
+	Replay m_Replay;
+
+	std::unique_ptr<Level> m_Level;
+	std::unique_ptr<ClientGameState> m_ClientGameState;
+	std::unique_ptr<CommandList> m_CommandList;
+	std::unique_ptr<InGameModel> m_Model;
+
+	size_t m_NextCommandIndex = 0;
+	size_t m_NextChecksumIndex = 0;
+	uint32_t m_FirstMismatchTickCount = Core::c_InvalidIndexU;
+
+	void Tick(Core::ThreadPool* threadPool);
+
+public:
+
+	explicit ReplayRunner(const Settings& settings);
+	~ReplayRunner();
+
+	void Initialize(Core::ThreadPool* threadPool);
+
+	const Replay& GetReplay() const;
+	ClientGameState& GetClientGameState();
+	uint32_t GetTickCount() const;
+
+	// Returns false if a checksum mismatch has been found until the tick count.
+	bool AdvanceToTick(uint32_t tickCount, Core::ThreadPool* threadPool);
+
+	uint32_t GetFirstMismatchTickCount() const;
+
+	int Run();
+
+	// Returns false if the replay is not requested. Throws if the replay options are invalid.
+	static bool ParseCommandLine(int argc, char* argv[], Settings& settings);
+};
@@ -0,0 +1,430 @@
+// Timeborne/InGame/SimulationBenchmark.cpp
+
+#include <Timeborne/InGame/SimulationBenchmark.h>
+
+#include <Timeborne/GameCreation/GameCreationData.h>
+#include <Timeborne/InGame/Controller/CommandList.h>
+#include <Timeborne/InGame/Controller/GameObjects/GameObjectCommand.h>
+#include <Timeborne/InGame/GameState/ClientGameState.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObjectModel.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObjectMovementSubsystem.h>
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/AStar.h>
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/PathFinder.h>
+#include <Timeborne/InGame/Model/GameObjects/PathFinding/SimpleHierarchicalPathFinder.h>
+#include <Timeborne/InGame/Model/GameObjects/Prototype/GameObjectPrototype.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
+#include <Timeborne/InGame/Model/InGameModel.h>
+#include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/TickContext.h>
+#include <Timeborne/InGame/Model/TickTimings.h>
+#include <Timeborne/Profiler.h>
+
+#include <Core/SimpleBinarySerialization.hpp>
+#include <Core/System/SimpleIO.h>
+#include <Core/System/ThreadPool.h>
+
+#include <cxxopts.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+constexpr unsigned c_BenchmarkUpdateIntervalInMillis = 10; // Same as in the game.
+constexpr uint32_t c_BenchmarkCountPlayers = 2;
+
+inline double GetPercentile(std::vector<double>& values, double percentile)
+{
+	if (values.empty()) return 0.0;
+	auto index = (size_t)(percentile * (double)(values.size() - 1) + 0.5);
+	std::nth_element(values.begin(), values.begin() + index, values.end());
+	return values[index];
+}
+
+SimulationBenchmark::SimulationBenchmark(const Settings& settings)
+	: m_Settings(settings)
+	, m_Random(settings.Seed)
+{
+}
+
+SimulationBenchmark::~SimulationBenchmark()
+{
+}
+
+void SimulationBenchmark::CollectAccessibleFields(const Level& level)
+{
+	auto& terrainTree = *level.GetTerrainTree();
+	auto countFields = glm::ivec2(level.GetCountFields());
+
+	unsigned islandIndex = Core::c_InvalidIndexU;
+	for (int z = 0; z < countFields.y; z++)
+	{
+		for (int x = 0; x < countFields.x; x++)
+		{
+			glm::ivec2 fieldIndex(x, z);
+			auto nodeIndex = terrainTree.GetNodeIndexForField(fieldIndex);
+			if (terrainTree.GetNode(nodeIndex).Flags == TerrainTree::NodeFlags::None) continue;
+
+			auto nodeIslandIndex = terrainTree.GetIslandIndex(nodeIndex);
+			if (islandIndex == Core::c_InvalidIndexU) islandIndex = nodeIslandIndex;
+			if (nodeIslandIndex == islandIndex) m_AccessibleFields.push_back(fieldIndex);
+		}
+	}
+}
+
+glm::ivec2 SimulationBenchmark::GetRandomAccessibleField()
+{
+	std::uniform_int_distribution<size_t> distribution(0, m_AccessibleFields.size() - 1);
+	return m_AccessibleFields[distribution(m_Random)];
+}
+
+void SimulationBenchmark::AddUnits(Level& level)
+{
+	// The players start on the opposite sides of the level, so that their units meet when moving to random targets.
+	auto fields = m_AccessibleFields;
+	std::sort(fields.begin(), fields.end(), [](const glm::ivec2& a, const glm::ivec2& b) {
+		return (a.x != b.x) ? (a.x < b.x) : (a.y < b.y); });
+	auto countSideFields = (uint32_t)fields.size() / c_BenchmarkCountPlayers;
+
+	auto countUnitsPerPlayer = (m_Settings.CountUnits + c_BenchmarkCountPlayers - 1) / c_BenchmarkCountPlayers;
+	if (countUnitsPerPlayer > countSideFields)
+	{
+		throw std::runtime_error("The level has not enough accessible fields for the benchmark units.");
+	}
+
+	auto& terrain = level.GetTerrain();
+	auto& levelObjects = level.GetGameObjects();
+	auto typeIndex = GameObjectTypeIndex::TestInfantryUnit;
+	auto& prototype = *GameObjectPrototype::GetPrototypes()[(uint32_t)typeIndex];
+	std::uniform_real_distribution<float> yawDistribution(0.0f, 360.0f);
+
+	for (uint32_t playerIndex = 0; playerIndex < c_BenchmarkCountPlayers; playerIndex++)
+	{
+		auto sideStart = fields.begin() + playerIndex * countSideFields;
+		std::shuffle(sideStart, sideStart + countSideFields, m_Random);
+	}
+
+	for (uint32_t i = 0; i < m_Settings.CountUnits; i++)
+	{
+		auto playerIndex = i % c_BenchmarkCountPlayers;
+		auto& fieldIndex = fields[playerIndex * countSideFields + i / c_BenchmarkCountPlayers];
+
+		auto& object = levelObjects.PushBackPlaceHolder();
+		object.PlayerIndex = playerIndex;
+		object.TypeIndex = typeIndex;
+		object.Pose.SetPosition(terrain, GameObjectPose::GetMiddle2dFromTerrainFieldIndex(fieldIndex),
+			prototype.GetMovement().FlyHeight);
+		object.Pose.SetOrientationFromTerrain(terrain, yawDistribution(m_Random));
+	}
+}
+
+void SimulationBenchmark::AddCommands(ClientGameState& clientGameState, CommandList& commandList)
+{
+	auto& gameObjects = clientGameState.GetClientModelGameState().GetGameObjects().Get();
+
+	std::vector<GameObjectId> playerObjectIds[c_BenchmarkCountPlayers];
+	for (auto& oIt : gameObjects)
+	{
+		auto& object = oIt.second;
+		playerObjectIds[object.Data.PlayerIndex].push_back(object.Id);
+	}
+
+	for (uint32_t playerIndex = 0; playerIndex < c_BenchmarkCountPlayers; playerIndex++)
+	{
+		auto& sourceIds = playerObjectIds[playerIndex];
+		auto& enemyIds = playerObjectIds[1 - playerIndex];
+		if (sourceIds.empty()) continue;
+
+		std::shuffle(sourceIds.begin(), sourceIds.end(), m_Random);
+		auto countSources = (uint32_t)sourceIds.size();
+		if (m_Settings.MaxCountCommandSources > 0)
+		{
+			countSources = std::min(countSources, m_Settings.MaxCountCommandSources);
+		}
+
+		GameObjectCommand command;
+		for (uint32_t i = 0; i < countSources; i++)
+		{
+			command.SourceIds.PushBack(sourceIds[i]);
+		}
+
+		// Alternating between attacking a random enemy and moving to a random field.
+		std::bernoulli_distribution attackDistribution(0.5);
+		if (!enemyIds.empty() && attackDistribution(m_Random))
+		{
+			std::uniform_int_distribution<size_t> enemyDistribution(0, enemyIds.size() - 1);
+			command.Type = GameObjectCommand::Type::ObjectToObject;
+			command.TargetId = enemyIds[enemyDistribution(m_Random)];
+			command.TargetField = glm::ivec2(-1);
+		}
+		else
+		{
+			command.Type = GameObjectCommand::Type::ObjectToTerrain;
+			command.TargetId = c_InvalidGameObjectId;
+			command.TargetField = GetRandomAccessibleField();
+		}
+
+		commandList.AddCommand(command);
+	}
+}
+
+void SimulationBenchmark::ReplayPathQueries(const Level& level, ServerGameState& modelGameState,
+	const std::vector<PathQuery>& pathQueries)
+{
+	using Clock = TickTimings::Clock;
+
+	auto countQueries = std::min((uint32_t)pathQueries.size(), m_Settings.MaxCountPathQueries);
+	printf("  path queries: %u recorded, %u replayed\n", (uint32_t)pathQueries.size(), countQueries);
+	if (countQueries == 0) return;
+
+	GameObjectData gameObjectData;
+	gameObjectData.ClientModelGameState = &modelGameState;
+	PathFindingContext context{ gameObjectData, level, *level.GetTerrainTree() };
+
+	AStar aStar;
+	SimpleHierarchicalPathFinder hierarchicalPathFinder;
+	Core::IndexVectorU nodeIndices;
+
+	enum { AStarOnly, Hierarchical, CountAlgorithms };
+	const char* algorithmNames[CountAlgorithms] = { "A*", "hierarchical" };
+	std::vector<double> durations[CountAlgorithms];
+	uint64_t countExpandedNodes[CountAlgorithms] = {};
+	uint64_t countPathNodes[CountAlgorithms] = {};
+
+	for (uint32_t i = 0; i < countQueries; i++)
+	{
+		auto& query = pathQueries[i];
+		auto distanceParameters = query.HasDistanceParameters ? &query.DistanceParameters : nullptr;
+
+		for (uint32_t j = 0; j < CountAlgorithms; j++)
+		{
+			auto startTime = Clock::now();
+			if (j == AStarOnly)
+			{
+				aStar.FindPath(context, query.StartNodeIndex, query.EndNodeIndex, distanceParameters, nodeIndices);
+				countExpandedNodes[j] += aStar.GetCountExpandedNodes();
+			}
+			else
+			{
+				hierarchicalPathFinder.FindPath(context, aStar, query.StartNodeIndex, query.EndNodeIndex,
+					distanceParameters, nodeIndices);
+				countExpandedNodes[j] += hierarchicalPathFinder.GetCountExpandedNodes();
+			}
+			auto endTime = Clock::now();
+
+			durations[j].push_back(std::chrono::duration<double>(endTime - startTime).count());
+			countPathNodes[j] += nodeIndices.GetSize();
+		}
+	}
+
+	printf("  %-14s %14s %12s %12s %12s\n", "path finder", "avg expanded", "avg length", "p50 [ms]", "p99 [ms]");
+	for (uint32_t j = 0; j < CountAlgorithms; j++)
+	{
+		printf("  %-14s %14.1f %12.1f %12.4f %12.4f\n", algorithmNames[j],
+			(double)countExpandedNodes[j] / countQueries, (double)countPathNodes[j] / countQueries,
+			GetPercentile(durations[j], 0.5) * 1000.0, GetPercentile(durations[j], 0.99) * 1000.0);
+	}
+}
+
+void SimulationBenchmark::SavePathQueries(const std::string& filePath, const Level& level,
+	const std::vector<PathQuery>& pathQueries)
+{
+	// The node indices are only valid for the same terrain tree.
+	Core::ByteVector bytes;
+	Core::SerializeSB(bytes, level.GetTerrainTree()->GetCountNodes());
+	Core::SerializeSB(bytes, (uint32_t)pathQueries.size());
+	for (auto& query : pathQueries)
+	{
+		Core::SerializeSB(bytes, query);
+	}
+	Core::WriteAllBytes(filePath, bytes);
+}
+
+void SimulationBenchmark::LoadPathQueries(const std::string& filePath, const Level& level,
+	std::vector<PathQuery>& pathQueries)
+{
+	auto bytes = Core::ReadAllBytes(filePath);
+	auto byteArray = (const unsigned char*)bytes.GetArray();
+
+	unsigned countNodes;
+	Core::DeserializeSB(byteArray, countNodes);
+	if (countNodes != level.GetTerrainTree()->GetCountNodes())
+	{
+		throw std::runtime_error("The path queries have been recorded on a different level.");
+	}
+
+	uint32_t countQueries;
+	Core::DeserializeSB(byteArray, countQueries);
+	pathQueries.resize(countQueries);
+	for (auto& query : pathQueries)
+	{
+		Core::DeserializeSB(byteArray, query);
+	}
+}
+
+int SimulationBenchmark::RunPathQueryReplay()
+{
+	Level level;
+	level.Load(m_Settings.LevelFilePath, false, nullptr);
+
+	std::vector<PathQuery> pathQueries;
+	LoadPathQueries(m_Settings.ReplayedPathQueriesFilePath, level, pathQueries);
+
+	// The path finding only reads the terrain, the game state is not used.
+	ServerGameState gameState;
+
+	printf("Path query replay: %s, level: %s\n", m_Settings.ReplayedPathQueriesFilePath.c_str(),
+		m_Settings.LevelFilePath.c_str());
+	ReplayPathQueries(level, gameState, pathQueries);
+	return 0;
+}
+
+int SimulationBenchmark::Run()
+{
+	using Clock = TickTimings::Clock;
+
+	if (!m_Settings.ReplayedPathQueriesFilePath.empty()) return RunPathQueryReplay();
+
+	Profiler::GetInstance()->SetEnabled(!m_Settings.TraceFilePath.empty());
+
+	auto countThreads = (m_Settings.CountThreads > 0)
+		? m_Settings.CountThreads
+		: std::max(std::thread::hardware_concurrency(), 1U);
+	Core::ThreadPool threadPool(countThreads);
+
+	Level level;
+	level.Load(m_Settings.LevelFilePath, false, &threadPool);
+
+	CollectAccessibleFields(level);
+	AddUnits(level);
+
+	GameCreationData gameCreationData;
+	for (uint32_t playerIndex = 0; playerIndex < c_BenchmarkCountPlayers; playerIndex++)
+	{
+		gameCreationData.Players.AddPlayer();
+		gameCreationData.Players.SetAllianceIndex(playerIndex, playerIndex);
+	}
+	gameCreationData.LocalPlayerIndex = 0;
+	gameCreationData.LevelName = level.GetName();
+
+	ClientGameState clientGameState;
+	clientGameState.SetGameCreationData(gameCreationData);
+
+	CommandList commandList;
+	InGameModel model(level, clientGameState, commandList, false);
+
+	auto& modelGameState = clientGameState.GetClientModelGameState();
+
+	std::vector<double> tickDurations;
+	std::vector<double> stageDurations[TickTimings::c_CountStages];
+	tickDurations.reserve(m_Settings.CountTicks);
+	for (auto& durations : stageDurations) durations.reserve(m_Settings.CountTicks);
+
+	TickTimings timings;
+	std::vector<PathQuery> pathQueries;
+	double totalDuration = 0.0;
+	for (uint32_t i = 0; i < m_Settings.CountTicks; i++)
+	{
+		if (m_Settings.CommandIntervalInTicks > 0 && i % m_Settings.CommandIntervalInTicks == 0)
+		{
+			AddCommands(clientGameState, commandList);
+		}
+
+		modelGameState.IncreaseTickCount();
+
+		TickContext context;
+		context.UpdateIntervalInMillis = c_BenchmarkUpdateIntervalInMillis;
+		context.TickCount = modelGameState.GetTickCount();
+		context.ThreadPool = &threadPool;
+		context.Timings = &timings;
+		context.PathQueries = (pathQueries.size() < m_Settings.MaxCountPathQueries) ? &pathQueries : nullptr;
+
+		timings.Reset();
+		auto startTime = Clock::now();
+		model.Tick(context);
+		auto endTime = Clock::now();
+
+		auto tickDuration = std::chrono::duration<double>(endTime - startTime).count();
+		totalDuration += tickDuration;
+		tickDurations.push_back(tickDuration);
+		for (uint32_t j = 0; j < TickTimings::c_CountStages; j++)
+		{
+			stageDurations[j].push_back(timings.DurationsInSeconds[j]);
+		}
+	}
+
+	printf("Simulation benchmark: %s\n", m_Settings.LevelFilePath.c_str());
+	printf("  units: %u, remaining objects: %u, ticks: %u, threads: %u, seed: %u\n",
+		m_Settings.CountUnits, (uint32_t)modelGameState.GetGameObjects().Get().size(), m_Settings.CountTicks,
+		countThreads, m_Settings.Seed);
+	printf("  ticks/s: %.1f, state checksum: %016llx\n",
+		(totalDuration > 0.0) ? (double)m_Settings.CountTicks / totalDuration : 0.0,
+		(unsigned long long)modelGameState.ComputeChecksum());
+	printf("  state hash: %016llx\n", (unsigned long long)modelGameState.GetStateHash());
+	auto& hashBreakdown = modelGameState.GetStateHashBreakdown();
+	for (uint32_t j = 0; j < GameStateHash::c_CountParts; j++)
+	{
+		printf("    %-12s %016llx\n", GameStateHash::GetPartName((GameStateHash::Part)j),
+			(unsigned long long)hashBreakdown.Parts[j]);
+	}
+	printf("  %-14s %12s %12s\n", "stage", "p50 [ms]", "p99 [ms]");
+	for (uint32_t j = 0; j < TickTimings::c_CountStages; j++)
+	{
+		auto& durations = stageDurations[j];
+		auto p50 = GetPercentile(durations, 0.5) * 1000.0;
+		auto p99 = GetPercentile(durations, 0.99) * 1000.0;
+		printf("  %-14s %12.4f %12.4f\n", TickTimings::GetStageName((TickTimings::Stage)j), p50, p99);
+	}
+	printf("  %-14s %12.4f %12.4f\n", "Tick",
+		GetPercentile(tickDurations, 0.5) * 1000.0, GetPercentile(tickDurations, 0.99) * 1000.0);
+	auto& pathCacheStatistics = model.GetGameObjectModel().GetMovementSubsystem().GetPathFinder().GetPathCacheStatistics();
+	printf("  path cache hits: %llu, misses: %llu\n", (unsigned long long)pathCacheStatistics.CountHits,
+		(unsigned long long)pathCacheStatistics.CountMisses);
+
+	ReplayPathQueries(level, modelGameState, pathQueries);
+	if (!m_Settings.SavedPathQueriesFilePath.empty())
+	{
+		SavePathQueries(m_Settings.SavedPathQueriesFilePath, level, pathQueries);
+		printf("Path queries: %s\n", m_Settings.SavedPathQueriesFilePath.c_str());
+	}
+
+	if (!m_Settings.TraceFilePath.empty())
+	{
+		// The thread pool is idle, so the trace can be written.
+		if (!Profiler::GetInstance()->WriteChromeTrace(m_Settings.TraceFilePath))
+		{
+			printf("Failed to write the trace: %s\n", m_Settings.TraceFilePath.c_str());
+			return 1;
+		}
+		printf("Trace: %s\n", m_Settings.TraceFilePath.c_str());
+	}
+
+	return 0;
+}
+
+void SimulationBenchmark::ParseCommandLine(int argc, char* argv[], Settings& settings)
+{
+	cxxopts::Options options("TimeborneBenchmark");
+	options.add_options()("level", "Level file path", cxxopts::value<std::string>(settings.LevelFilePath));
+	options.add_options()("units", "Count units", cxxopts::value<uint32_t>(settings.CountUnits));
+	options.add_options()("ticks", "Count ticks", cxxopts::value<uint32_t>(settings.CountTicks));
+	options.add_options()("command-interval", "Command interval in ticks",
+		cxxopts::value<uint32_t>(settings.CommandIntervalInTicks));
+	options.add_options()("command-sources", "Count commanded units per player",
+		cxxopts::value<uint32_t>(settings.MaxCountCommandSources));
+	options.add_options()("threads", "Count threads", cxxopts::value<uint32_t>(settings.CountThreads));
+	options.add_options()("seed", "Random seed", cxxopts::value<uint32_t>(settings.Seed));
+	options.add_options()("path-queries", "Count replayed path queries",
+		cxxopts::value<uint32_t>(settings.MaxCountPathQueries));
+	options.add_options()("save-path-queries", "Path query file path to save",
+		cxxopts::value<std::string>(settings.SavedPathQueriesFilePath));
+	options.add_options()("replay-path-queries", "Path query file path to replay",
+		cxxopts::value<std::string>(settings.ReplayedPathQueriesFilePath));
+	options.add_options()("trace", "Chrome trace file path", cxxopts::value<std::string>(settings.TraceFilePath));
+	options.parse(argc, argv);
+
+	if (settings.LevelFilePath.empty())
+	{
+		throw std::runtime_error("The benchmark requires a level file path.");
+	}
+}
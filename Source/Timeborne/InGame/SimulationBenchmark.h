@@ -0,0 +1,82 @@
+// Timeborne/InGame/SimulationBenchmark.h
+
+#pragma once
+
+#include <EngineBuildingBlocks/Math/GLM.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+class ClientGameState;
+class CommandList;
+class Level;
+class ServerGameState;
+struct PathQuery;
+
+// Headless simulation benchmark: runs the in-game model on a level with scripted unit commands without creating
+// a window, and prints the tick throughput and the execution time distribution of the tick stages.
+// The path queries of the simulation are recorded, then replayed with the A* and the hierarchical path finder
+// to compare the expanded node counts and the execution times. The recorded queries can be saved and later replayed
+// on the same level without running the simulation.
+//
+// E.g. for measuring the movement of 2000 simultaneously moving units: --units 2000 --command-sources 0
+//
+// The benchmark is built as the separate TimeborneBenchmark console application, which only contains the model and
+// the game state.
+//
+// Usage: TimeborneBenchmark --level <level file path> [--units N] [--ticks N] [--command-interval N]
+//   [--command-sources N] [--threads N] [--seed N] [--path-queries N] [--save-path-queries <file path>] [--replay-path-queries <file path>]
+//   [--trace <Chrome trace file path>]
+class SimulationBenchmark
+{
+public:
+
+	struct Settings
+	{
+		std::string LevelFilePath;
+		uint32_t CountUnits = 256;
+		uint32_t CountTicks = 6000;
+		uint32_t CommandIntervalInTicks = 50;
+		uint32_t MaxCountCommandSources = 16; // The count of the commanded units per player. 0: all units.
+		uint32_t CountThreads = 0; // 0: using the hardware concurrency.
+		uint32_t Seed = 0;
+		uint32_t MaxCountPathQueries = 1000; // The count of the replayed path queries. 0: no replay.
+		std::string SavedPathQueriesFilePath; // Empty: the recorded queries are not saved.
+		std::string ReplayedPathQueriesFilePath; // Not empty: only the path queries of the file are replayed.
+		std::string TraceFilePath; // Empty: no trace is written.
+	};
+
+private:
+
+	Settings m_Settings;
+	std::mt19937 m_Random;
+
+	// The accessible fields that belong to the same island as the first one.
+	std::vector<glm::ivec2> m_AccessibleFields;
+
+	void CollectAccessibleFields(const Level& level);
+	void AddUnits(Level& level);
+	void AddCommands(ClientGameState& clientGameState, CommandList& commandList);
+
+	glm::ivec2 GetRandomAccessibleField();
+
+	void ReplayPathQueries(const Level& level, ServerGameState& modelGameState,
+		const std::vector<PathQuery>& pathQueries);
+	int RunPathQueryReplay();
+
+	static void SavePathQueries(const std::string& filePath, const Level& level,
+		const std::vector<PathQuery>& pathQueries);
+	static void LoadPathQueries(const std::string& filePath, const Level& level, std::vector<PathQuery>& pathQueries);
+
+public:
+
+	explicit SimulationBenchmark(const Settings& settings);
+	~SimulationBenchmark();
+
+	int Run();
+
+	// Throws if the benchmark options are invalid.
+	static void ParseCommandLine(int argc, char* argv[], Settings& settings);
+};
@@ -6,6 +6,8 @@
 #include <Timeborne/InGame/GameState/ServerGameState.h>
 #include <Timeborne/Render/SimpleLineRenderer.h>
 
+#include <algorithm>
+
 AttackLineView::AttackLineView()
 {
 }
@@ -33,50 +35,41 @@ void AttackLineView::OnLoading(const ComponentRenderContext& context)
 	m_SourceGameObjectIds.Clear();
 	m_DirtyIds.Clear();
 
-	auto& gameObjectList = m_GameState->GetGameObjects();
-	gameObjectList.AddPoseListenerOnce(*this);
-	gameObjectList.AddFightListenerOnce(*this);
+	m_GameState->AddChangeListenerOnce(*this);
 }
 
-void AttackLineView::OnGameObjectPoseChanged(GameObjectId objectId, const GameObjectPose& pose)
+void AttackLineView::OnGameObjectsChanged(const GameObjectChangeSet& changes)
 {
-	// If it's a source object, it must be set dirty.
-	if (m_SourceGameObjectIds.Contains(objectId))
-	{
-		m_DirtyIds.PushBack(objectId);
-		return;
-	}
+	// A source object is dirty if itself or its target has been moved or its fight state has been changed.
 
-	// Checking whether it's a target object.
 	const auto& gameObjects = m_GameState->GetGameObjects().Get();
 	const auto& fightList = m_GameState->GetFightList();
 
+	auto contains = [](const Core::SimpleTypeVectorU<GameObjectId>& ids, GameObjectId id) {
+		return std::binary_search(ids.GetArray(), ids.GetEndPointer(), id);
+	};
+
 	uint32_t countSourceIds = m_SourceGameObjectIds.GetSize();
 	for (uint32_t i = 0; i < countSourceIds; i++)
 	{
 		auto sourceObjectId = m_SourceGameObjectIds[i];
+
+		// The selection is updated upon the removal by the controller.
 		auto sgIt = gameObjects.find(sourceObjectId);
-		assert(sgIt != gameObjects.end());
+		if (sgIt == gameObjects.end()) continue;
 		const auto& sourceGameObject = sgIt->second;
 
 		if (sourceGameObject.FightIndex == Core::c_InvalidIndexU) continue;
 
-		const auto& fightData = fightList[sourceGameObject.FightIndex];
-
-		if (objectId == fightData.AttackTarget)
+		bool isDirty = contains(changes.MovedIds, sourceObjectId)
+			|| contains(changes.FightStateChangedIds, sourceObjectId);
+		if (!isDirty)
 		{
-			assert(fightData.AttackState != AttackState::None);
-			m_DirtyIds.PushBack(objectId);
-			return;
+			const auto& fightData = fightList[sourceGameObject.FightIndex];
+			isDirty = (fightData.AttackState != AttackState::None && contains(changes.MovedIds, fightData.AttackTarget));
 		}
-	}
-}
 
-void AttackLineView::OnGameObjectFightStateChanged(const GameObject& object, const GameObjectFightData& fightData)
-{
-	if (m_SourceGameObjectIds.Contains(object.Id))
-	{
-		m_DirtyIds.PushBack(object.Id);
+		if (isDirty) m_DirtyIds.PushBack(sourceObjectId);
 	}
 }
 
@@ -13,8 +13,7 @@
 class SimpleLineRenderer;
 
 class AttackLineView : public InGameViewComponent
-	, public GameObjectPoseListener
-	, public GameObjectFightListener
+	, public GameObjectChangeListener
 {
 	std::unique_ptr<SimpleLineRenderer> m_LineRenderer;
 
@@ -40,14 +39,7 @@ public: // InGameViewComponent IF.
 	void PreUpdate(const ComponentPreUpdateContext& context) override;
 	void RenderContent(const ComponentRenderContext& context) override;
 
-public: // GameObjectPoseListener IF.
+public: // GameObjectChangeListener IF.
 
-	void OnGameObjectPoseChanged(GameObjectId objectId, const GameObjectPose& pose) override;
-
-public: // GameObjectFightListener IF.
-
-	void OnGameObjectDestroyed(const GameObject& sourceObject,
-		const GameObject& targetObject) override {}
-	void OnGameObjectFightStateChanged(const GameObject& object,
-		const GameObjectFightData& fightData) override;
+	void OnGameObjectsChanged(const GameObjectChangeSet& changes) override;
 };
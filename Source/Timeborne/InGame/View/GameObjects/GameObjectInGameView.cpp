@@ -11,6 +11,8 @@
 #include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
 #include <Timeborne/InGame/Model/Level.h>
 
+#include <algorithm>
+
 GameObjectInGameView::GameObjectInGameView()
 	: m_GameObjectRenderer(std::make_unique<GameObjectRenderer>())
 {
@@ -20,6 +22,11 @@ GameObjectInGameView::~GameObjectInGameView()
 {
 }
 
+void GameObjectInGameView::SetPoseInterpolationFactor(float factor)
+{
+	m_PoseInterpolationFactor = std::min(std::max(factor, 0.0f), 1.0f);
+}
+
 void GameObjectInGameView::OnLoading(const ComponentRenderContext& context)
 {
 	assert(m_Level->GetTerrainTree() != nullptr);
@@ -39,11 +46,37 @@ void GameObjectInGameView::OnLoading(const ComponentRenderContext& context)
 	m_VisibleObjectIds.Clear();
 	m_VisibleObjectRendererIndices.Clear();
 
-	m_GameState->GetGameObjects().AddExistenceListenerOnce(*this);
-	m_GameState->GetGameObjects().AddPoseListenerOnce(*this);
+	m_GameState->AddChangeListenerOnce(*this);
 }
 
-void GameObjectInGameView::OnGameObjectAdded(const GameObject& object)
+void GameObjectInGameView::OnGameObjectsChanged(const GameObjectChangeSet& changes)
+{
+	const auto& gameObjects = m_GameState->GetGameObjects().Get();
+
+	unsigned countRemoved = changes.RemovedIds.GetSize();
+	for (unsigned i = 0; i < countRemoved; i++)
+	{
+		RemoveObject(changes.RemovedIds[i]);
+	}
+
+	unsigned countAdded = changes.AddedIds.GetSize();
+	for (unsigned i = 0; i < countAdded; i++)
+	{
+		auto gIt = gameObjects.find(changes.AddedIds[i]);
+		assert(gIt != gameObjects.end());
+		AddObject(gIt->second);
+	}
+
+	unsigned countMoved = changes.MovedIds.GetSize();
+	for (unsigned i = 0; i < countMoved; i++)
+	{
+		auto gIt = gameObjects.find(changes.MovedIds[i]);
+		assert(gIt != gameObjects.end());
+		SetObjectPose(gIt->first, gIt->second.Data.Pose);
+	}
+}
+
+void GameObjectInGameView::AddObject(const GameObject& object)
 {
 	assert(m_GameCreationData != nullptr);
 
@@ -70,10 +103,10 @@ void GameObjectInGameView::OnGameObjectAdded(const GameObject& object)
 	auto transformedBox = m_GameObjectRenderer->GetTransformedBox(rendererIndex);
 	m_ObjectNodeMapping->AddObject(object.Id, transformedBox);
 
-	m_GameObjects[object.Id] = { object, rendererIndex, isDynamic };
+	m_GameObjects[object.Id] = { object, pose, m_GameState->GetTickCount(), rendererIndex, isDynamic };
 }
 
-void GameObjectInGameView::OnGameObjectRemoved(GameObjectId objectId)
+void GameObjectInGameView::RemoveObject(GameObjectId objectId)
 {
 	auto oIt = m_GameObjects.find(objectId);
 	assert(oIt != m_GameObjects.end());
@@ -91,12 +124,20 @@ void GameObjectInGameView::OnGameObjectRemoved(GameObjectId objectId)
 	m_GameObjects.erase(oIt);
 }
 
-void GameObjectInGameView::OnGameObjectPoseChanged(GameObjectId objectId, const GameObjectPose& pose)
+void GameObjectInGameView::SetObjectPose(GameObjectId objectId, const GameObjectPose& pose)
 {
 	auto oIt = m_GameObjects.find(objectId);
 	assert(oIt != m_GameObjects.end());
 
 	auto& objectData = oIt->second;
+
+	// If the object has already been moved in the current tick, the previous pose is kept.
+	auto tickCount = m_GameState->GetTickCount();
+	if (objectData.PoseTickCount != tickCount)
+	{
+		objectData.PreviousPose = objectData.Object.Data.Pose;
+		objectData.PoseTickCount = tickCount;
+	}
 	objectData.Object.Data.Pose = pose;
 
 	unsigned rendererIndex = objectData.RendererIndex;
@@ -146,13 +187,43 @@ void GameObjectInGameView::UpdateObjectPoseInRenderer(GameObjectRenderer& render
 	renderer.SetObjectPose(rendererIndex, positionInWorld, directionInWorld, upInWorld);
 }
 
+static glm::vec3 InterpolateDirection(const glm::vec3& previous, const glm::vec3& current, float factor)
+{
+	// Normalized linear interpolation, which is sufficient for the small per-tick rotations.
+	// Falling back to the current direction for opposite directions.
+	auto direction = glm::mix(previous, current, factor);
+	auto length = glm::length(direction);
+	return (length > 1e-3f) ? direction / length : current;
+}
+
+void GameObjectInGameView::UpdateObjectPoseInRenderer(GameObjectRenderer& renderer, unsigned rendererIndex,
+	const GameObjectPose& previousPose, const GameObjectPose& pose, float factor)
+{
+	auto positionInWorld = glm::mix(previousPose.GetWorldPosition(), pose.GetWorldPosition(), factor);
+	auto directionInWorld = InterpolateDirection(previousPose.GetWorldDirection(), pose.GetWorldDirection(), factor);
+	auto upInWorld = InterpolateDirection(previousPose.GetWorldUp(), pose.GetWorldUp(), factor);
+	renderer.SetObjectPose(rendererIndex, positionInWorld, directionInWorld, upInWorld);
+}
+
 void GameObjectInGameView::UpdateDynamicObjectPoses()
 {
 	auto& renderer = *m_GameObjectRenderer;
+	auto tickCount = m_GameState->GetTickCount();
 	for (auto objectId : m_DynamicObjectIds)
 	{
 		auto& gameObjectData = m_GameObjects[objectId];
-		UpdateObjectPoseInRenderer(renderer, gameObjectData.RendererIndex, gameObjectData.Object.Data.Pose);
+		const auto& pose = gameObjectData.Object.Data.Pose;
+
+		// Objects that haven't moved in the latest tick are shown in their current pose.
+		if (gameObjectData.PoseTickCount == tickCount && m_PoseInterpolationFactor < 1.0f)
+		{
+			UpdateObjectPoseInRenderer(renderer, gameObjectData.RendererIndex, gameObjectData.PreviousPose, pose,
+				m_PoseInterpolationFactor);
+		}
+		else
+		{
+			UpdateObjectPoseInRenderer(renderer, gameObjectData.RendererIndex, pose);
+		}
 	}
 }
 
@@ -18,8 +18,7 @@ class GameObjectRenderer;
 class GameObjectTerrainTreeNodeMapping;
 
 class GameObjectInGameView : public InGameViewComponent
-	, public GameObjectExistenceListener
-	, public GameObjectPoseListener
+	, public GameObjectChangeListener
 	, public GameObjectVisibilityProvider
 {
 private:
@@ -27,6 +26,12 @@ private:
 	struct GameObjectData
 	{
 		GameObject Object;
+
+		// The pose before the last change and the tick count of the game state when the pose was last changed.
+		// Only the objects that were moved in the latest tick are interpolated.
+		GameObjectPose PreviousPose;
+		uint32_t PoseTickCount;
+
 		unsigned RendererIndex;
 		bool IsDynamic;
 	};
@@ -43,8 +48,17 @@ private:
 	Core::SimpleTypeVectorU<GameObjectId> m_VisibleObjectIds;
 	Core::IndexVectorU m_VisibleObjectRendererIndices;
 
+	// The elapsed fraction of the current tick: 0 shows the previous tick's poses, 1 the latest tick's poses.
+	float m_PoseInterpolationFactor = 1.0f;
+
+	void AddObject(const GameObject& object);
+	void RemoveObject(GameObjectId objectId);
+	void SetObjectPose(GameObjectId objectId, const GameObjectPose& pose);
+
 	void UpdateObjectPoseInRenderer(GameObjectRenderer& renderer,
 		unsigned rendererIndex, const GameObjectPose& pose);
+	void UpdateObjectPoseInRenderer(GameObjectRenderer& renderer,
+		unsigned rendererIndex, const GameObjectPose& previousPose, const GameObjectPose& pose, float factor);
 	void UpdateDynamicObjectPoses();
 	void UpdateVisibleTerrainNodeIndices(
 		const ComponentPreUpdateContext& context,
@@ -58,6 +72,9 @@ public:
 	GameObjectInGameView();
 	~GameObjectInGameView() override;
 
+	// Must be set before the update. The factor is clamped to [0, 1].
+	void SetPoseInterpolationFactor(float factor);
+
 public: // InGameViewComponent IF.
 
 	void Initialize(const ComponentRenderContext& context) override;
@@ -71,14 +88,9 @@ protected:
 
 	void OnLoading(const ComponentRenderContext& context) override;
 
-public: // GameObjectExistenceListener IF.
-
-	void OnGameObjectAdded(const GameObject& object) override;
-	void OnGameObjectRemoved(GameObjectId objectId) override;
-
-public: // GameObjectPoseListener IF.
+public: // GameObjectChangeListener IF.
 
-	void OnGameObjectPoseChanged(GameObjectId objectId, const GameObjectPose& pose) override;
+	void OnGameObjectsChanged(const GameObjectChangeSet& changes) override;
 
 private: // Game object visibility provider IF.
 
@@ -31,7 +31,7 @@ void PathView::OnLoading(const ComponentRenderContext& context)
 
 	m_RendererIndices.clear();
 
-	m_GameState->GetRoutes().AddListenerOnce(*this);
+	m_GameState->AddChangeListenerOnce(*this);
 }
 
 void PathView::RenderContent(const ComponentRenderContext& context)
@@ -39,7 +39,7 @@ void PathView::RenderContent(const ComponentRenderContext& context)
 	m_LineRenderer->RenderContent(context);
 }
 
-void PathView::OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route)
+void PathView::AddLine(GameObjectId objectId, const GameObjectRoute& route)
 {
 	const glm::vec3 c_NormalPathColor(0.0, 1.0, 1.0);
 	const glm::vec3 c_SingleFieldPathColor(0.0, 0.5, 1.0);
@@ -78,7 +78,23 @@ void PathView::OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route)
 	m_RendererIndices[objectId] = lineIndex;
 }
 
-void PathView::OnRouteRemoved(GameObjectId objectId, RouteRemoveReason reason)
+void PathView::OnGameObjectsChanged(const GameObjectChangeSet& changes)
 {
-	m_LineRenderer->RemoveLine(m_RendererIndices[objectId]);
-}
+	const auto& routes = m_GameState->GetRoutes();
+
+	unsigned countChangedIds = changes.RouteChangedIds.GetSize();
+	for (unsigned i = 0; i < countChangedIds; i++)
+	{
+		auto objectId = changes.RouteChangedIds[i];
+
+		auto rIt = m_RendererIndices.find(objectId);
+		if (rIt != m_RendererIndices.end())
+		{
+			m_LineRenderer->RemoveLine(rIt->second);
+			m_RendererIndices.erase(rIt);
+		}
+
+		auto route = routes.GetRoute(objectId);
+		if (route != nullptr) AddLine(objectId, *route);
+	}
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <Timeborne/InGame/View/InGameViewComponent.h>
+#include <Timeborne/InGame/Model/GameObjects/GameObject.h>
 #include <Timeborne/InGame/Model/GameObjects/GameObjectRoute.h>
 
 #include <cstdint>
@@ -10,12 +11,14 @@
 class SimpleLineRenderer;
 
 class PathView : public InGameViewComponent
-               , public GameObjectRouteListener
+               , public GameObjectChangeListener
 {
 	std::unique_ptr<SimpleLineRenderer> m_LineRenderer;
 
 	Core::FastStdMap<GameObjectId, uint32_t> m_RendererIndices;
 
+	void AddLine(GameObjectId objectId, const GameObjectRoute& route);
+
 public:
 
 	PathView();
@@ -30,8 +33,7 @@ public: // InGameViewComponent IF.
 
 	void RenderContent(const ComponentRenderContext& context) override;
 
-public: // GameObjectRouteListener IF.
+public: // GameObjectChangeListener IF.
 
-	void OnRouteAdded(GameObjectId objectId, const GameObjectRoute& route) override;
-	void OnRouteRemoved(GameObjectId objectId, RouteRemoveReason reason) override;
+	void OnGameObjectsChanged(const GameObjectChangeSet& changes) override;
 };
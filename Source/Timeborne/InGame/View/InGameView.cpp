@@ -48,6 +48,12 @@ GameObjectVisibilityProvider& InGameView::GetGameObjectVisibilityProvider()
 	return *m_GameObjectView;
 }
 
+void InGameView::SetTickInterpolationFactor(float factor)
+{
+	assert(m_GameObjectView != nullptr);
+	m_GameObjectView->SetPoseInterpolationFactor(factor);
+}
+
 void InGameView::InitializeRendering(const ComponentRenderContext& context)
 {
 	m_RenderPassCB = CreateRenderPassCB(context.Device);
@@ -48,6 +48,9 @@ public:
 
 	GameObjectVisibilityProvider& GetGameObjectVisibilityProvider();
 
+	// The elapsed fraction of the current simulation tick for interpolating the game object poses.
+	void SetTickInterpolationFactor(float factor);
+
 	void InitializeRendering(const ComponentRenderContext& context);
 	void DestroyRendering();
 
@@ -91,9 +91,9 @@ void GameObjectLevelEditorModel::OnLevelLoaded(LevelDirtyFlags dirtyFlags)
 
 	if (HasFlag(dirtyFlags, LevelDirtyFlags::TerrainTree))
 	{
-		// The terrain tree that is loaded here is not complete, however it contains all data required for the
-		// functionality used here. See the comment TerrainTree.h for further details.
-		
+		// The terrain tree is kept up to date with the terrain height changes. See the comment TerrainTree.h for
+		// further details.
+
 		if (HasFlag(dirtyFlags, LevelDirtyFlags::Terrain))
 		{
 			m_ObjectToNodeMapping = std::make_unique<GroundObjectTerrainTreeNodeMapping>(terrainTree);
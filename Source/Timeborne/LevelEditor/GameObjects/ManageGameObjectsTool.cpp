@@ -4,6 +4,7 @@
 
 #include <Timeborne/GUI/NuklearHelper.h>
 #include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h>
 #include <Timeborne/LevelEditor/Terrain/TerrainLevelEditorView.h>
 #include <Timeborne/MainApplication.h>
 
@@ -143,7 +144,7 @@ void ManageGameObjectsTool::PreUpdate(const ComponentPreUpdateContext& context)
 	if (m_SelectionState == SelectionState::SelectingStart || m_SelectionState == SelectionState::SelectingEnd)
 	{
 		intersection = GetTerrainBlockIntersection(m_Camera, context.WindowSize, context.ContentSize,
-			m_Level->GetTerrain(), &m_Level->GetFieldHeightQuadtree(), glm::ivec2(1),
+			*m_Level->GetTerrainTree(), glm::ivec2(1),
 			m_CursorPositionInScreen);
 	}
 	bool hasIntersection = intersection.HasIntersection;
@@ -5,6 +5,7 @@
 #include <Timeborne/GUI/NuklearHelper.h>
 #include <Timeborne/InGame/Model/GameObjects/Prototype/GameObjectPrototype.h>
 #include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h>
 #include <Timeborne/MainApplication.h>
 
 using namespace EngineBuildingBlocks::Input;
@@ -115,7 +116,7 @@ void NewGameObjectsTool::PreUpdate(const ComponentPreUpdateContext& context)
 	if (m_Level != nullptr)
 	{
 		intersection = GetTerrainBlockIntersection(m_Camera, context.WindowSize, context.ContentSize,
-			m_Level->GetTerrain(), &m_Level->GetFieldHeightQuadtree(), glm::ivec2(1),
+			*m_Level->GetTerrainTree(), glm::ivec2(1),
 			m_NewGameObjectPositionInScreen);
 	}
 
@@ -3,6 +3,7 @@
 #include <Timeborne/LevelEditor/LevelEditor.h>
 
 #include <Timeborne/InGame/Model/Level.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainTree.h>
 #include <Timeborne/LevelEditor/GameObjects/GameObjectLevelEditorModel.h>
 #include <Timeborne/LevelEditor/GameObjects/GameObjectLevelEditorView.h>
 #include <Timeborne/LevelEditor/GameObjects/ManageGameObjectsTool.h>
@@ -56,6 +57,8 @@ void LevelEditor::InitializeMain(const ComponentInitContext& context)
 	auto application = context.Application;
 	assert(application != nullptr);
 
+	m_ThreadPool = &application->GetThreadPool();
+
 	auto keyHandler = application->GetKeyHandler();
 	auto mouseHandler = application->GetMouseHandler();
 
@@ -333,8 +336,8 @@ void LevelEditor::OnTerrainHeightsDirty(const glm::ivec2& changeStart, const glm
 {
 	assert(m_Level != nullptr);
 
-	m_Level->GetTerrain().UpdateSurfaceData(changeStart, changeEnd);
-	m_Level->GetFieldHeightQuadtree().Update(changeStart, changeEnd);
+	m_Level->GetTerrain().UpdateSurfaceData(changeStart, changeEnd, m_ThreadPool);
+	m_Level->GetTerrainTree()->UpdateTerrainHeights(changeStart, changeEnd);
 
 	for (auto component : m_Components)
 	{
@@ -381,14 +384,14 @@ void LevelEditor::SetRenderingTerrainWithWireframe(bool value)
 	m_TerrainLevelEditorView->SetRenderingTerrainWithWireframe(value);
 }
 
-void LevelEditor::CreateNewLevel(MainApplication* application,
+void LevelEditor::CreateNewLevel(Core::ThreadPool* threadPool,
 	const char* levelName, const glm::uvec2& size)
 {
 	LevelSetupData levelSetupData;
 	levelSetupData.Name = levelName;
 	levelSetupData.Size = size;
 	m_Level = std::make_unique<Level>(levelSetupData);
-	m_Level->CreateTerrainTree(application);
+	m_Level->CreateTerrainTree(threadPool);
 	OnLevelLoaded(LevelEditorComponent::LevelDirtyFlags::All);
 	Logger::Log([&](Logger::Stream& ss) { ss << "Level '" << levelSetupData.Name << "' of size "
 		<< levelSetupData.Size.x << "x" << levelSetupData.Size.y << "' has been created."; }, LogSeverity::Info);
@@ -403,7 +406,7 @@ void LevelEditor::LoadLevel(const ComponentPostUpdateContext& context, const std
 	if (Core::FileExists(Level::GetPath(pathHandler, levelName)))
 	{
 		m_Level = std::make_unique<Level>();
-		m_Level->Load(pathHandler, levelName, isForcingLoadedLevelRecomputations);
+		m_Level->Load(pathHandler, levelName, isForcingLoadedLevelRecomputations, context.ThreadPool);
 		OnLevelLoaded(LevelEditorComponent::LevelDirtyFlags::All);
 		LoadLevelMetadata(pathHandler, levelName);
 		Logger::Log([&](Logger::Stream& ss) { ss << "Level '" << levelName << "' has been loaded in LevelEditor."; }, LogSeverity::Info);
@@ -422,7 +425,7 @@ void LevelEditor::SaveLevel(const ComponentPostUpdateContext& context, const std
 
 	if (m_Level != nullptr)
 	{
-		m_Level->CreateTerrainTree(context.Application);
+		m_Level->CreateTerrainTree(context.ThreadPool);
 		m_Level->Save(pathHandler, levelName);
 		OnLevelLoaded(LevelEditorComponent::LevelDirtyFlags::TerrainTree);
 		SaveLevelMetadata(pathHandler, levelName);
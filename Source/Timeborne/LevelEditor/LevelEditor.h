@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <Timeborne/Declarations/CoreDeclarations.h>
 #include <Timeborne/Declarations/EngineBuildingBlocksDeclarations.h>
 #include <Timeborne/LevelEditor/LevelEditorComponent.h>
 
@@ -12,13 +13,14 @@
 class GameObjectLevelEditorModel;
 class GameObjectLevelEditorView;
 class Level;
-class MainApplication;
 class TerrainLevelEditorView;
 
 class LevelEditor
 {
 	std::unique_ptr<Level> m_Level;
 
+	Core::ThreadPool* m_ThreadPool = nullptr;
+
 	void OnLevelLoaded(LevelEditorComponent::LevelDirtyFlags dirtyFlags);
 
 private: // Load level.
@@ -97,7 +99,7 @@ public:
 	bool IsRenderingTerrainWithWireframe() const;
 	void SetRenderingTerrainWithWireframe(bool value);
 
-	void CreateNewLevel(MainApplication* application,
+	void CreateNewLevel(Core::ThreadPool* threadPool,
 		const char* levelName, const glm::uvec2& size);
 	void LoadLevel(const ComponentPostUpdateContext& context,
 		const std::string& levelName, bool isForcingLoadedLevelRecomputations);
@@ -4,6 +4,7 @@
 
 #include <Timeborne/GUI/NuklearHelper.h>
 #include <Timeborne/InGame/Model/Terrain/Terrain.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h>
 #include <Timeborne/InGame/Model/Level.h>
 #include <Timeborne/LevelEditor/Terrain/TerrainFieldBlockHeightIterator.h>
 #include <Timeborne/LevelEditor/Terrain/TerrainLevelEditorView.h>
@@ -125,8 +126,8 @@ void TerrainCopyTool::PreUpdate(const ComponentPreUpdateContext& context)
 	auto& mouseHandler = *m_Application->GetMouseHandler();
 
 	auto GetTerrainBlockIntersectionL = [&](const glm::ivec2& blockSize) {
-		return GetTerrainBlockIntersection(m_Camera, context.WindowSize, context.ContentSize, terrain,
-			&m_Level->GetFieldHeightQuadtree(), blockSize, mouseHandler.GetMouseCursorPosition());
+		return GetTerrainBlockIntersection(m_Camera, context.WindowSize, context.ContentSize,
+			*m_Level->GetTerrainTree(), blockSize, mouseHandler.GetMouseCursorPosition());
 	};
 
 	bool resetTarget = false;
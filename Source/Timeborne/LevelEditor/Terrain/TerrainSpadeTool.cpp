@@ -85,7 +85,7 @@ void TerrainSpadeTool::PreUpdate(const ComponentPreUpdateContext& context)
 		}
 
 		m_Intersection = GetTerrainBlockIntersection(m_Camera, context.WindowSize, context.ContentSize,
-			m_Level->GetTerrain(), &m_Level->GetFieldHeightQuadtree(), blockSize,
+			*m_Level->GetTerrainTree(), blockSize,
 			mouseHandler.GetMouseCursorPosition());
 
 		m_EditedFieldIndices.Clear();
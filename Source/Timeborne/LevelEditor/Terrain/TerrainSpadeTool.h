@@ -2,7 +2,7 @@
 
 #pragma once
 
-#include <Timeborne/InGame/Model/Terrain/FieldHeightQuadTree.h>
+#include <Timeborne/InGame/Model/Terrain/TerrainBlockIntersection.h>
 #include <Timeborne/LevelEditor/Terrain/TerrainEditing.h>
 #include <Timeborne/LevelEditor/LevelEditorComponent.h>
 
@@ -273,6 +273,7 @@ void MainApplication::DerivedPostUpdate(EngineBuildingBlocks::PostUpdateContext&
 
 	ComponentPostUpdateContext puContext;
 	puContext.Application = this;
+	puContext.ThreadPool = &m_ThreadPool;
 	puContext.IsFPSRefreshed = context.IsFPSRefreshed;
 	puContext.PathHandler = &m_PathHandler;
 	puContext.WindowHandle = m_Window.GetHandle();
@@ -432,3 +433,8 @@ EngineBuildingBlocks::Graphics::ModelLoader& MainApplication::GetModelLoader()
 {
 	return m_ModelLoader;
 }
+
+Core::ThreadPool& MainApplication::GetThreadPool()
+{
+	return m_ThreadPool;
+}
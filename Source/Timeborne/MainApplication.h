@@ -104,6 +104,7 @@ public: // ILoggerListener
 public: // Interface for contained applications.
 
 	EngineBuildingBlocks::Graphics::ModelLoader& GetModelLoader();
+	Core::ThreadPool& GetThreadPool();
 
 public: // Interface for user.
 
@@ -4,6 +4,8 @@
 
 #include <EngineBuildingBlocks/Math/GLM.h>
 
+#include <cstdint>
+
 struct Sqrt2IntegerRingExtender
 {
 	static constexpr int Sqr = 2;
@@ -36,24 +38,41 @@ struct SqrtExtendedIntegerRing
 		return !(*this == other);
 	}
 
+	// Returns the sign of the represented value without floating-point conversion. Since the extension
+	// is irrational, the value is zero only if both components are zero.
+	inline constexpr int GetSign() const
+	{
+		int integerSign = (Integer > 0) - (Integer < 0);
+		int extSign = (Ext > 0) - (Ext < 0);
+		if (integerSign == extSign || extSign == 0) return integerSign;
+		if (integerSign == 0) return extSign;
+
+		// The components have different signs: comparing their squares.
+		int64_t integerSqr = (int64_t)Integer * (int64_t)Integer;
+		int64_t extSqr = (int64_t)Ext * (int64_t)Ext * (int64_t)Extender::Sqr;
+		return (integerSqr > extSqr) ? integerSign : extSign;
+	}
+
+	// The comparisons are exact, so that they work the same way on all platforms.
+
 	inline constexpr bool operator<(const SqrtExtendedIntegerRing& other) const
 	{
-		return ((float)* this) < ((float)other);
+		return (*this - other).GetSign() < 0;
 	}
 
 	inline constexpr bool operator<=(const SqrtExtendedIntegerRing& other) const
 	{
-		return ((float)* this) <= ((float)other);
+		return (*this - other).GetSign() <= 0;
 	}
 
 	inline constexpr bool operator>(const SqrtExtendedIntegerRing& other) const
 	{
-		return ((float)* this) > ((float)other);
+		return (*this - other).GetSign() > 0;
 	}
 
 	inline constexpr bool operator>=(const SqrtExtendedIntegerRing& other) const
 	{
-		return ((float)* this) >= ((float)other);
+		return (*this - other).GetSign() >= 0;
 	}
 
 	inline constexpr SqrtExtendedIntegerRing operator+(const SqrtExtendedIntegerRing& other) const
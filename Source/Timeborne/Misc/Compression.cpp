@@ -0,0 +1,151 @@
+// Timeborne/Misc/Compression.cpp
+
+#include <Timeborne/Misc/Compression.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+constexpr size_t c_LZMinMatchLength = 4;
+constexpr size_t c_LZMaxOffset = 0xffff;
+constexpr size_t c_LZMaxTokenLength = 15;
+constexpr size_t c_LZMaxExpansionPerByte = 255; // An extra length byte.
+constexpr unsigned c_LZHashBits = 14;
+constexpr size_t c_LZInvalidPosition = ~(size_t)0;
+
+inline uint32_t ReadUInt32LZ(const unsigned char* data)
+{
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+inline uint32_t HashLZ(uint32_t value)
+{
+	return (value * 2654435761U) >> (32 - c_LZHashBits);
+}
+
+inline void WriteExtraLengthLZ(Core::ByteVector& result, size_t length)
+{
+	for (; length >= 255; length -= 255) result.PushBack(255);
+	result.PushBack((unsigned char)length);
+}
+
+// Fails if the data ends or the length exceeds the maximum length, which also prevents overflow.
+inline bool ReadExtraLengthLZ(const unsigned char*& data, const unsigned char* end, size_t maxLength,
+	size_t& length)
+{
+	unsigned char value;
+	do
+	{
+		if (data == end) return false;
+		value = *(data++);
+		length += value;
+		if (length > maxLength) return false;
+	} while (value == 255);
+	return true;
+}
+
+inline void WriteLiteralsLZ(Core::ByteVector& result, const unsigned char* literals, size_t length)
+{
+	auto offset = result.GetSize();
+	result.Resize(offset + length);
+	std::memcpy(result.GetArray() + offset, literals, length);
+}
+
+void CompressLZ(const unsigned char* data, size_t size, Core::ByteVector& result)
+{
+	std::vector<size_t> hashTable((size_t)1 << c_LZHashBits, c_LZInvalidPosition);
+
+	size_t literalStart = 0;
+	size_t position = 0;
+	while (position + c_LZMinMatchLength <= size)
+	{
+		auto value = ReadUInt32LZ(data + position);
+		auto& hashEntry = hashTable[HashLZ(value)];
+		auto candidate = hashEntry;
+		hashEntry = position;
+
+		if (candidate == c_LZInvalidPosition || position - candidate > c_LZMaxOffset
+			|| ReadUInt32LZ(data + candidate) != value)
+		{
+			position++;
+			continue;
+		}
+
+		auto matchLength = c_LZMinMatchLength;
+		while (position + matchLength < size && data[candidate + matchLength] == data[position + matchLength])
+		{
+			matchLength++;
+		}
+
+		auto literalLength = position - literalStart;
+		auto matchCode = matchLength - c_LZMinMatchLength;
+		auto offset = position - candidate;
+
+		result.PushBack((unsigned char)((std::min(literalLength, c_LZMaxTokenLength) << 4)
+			| std::min(matchCode, c_LZMaxTokenLength)));
+		if (literalLength >= c_LZMaxTokenLength) WriteExtraLengthLZ(result, literalLength - c_LZMaxTokenLength);
+		WriteLiteralsLZ(result, data + literalStart, literalLength);
+		result.PushBack((unsigned char)(offset & 0xff));
+		result.PushBack((unsigned char)(offset >> 8));
+		if (matchCode >= c_LZMaxTokenLength) WriteExtraLengthLZ(result, matchCode - c_LZMaxTokenLength);
+
+		position += matchLength;
+		literalStart = position;
+	}
+
+	// The last sequence.
+	auto literalLength = size - literalStart;
+	result.PushBack((unsigned char)(std::min(literalLength, c_LZMaxTokenLength) << 4));
+	if (literalLength >= c_LZMaxTokenLength) WriteExtraLengthLZ(result, literalLength - c_LZMaxTokenLength);
+	WriteLiteralsLZ(result, data + literalStart, literalLength);
+}
+
+size_t GetMaxDecompressedSizeLZ(size_t compressedSize)
+{
+	if (compressedSize > ~(size_t)0 / c_LZMaxExpansionPerByte) return ~(size_t)0;
+	return compressedSize * c_LZMaxExpansionPerByte;
+}
+
+bool DecompressLZ(const unsigned char* data, size_t size, unsigned char* result, size_t resultSize)
+{
+	auto end = data + size;
+	size_t resultPosition = 0;
+	while (data < end)
+	{
+		auto token = *(data++);
+
+		size_t literalLength = token >> 4;
+		if (literalLength == c_LZMaxTokenLength
+			&& !ReadExtraLengthLZ(data, end, resultSize - resultPosition, literalLength)) return false;
+		if (literalLength > (size_t)(end - data) || literalLength > resultSize - resultPosition) return false;
+		std::memcpy(result + resultPosition, data, literalLength);
+		data += literalLength;
+		resultPosition += literalLength;
+
+		// The last sequence doesn't have a match.
+		if (data == end) break;
+
+		if (end - data < 2) return false;
+		size_t offset = (size_t)data[0] | ((size_t)data[1] << 8);
+		data += 2;
+
+		size_t matchLength = token & 0x0f;
+		if (matchLength == c_LZMaxTokenLength
+			&& !ReadExtraLengthLZ(data, end, resultSize - resultPosition, matchLength)) return false;
+		matchLength += c_LZMinMatchLength;
+
+		if (offset == 0 || offset > resultPosition || matchLength > resultSize - resultPosition) return false;
+
+		// The match can overlap with the output.
+		auto source = result + resultPosition - offset;
+		for (size_t i = 0; i < matchLength; i++)
+		{
+			result[resultPosition + i] = source[i];
+		}
+		resultPosition += matchLength;
+	}
+	return resultPosition == resultSize;
+}
@@ -0,0 +1,24 @@
+// Timeborne/Misc/Compression.h
+
+#pragma once
+
+#include <Core/DataStructures/SimpleTypeVector.hpp>
+
+#include <cstddef>
+
+// Fast byte oriented LZ77 compression without entropy coding. The serialized game states contain many repeated
+// byte sequences (ids, flags, zero bytes), which are compressed well enough this way.
+//
+// Format: sequences of a token (literal length: high 4 bits, match length - 4: low 4 bits), extra literal length
+// bytes, literals, 2 byte match offset, extra match length bytes. The last sequence only contains literals.
+
+// Appends the compressed data to the result.
+void CompressLZ(const unsigned char* data, size_t size, Core::ByteVector& result);
+
+// The upper bound of the decompressed size of valid compressed data. Can be used for validating a stored
+// decompressed size before allocating the result.
+size_t GetMaxDecompressedSizeLZ(size_t compressedSize);
+
+// Returns false if the data is corrupted or its decompressed size differs from the result size.
+// The input is not trusted: all reads and writes are bounds checked.
+bool DecompressLZ(const unsigned char* data, size_t size, unsigned char* result, size_t resultSize);
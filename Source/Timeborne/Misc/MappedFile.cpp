@@ -0,0 +1,113 @@
+// Timeborne/Misc/MappedFile.cpp
+
+#include <Timeborne/Misc/MappedFile.h>
+
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+#if defined(_WIN32)
+
+	auto fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open file for mapping: '" + filePath + "'.");
+	}
+	m_FileHandle = fileHandle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		Close();
+		throw std::runtime_error("Failed to get the size of file: '" + filePath + "'.");
+	}
+	m_Size = (size_t)fileSize.QuadPart;
+
+	// Empty files cannot be mapped.
+	if (m_Size == 0) return;
+
+	m_MappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_MappingHandle != nullptr)
+	{
+		m_Data = (const unsigned char*)MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (m_Data == nullptr)
+	{
+		Close();
+		throw std::runtime_error("Failed to map file: '" + filePath + "'.");
+	}
+
+#else
+
+	int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		throw std::runtime_error("Failed to open file for mapping: '" + filePath + "'.");
+	}
+
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0)
+	{
+		close(fileDescriptor);
+		throw std::runtime_error("Failed to get the size of file: '" + filePath + "'.");
+	}
+	m_Size = (size_t)fileStat.st_size;
+
+	// Empty files cannot be mapped.
+	if (m_Size > 0)
+	{
+		auto data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+		if (data == MAP_FAILED)
+		{
+			close(fileDescriptor);
+			throw std::runtime_error("Failed to map file: '" + filePath + "'.");
+		}
+		m_Data = (const unsigned char*)data;
+	}
+
+	// The mapping remains valid after closing the file.
+	close(fileDescriptor);
+
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (m_Data != nullptr) UnmapViewOfFile(m_Data);
+	if (m_MappingHandle != nullptr) CloseHandle(m_MappingHandle);
+	if (m_FileHandle != nullptr) CloseHandle(m_FileHandle);
+	m_MappingHandle = nullptr;
+	m_FileHandle = nullptr;
+#else
+	if (m_Data != nullptr) munmap((void*)m_Data, m_Size);
+#endif
+	m_Data = nullptr;
+	m_Size = 0;
+}
+
+const unsigned char* MappedFile::GetData() const
+{
+	return m_Data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return m_Size;
+}
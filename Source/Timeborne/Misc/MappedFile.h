@@ -0,0 +1,32 @@
+// Timeborne/Misc/MappedFile.h
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The file cannot be written while it is mapped.
+class MappedFile
+{
+	const unsigned char* m_Data = nullptr;
+	size_t m_Size = 0;
+
+#if defined(_WIN32)
+	void* m_FileHandle = nullptr;
+	void* m_MappingHandle = nullptr;
+#endif
+
+	void Close();
+
+public:
+
+	// Throws std::runtime_error if the file cannot be mapped.
+	explicit MappedFile(const std::string& filePath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* GetData() const;
+	size_t GetSize() const;
+};
@@ -0,0 +1,93 @@
+// Timeborne/Profiler.cpp
+
+#include <Timeborne/Profiler.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+thread_local Profiler::ThreadBuffer* Profiler::s_ThreadBuffer = nullptr;
+thread_local Profiler::ThreadBufferOwner Profiler::s_ThreadBufferOwner;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+Profiler* Profiler::GetInstance()
+{
+	static Profiler instance;
+	return &instance;
+}
+
+Profiler::Profiler()
+	: m_Enabled(false)
+	, m_StartTime(Clock::now())
+{
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+	m_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer& Profiler::CreateThreadBuffer()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto buffer = std::make_unique<ThreadBuffer>();
+	buffer->ThreadIndex = m_CountCreatedThreadBuffers++;
+	buffer->Zones.resize(c_CountZonesPerThread);
+	s_ThreadBuffer = buffer.get();
+	s_ThreadBufferOwner.Buffer = buffer.get();
+	m_ThreadBuffers.push_back(std::move(buffer));
+	return *s_ThreadBuffer;
+}
+
+void Profiler::ReleaseThreadBuffer(ThreadBuffer* buffer)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = std::find_if(m_ThreadBuffers.begin(), m_ThreadBuffers.end(),
+		[buffer](const std::unique_ptr<ThreadBuffer>& threadBuffer) { return threadBuffer.get() == buffer; });
+	if (it != m_ThreadBuffers.end()) m_ThreadBuffers.erase(it);
+}
+
+Profiler::ThreadBufferOwner::~ThreadBufferOwner()
+{
+	if (Buffer != nullptr)
+	{
+		s_ThreadBuffer = nullptr;
+		GetInstance()->ReleaseThreadBuffer(Buffer);
+	}
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filePath) const
+{
+	std::ofstream os(filePath);
+	if (!os) return false;
+
+	auto toMicroseconds = [this](Clock::time_point time) {
+		return std::chrono::duration<double, std::micro>(time - m_StartTime).count(); };
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	os << std::fixed << std::setprecision(3);
+	os << "{\"traceEvents\":[";
+	bool isFirst = true;
+	for (auto& buffer : m_ThreadBuffers)
+	{
+		// Writing from the oldest available zone.
+		auto countZones = std::min(buffer->CountRecordedZones, (uint64_t)c_CountZonesPerThread);
+		auto startIndex = buffer->CountRecordedZones - countZones;
+		for (uint64_t i = startIndex; i < buffer->CountRecordedZones; i++)
+		{
+			auto& zone = buffer->Zones[i % c_CountZonesPerThread];
+			auto startTime = toMicroseconds(zone.StartTime);
+			auto duration = toMicroseconds(zone.EndTime) - startTime;
+
+			if (!isFirst) os << ",";
+			isFirst = false;
+			os << "\n{\"name\":\"" << zone.Name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->ThreadIndex
+				<< ",\"ts\":" << startTime << ",\"dur\":" << duration << "}";
+		}
+	}
+	os << "\n]}\n";
+
+	return (bool)os;
+}
@@ -0,0 +1,109 @@
+// Timeborne/Profiler.h
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Low overhead profiler for scoped zones. The zones are recorded into ring buffers, one per thread,
+// so the latest zones are always available and can be written as a Chrome trace on demand.
+// The profiler is disabled by default. The buffer of a thread is released when the thread exits,
+// so the zones of the exited threads are not written.
+class Profiler
+{
+public:
+
+	using Clock = std::chrono::steady_clock;
+
+	// The name must be a string literal or must outlive the profiler.
+	struct Zone
+	{
+		const char* Name;
+		Clock::time_point StartTime;
+		Clock::time_point EndTime;
+	};
+
+	static constexpr uint32_t c_CountZonesPerThread = 1 << 16;
+
+private:
+
+	struct ThreadBuffer
+	{
+		uint32_t ThreadIndex;
+		uint64_t CountRecordedZones = 0;
+		std::vector<Zone> Zones;
+	};
+
+	std::atomic<bool> m_Enabled;
+	Clock::time_point m_StartTime;
+
+	std::vector<std::unique_ptr<ThreadBuffer>> m_ThreadBuffers;
+	uint32_t m_CountCreatedThreadBuffers = 0;
+	mutable std::mutex m_Mutex;
+
+	// Releases the buffer of the thread on thread exit.
+	struct ThreadBufferOwner
+	{
+		ThreadBuffer* Buffer = nullptr;
+
+		~ThreadBufferOwner();
+	};
+
+	// Only the trivial pointer is accessed when recording a zone.
+	static thread_local ThreadBuffer* s_ThreadBuffer;
+	static thread_local ThreadBufferOwner s_ThreadBufferOwner;
+
+	ThreadBuffer& CreateThreadBuffer();
+	void ReleaseThreadBuffer(ThreadBuffer* buffer);
+
+public:
+
+	static Profiler* GetInstance();
+
+	Profiler();
+
+	bool IsEnabled() const
+	{
+		return m_Enabled.load(std::memory_order_relaxed);
+	}
+
+	void SetEnabled(bool enabled);
+
+	void AddZone(const char* name, Clock::time_point startTime, Clock::time_point endTime)
+	{
+		auto buffer = s_ThreadBuffer;
+		if (buffer == nullptr) buffer = &CreateThreadBuffer();
+		buffer->Zones[buffer->CountRecordedZones++ % c_CountZonesPerThread] = { name, startTime, endTime };
+	}
+
+	// Writes the recorded zones in the Chrome trace event format (chrome://tracing, Perfetto).
+	// No zones must be recorded by the other threads during writing. Returns false if the file cannot be written.
+	bool WriteChromeTrace(const std::string& filePath) const;
+};
+
+class ProfilerZone
+{
+	const char* m_Name;
+	Profiler::Clock::time_point m_StartTime;
+
+public:
+
+	explicit ProfilerZone(const char* name)
+		: m_Name(Profiler::GetInstance()->IsEnabled() ? name : nullptr)
+	{
+		if (m_Name != nullptr) m_StartTime = Profiler::Clock::now();
+	}
+
+	~ProfilerZone()
+	{
+		if (m_Name != nullptr) Profiler::GetInstance()->AddZone(m_Name, m_StartTime, Profiler::Clock::now());
+	}
+
+	ProfilerZone(const ProfilerZone&) = delete;
+	ProfilerZone& operator=(const ProfilerZone&) = delete;
+};
@@ -23,6 +23,8 @@ InGameScreen::InGameScreen()
 
 InGameScreen::~InGameScreen()
 {
+	// The save callback references the screen.
+	m_InGame->WaitForSaveCompletion();
 }
 
 void InGameScreen::Reset()
@@ -90,6 +92,9 @@ void InGameScreen::Enter(const ComponentRenderContext& context)
 
 void InGameScreen::Exit()
 {
+	assert(m_Application != nullptr && m_Application->GetPathHandler() != nullptr);
+	m_InGame->WaitForSaveCompletion();
+	m_InGame->SaveReplay(*m_Application->GetPathHandler());
 }
 
 bool InGameScreen::HasLevel(const char* levelName) const
@@ -389,9 +394,20 @@ void InGameScreen::SaveGame()
 {
 	assert(m_Application != nullptr && m_Application->GetPathHandler() != nullptr);
 
-	m_InGame->SaveGame(m_SaveGameGUIControl->GetFileName().c_str(), *m_Application->GetPathHandler());
-
-	m_SaveTime = std::chrono::steady_clock::now();
+	auto fileName = m_SaveGameGUIControl->GetFileName();
+	m_SaveGameGUIControl->OnSaveStarted();
+	m_InGame->SaveGame(fileName.c_str(), *m_Application->GetPathHandler(), [this, fileName](bool success) {
+		m_SaveGameGUIControl->OnSaveCompleted(fileName, success);
+		if (success)
+		{
+			m_SaveTime = std::chrono::steady_clock::now();
+		}
+		else
+		{
+			Logger::Log([&](Logger::Stream& ss) { ss << "Failed to save the game '" << fileName << "'."; },
+				LogSeverity::Warning, LogFlags::AddMessageBox);
+		}
+	});
 }
 
 void InGameScreen::CreateEndDialog(const ComponentRenderContext& context)
@@ -322,7 +322,7 @@ void LevelEditorScreen::CreateNewLevelGUI(const ComponentRenderContext& context)
 
 	if (isCreatingNewLevel)
 	{
-		m_LevelEditor->CreateNewLevel(context.Application, m_NewLevelName->GetText().c_str(),
+		m_LevelEditor->CreateNewLevel(context.ThreadPool, m_NewLevelName->GetText().c_str(),
 			glm::uvec2(1 << m_NewLevelSizeExp.x, 1 << m_NewLevelSizeExp.y));
 	}
 }
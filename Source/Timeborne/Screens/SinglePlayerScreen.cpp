@@ -245,7 +245,7 @@ void SinglePlayerScreen::LoadNewLevel()
 	if (inGameScreen->HasLevel(levelName.c_str()))
 	{
 		m_NewGameLevel = std::make_unique<Level>();
-		m_NewGameLevel->Load(*m_Application->GetPathHandler(), levelName, false);
+		m_NewGameLevel->Load(*m_Application->GetPathHandler(), levelName, false, &m_Application->GetThreadPool());
 		
 		SetupNewGameData(levelName);
 	}
@@ -1,13 +1,52 @@
 // Timeborne.cpp : Defines the entry point for the console application.
 
+#include <Timeborne/InGame/Replay/ReplayRunner.h>
+#include <Timeborne/Logger.h>
 #include <Timeborne/MainApplication.h>
+#include <Timeborne/Profiler.h>
+
+#include <cstring>
+
+// Usage: Timeborne --profiler-trace <Chrome trace file path>
+// The profiler is enabled and the trace is written when the application exits.
+std::string GetProfilerTracePath(int argc, char *argv[])
+{
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--profiler-trace") == 0) return argv[i + 1];
+	}
+	return {};
+}
+
+void WriteProfilerTrace(const std::string& filePath)
+{
+	bool success = Profiler::GetInstance()->WriteChromeTrace(filePath);
+	Logger::Log([&](Logger::Stream& stream) {
+		stream << (success ? "Profiler trace has been written: " : "Failed to write the profiler trace: ")
+			<< filePath; }, LogSeverity::Info);
+}
 
 int main(int argc, char *argv[])
 {
 	try
 	{
+		// The replay runner doesn't create the application.
+		ReplayRunner::Settings replaySettings;
+		if (ReplayRunner::ParseCommandLine(argc, argv, replaySettings))
+		{
+			ReplayRunner replayRunner(replaySettings);
+			return replayRunner.Run();
+		}
+
+		auto profilerTracePath = GetProfilerTracePath(argc, argv);
+		Profiler::GetInstance()->SetEnabled(!profilerTracePath.empty());
+
 		MainApplication application(argc, argv);
-		return application.Run();
+		auto result = application.Run();
+
+		// The threads of the application are idle, but not exited yet, so their zones are written.
+		if (!profilerTracePath.empty()) WriteProfilerTrace(profilerTracePath);
+		return result;
 	}
 	catch (const std::exception& ex)
 	{
@@ -0,0 +1,22 @@
+// TimeborneBenchmark/main.cpp : Defines the entry point for the headless simulation benchmark.
+
+#include <Timeborne/InGame/SimulationBenchmark.h>
+
+#include <EngineBuildingBlocks/ErrorHandling.h>
+
+int main(int argc, char *argv[])
+{
+	try
+	{
+		SimulationBenchmark::Settings settings;
+		SimulationBenchmark::ParseCommandLine(argc, argv, settings);
+
+		SimulationBenchmark benchmark(settings);
+		return benchmark.Run();
+	}
+	catch (const std::exception& ex)
+	{
+		EngineBuildingBlocks::PrintException(ex);
+	}
+	return 2;
+}